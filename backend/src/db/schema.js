@@ -106,6 +106,66 @@ class DatabaseSchema {
       );
     `);
 
+    // Slot inventory table - which changer slots hold a disc, as reported by
+    // the ESP32. loaded/known are hex bitsets, bit (slot - 1) % 8 of byte
+    // (slot - 1) / 8; a slot not in known is unknown.
+    this.db.exec(`
+      CREATE TABLE IF NOT EXISTS slot_inventory (
+        bus INTEGER NOT NULL DEFAULT 0,
+        player INTEGER NOT NULL,
+        loaded TEXT NOT NULL,
+        known TEXT NOT NULL,
+        updated_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+        PRIMARY KEY (bus, player)
+      );
+    `);
+
+    // Slot scan table - per-slot results of the ESP32's full inventory scan:
+    // whether it held a disc, the track it reported first and how long it
+    // took to load.
+    this.db.exec(`
+      CREATE TABLE IF NOT EXISTS slot_scan (
+        bus INTEGER NOT NULL DEFAULT 0,
+        player INTEGER NOT NULL,
+        slot INTEGER NOT NULL,
+        loaded INTEGER NOT NULL,
+        first_track INTEGER,
+        load_ms INTEGER,
+        scanned_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+        PRIMARY KEY (bus, player, slot)
+      );
+    `);
+
+    // Seek model table - disc load times per changer by carousel distance, as
+    // measured by the ESP32. mean_ms/samples are JSON arrays indexed by
+    // bucket: 0 is the same disc, bucket b covers distances
+    // (b - 1) * bucket_slots + 1 .. b * bucket_slots. base_ms/ms_per_slot is
+    // the line fitted through them (null until there are two buckets).
+    this.db.exec(`
+      CREATE TABLE IF NOT EXISTS seek_model (
+        bus INTEGER NOT NULL DEFAULT 0,
+        player INTEGER NOT NULL,
+        bucket_slots INTEGER NOT NULL,
+        mean_ms TEXT NOT NULL,
+        samples TEXT NOT NULL,
+        base_ms REAL,
+        ms_per_slot REAL,
+        updated_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+        PRIMARY KEY (bus, player)
+      );
+    `);
+
+    // Playlist table - the disc queue last sent to each bus. entries is a
+    // JSON array of { player, disc, track, tracks } that the ESP32 fetches
+    // and plays through on its own.
+    this.db.exec(`
+      CREATE TABLE IF NOT EXISTS playlist (
+        bus INTEGER PRIMARY KEY,
+        entries TEXT NOT NULL,
+        updated_at DATETIME DEFAULT CURRENT_TIMESTAMP
+      );
+    `);
+
     // Settings table - stores app configuration like Last.fm session
     this.db.exec(`
       CREATE TABLE IF NOT EXISTS settings (
@@ -148,6 +208,31 @@ class DatabaseSchema {
       // Column already exists, ignore
     }
 
+    // Migration: Add bus columns for controllers serving several S-Link buses
+    try {
+      this.db.exec('ALTER TABLE playback_state ADD COLUMN current_bus INTEGER DEFAULT 0');
+      console.log('✓ Added current_bus column to playback_state table');
+    } catch (e) {
+      // Column already exists, ignore
+    }
+    try {
+      this.db.exec('ALTER TABLE command_queue ADD COLUMN bus INTEGER DEFAULT 0');
+      console.log('✓ Added bus column to command_queue table');
+    } catch (e) {
+      // Column already exists, ignore
+    }
+
+    // Migration: Add delivery and result columns for confirmed commands
+    for (const [column, type] of [['delivered_at', 'DATETIME'], ['success', 'INTEGER'],
+                                  ['latency_ms', 'INTEGER'], ['result', 'TEXT']]) {
+      try {
+        this.db.exec(`ALTER TABLE command_queue ADD COLUMN ${column} ${type}`);
+        console.log(`✓ Added ${column} column to command_queue table`);
+      } catch (e) {
+        // Column already exists, ignore
+      }
+    }
+
     console.log('✓ Database schema initialized');
   }
 
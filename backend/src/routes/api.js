@@ -10,6 +10,59 @@ let db = null;
 let musicbrainz = null;
 let lastfm = null;
 
+// Latest playback position reported by the ESP32 (not persisted)
+let lastPosition = null;
+
+// Player presence reported by the ESP32, keyed "bus:player" (not persisted)
+const PRESENCE_STATES = ['unknown', 'online', 'offline', 'powered-off'];
+const presence = new Map();
+
+function isPlayerOff(bus, player) {
+  const entry = presence.get(`${bus}:${player}`);
+  return !!entry && (entry.state === 'offline' || entry.state === 'powered-off');
+}
+
+// Slot inventory bitsets from the ESP32: one bit per slot, hex encoded
+const INVENTORY_SLOTS = 300;
+const INVENTORY_HEX_LENGTH = Math.ceil(INVENTORY_SLOTS / 8) * 2;
+
+function slotBit(hex, slot) {
+  const byte = parseInt(hex.substr(Math.floor((slot - 1) / 8) * 2, 2), 16);
+  return (byte >> ((slot - 1) % 8)) & 1;
+}
+
+// 'loaded', 'empty' or 'unknown' for a slot given that player's inventory row
+function slotState(inventory, slot) {
+  if (!inventory || !slotBit(inventory.known, slot)) return 'unknown';
+  return slotBit(inventory.loaded, slot) ? 'loaded' : 'empty';
+}
+
+// Carousel distance between two slots, the shorter way round
+function carouselDistance(from, to) {
+  const d = Math.abs(to - from);
+  return Math.min(d, INVENTORY_SLOTS - d);
+}
+
+// Predicted load time from a seek model row, as the ESP32 predicts it: a
+// bucket with 2+ samples, else the fitted line, else a single sample
+const SEEK_MIN_SAMPLES = 2;
+
+function predictLoadMs(model, distance) {
+  const bucket = distance === 0 ? 0 : Math.floor((distance - 1) / model.bucket_slots) + 1;
+  const samples = model.samples[bucket] || 0;
+  if (samples >= SEEK_MIN_SAMPLES) {
+    return { predictedMs: model.mean_ms[bucket], source: 'measured', samples };
+  }
+  if (distance > 0 && model.base_ms !== null && model.ms_per_slot !== null) {
+    const ms = Math.max(1, Math.round(model.base_ms + model.ms_per_slot * distance));
+    return { predictedMs: ms, source: 'fit', samples };
+  }
+  if (samples > 0) {
+    return { predictedMs: model.mean_ms[bucket], source: 'measured', samples };
+  }
+  return { predictedMs: null, source: null, samples: 0 };
+}
+
 // Middleware to access services from app context
 router.use((req, res, next) => {
   db = req.app.get('db') || db || new DatabaseService();
@@ -35,6 +88,13 @@ router.get('/discs', (req, res) => {
       offset: offset ? parseInt(offset) : 0
     });
 
+    // Catalogue positions are on bus 0
+    const inventory = new Map(db.getSlotInventory(0).map((row) => [row.player, row]));
+    result.discs = result.discs.map((disc) => ({
+      ...disc,
+      slot: slotState(inventory.get(disc.player), disc.position)
+    }));
+
     res.json(result);
   } catch (error) {
     console.error('Error fetching discs:', error);
@@ -134,18 +194,19 @@ router.get('/current', (req, res) => {
 /**
  * POST /api/state
  * Update playback state (called by ESP32)
+ * Optional bus identifies the S-Link bus on multi-bus controllers (default 0)
  */
 router.post('/state', (req, res) => {
   try {
-    const { player, disc, track, state } = req.body;
+    const { player, disc, track, state, bus = 0 } = req.body;
 
-    console.log(`[API] State update received: player=${player} disc=${disc} track=${track} state=${state}`);
+    console.log(`[API] State update received: bus=${bus} player=${player} disc=${disc} track=${track} state=${state}`);
 
     if (!player || !disc || !track || !state) {
       return res.status(400).json({ error: 'Missing required fields (player, disc, track, state)' });
     }
 
-    db.updatePlaybackState(player, disc, track, state);
+    db.updatePlaybackState(player, disc, track, state, bus);
 
     // Broadcast to WebSocket clients
     if (req.app.get('io')) {
@@ -161,19 +222,317 @@ router.post('/state', (req, res) => {
   }
 });
 
+/**
+ * POST /api/position
+ * Playback position from the ESP32's time status frames
+ * Body: { bus, player, disc, track, position, delta }
+ * Sent on track start and when the position drifts from the previous report
+ * extrapolated in real time; delta is that drift in seconds.
+ */
+router.post('/position', (req, res) => {
+  try {
+    const { bus = 0, player, disc, track, position, delta = 0 } = req.body;
+
+    if (!player || typeof position !== 'number' || position < 0) {
+      return res.status(400).json({ error: 'Missing required fields (player, position)' });
+    }
+
+    lastPosition = { bus, player, disc, track, position, delta, receivedAt: Date.now() };
+
+    if (req.app.get('io')) {
+      req.app.get('io').emit('position', lastPosition);
+    }
+
+    res.json({ success: true });
+  } catch (error) {
+    console.error('Error updating position:', error);
+    res.status(500).json({ error: 'Failed to update position' });
+  }
+});
+
+/**
+ * GET /api/position
+ * Latest reported playback position (empty object if none yet)
+ */
+router.get('/position', (req, res) => {
+  res.json(lastPosition || {});
+});
+
+/**
+ * POST /api/presence
+ * Player presence change from the ESP32
+ * Body: { bus, player, state } with state one of unknown, online, offline, powered-off
+ */
+router.post('/presence', (req, res) => {
+  try {
+    const { bus = 0, player, state } = req.body;
+
+    if (!player || !PRESENCE_STATES.includes(state)) {
+      return res.status(400).json({ error: 'Player and valid state required' });
+    }
+
+    const entry = { bus, player, state, changedAt: Date.now() };
+    presence.set(`${bus}:${player}`, entry);
+
+    if (req.app.get('io')) {
+      req.app.get('io').emit('presence', entry);
+    }
+
+    res.json({ success: true });
+  } catch (error) {
+    console.error('Error updating presence:', error);
+    res.status(500).json({ error: 'Failed to update presence' });
+  }
+});
+
+/**
+ * GET /api/presence
+ * Last reported presence of every player
+ */
+router.get('/presence', (req, res) => {
+  res.json(Array.from(presence.values()));
+});
+
+/**
+ * POST /api/inventory
+ * Loaded-slot bitsets of one changer from the ESP32, sent whenever they change
+ * Body: { bus, player, loaded, known } with loaded/known as 76-char hex bitsets
+ */
+router.post('/inventory', (req, res) => {
+  try {
+    const { bus = 0, player, loaded, known } = req.body;
+    const isBitset = (v) => typeof v === 'string' && v.length === INVENTORY_HEX_LENGTH && /^[0-9a-f]*$/i.test(v);
+
+    if (!player || !isBitset(loaded) || !isBitset(known)) {
+      return res.status(400).json({ error: 'Player and loaded/known bitsets required' });
+    }
+
+    db.setSlotInventory(bus, player, loaded.toLowerCase(), known.toLowerCase());
+
+    if (req.app.get('io')) {
+      req.app.get('io').emit('inventory', { bus, player });
+    }
+
+    res.json({ success: true });
+  } catch (error) {
+    console.error('Error updating inventory:', error);
+    res.status(500).json({ error: 'Failed to update inventory' });
+  }
+});
+
+/**
+ * GET /api/inventory
+ * Slot state per player on a bus (query param bus, default 0):
+ * [{ bus, player, loaded: [slots], empty: [slots], updated_at }]
+ */
+router.get('/inventory', (req, res) => {
+  try {
+    const bus = req.query.bus ? parseInt(req.query.bus) : 0;
+    const result = db.getSlotInventory(bus).map((row) => {
+      const loaded = [];
+      const empty = [];
+      for (let slot = 1; slot <= INVENTORY_SLOTS; slot++) {
+        const state = slotState(row, slot);
+        if (state === 'loaded') loaded.push(slot);
+        else if (state === 'empty') empty.push(slot);
+      }
+      return { bus: row.bus, player: row.player, loaded, empty, updated_at: row.updated_at };
+    });
+    res.json(result);
+  } catch (error) {
+    console.error('Error fetching inventory:', error);
+    res.status(500).json({ error: 'Failed to fetch inventory' });
+  }
+});
+
+/**
+ * POST /api/inventory/scan
+ * A batch of full inventory scan results of one changer from the ESP32
+ * Body: { bus, player, slots: [{ disc, loaded, track, loadMs }, ...] }
+ */
+router.post('/inventory/scan', (req, res) => {
+  try {
+    const { bus = 0, player, slots } = req.body;
+
+    if (!player || !Array.isArray(slots) || slots.length === 0 ||
+        !slots.every((s) => s && Number.isInteger(s.disc) && s.disc >= 1 && s.disc <= INVENTORY_SLOTS &&
+                            typeof s.loaded === 'boolean')) {
+      return res.status(400).json({ error: 'Player and slots (disc 1-300, loaded) required' });
+    }
+
+    db.setSlotScan(bus, player, slots);
+
+    if (req.app.get('io')) {
+      req.app.get('io').emit('inventory', { bus, player });
+    }
+
+    res.json({ success: true, count: slots.length });
+  } catch (error) {
+    console.error('Error storing scan results:', error);
+    res.status(500).json({ error: 'Failed to store scan results' });
+  }
+});
+
+/**
+ * GET /api/inventory/scan
+ * Full scan results per slot on a bus (query param bus, default 0):
+ * [{ bus, player, slot, loaded, first_track, load_ms, scanned_at }]
+ */
+router.get('/inventory/scan', (req, res) => {
+  try {
+    const bus = req.query.bus ? parseInt(req.query.bus) : 0;
+    res.json(db.getSlotScan(bus));
+  } catch (error) {
+    console.error('Error fetching scan results:', error);
+    res.status(500).json({ error: 'Failed to fetch scan results' });
+  }
+});
+
+/**
+ * POST /api/seek-model
+ * Disc load time model of one changer from the ESP32, sent whenever it changes
+ * Body: { bus, player, bucketSlots, meanMs: [...], samples: [...], baseMs?, msPerSlot? }
+ */
+router.post('/seek-model', (req, res) => {
+  try {
+    const { bus = 0, player, bucketSlots, meanMs, samples, baseMs = null, msPerSlot = null } = req.body;
+    const isCounts = (v) => Array.isArray(v) && v.length > 0 && v.length <= 16 &&
+                            v.every((n) => Number.isInteger(n) && n >= 0);
+
+    if (!player || !Number.isInteger(bucketSlots) || bucketSlots < 1 ||
+        !isCounts(meanMs) || !isCounts(samples) || meanMs.length !== samples.length) {
+      return res.status(400).json({ error: 'Player, bucketSlots and meanMs/samples arrays required' });
+    }
+
+    db.setSeekModel(bus, player, bucketSlots, meanMs, samples,
+                    typeof baseMs === 'number' ? baseMs : null,
+                    typeof msPerSlot === 'number' ? msPerSlot : null);
+    res.json({ success: true });
+  } catch (error) {
+    console.error('Error updating seek model:', error);
+    res.status(500).json({ error: 'Failed to update seek model' });
+  }
+});
+
+/**
+ * GET /api/seek-model
+ * Load time models of every player on a bus (query param bus, default 0)
+ */
+router.get('/seek-model', (req, res) => {
+  try {
+    const bus = req.query.bus ? parseInt(req.query.bus) : 0;
+    res.json(db.getSeekModels(bus));
+  } catch (error) {
+    console.error('Error fetching seek models:', error);
+    res.status(500).json({ error: 'Failed to fetch seek models' });
+  }
+});
+
+/**
+ * GET /api/seek-model/predict
+ * Predicted time for a player to load a disc
+ * Query params: player, disc, from (default: the player's current disc), bus
+ * Returns { bus, player, from, disc, distance, predictedMs, source, samples };
+ * predictedMs is null when there is no data for it yet
+ */
+router.get('/seek-model/predict', (req, res) => {
+  try {
+    const bus = req.query.bus ? parseInt(req.query.bus) : 0;
+    const player = parseInt(req.query.player);
+    const disc = parseInt(req.query.disc);
+    let from = req.query.from ? parseInt(req.query.from) : null;
+
+    if (!player || !(disc >= 1 && disc <= INVENTORY_SLOTS)) {
+      return res.status(400).json({ error: 'Player and disc (1-300) required' });
+    }
+    if (!from) {
+      const state = db.getPlaybackState();
+      if (state && state.current_player === player && (state.current_bus || 0) === bus) {
+        from = state.current_disc;
+      }
+    }
+    if (!(from >= 1 && from <= INVENTORY_SLOTS)) {
+      return res.status(400).json({ error: 'Current disc unknown, give from' });
+    }
+
+    const distance = carouselDistance(from, disc);
+    const model = db.getSeekModels(bus).find((m) => m.player === player);
+    const prediction = model ? predictLoadMs(model, distance)
+                             : { predictedMs: null, source: null, samples: 0 };
+    res.json({ bus, player, from, disc, distance, ...prediction });
+  } catch (error) {
+    console.error('Error predicting load time:', error);
+    res.status(500).json({ error: 'Failed to predict load time' });
+  }
+});
+
+const PLAYLIST_MAX = 32;
+
+/**
+ * POST /api/playlist
+ * Queue of whole discs for the ESP32 to play through, pre-positioning the
+ * idle changer on the next disc. Replaces any queue already on the bus; an
+ * empty list stops it.
+ * Body: { bus, entries: [{ player, disc, track? }, ...] }
+ */
+router.post('/playlist', (req, res) => {
+  try {
+    const { bus = 0, entries } = req.body;
+
+    if (!Array.isArray(entries) || entries.length > PLAYLIST_MAX ||
+        !entries.every((e) => e && [1, 2].includes(e.player) &&
+                              Number.isInteger(e.disc) && e.disc >= 1 && e.disc <= INVENTORY_SLOTS)) {
+      return res.status(400).json({ error: `Up to ${PLAYLIST_MAX} entries of player (1-2) and disc (1-300) required` });
+    }
+
+    // The track count tells the ESP32 when to start pre-positioning
+    const queue = entries.map(({ player, disc, track }) => {
+      const info = db.getDisc(player, disc);
+      const tracks = info ? (info.track_count || info.tracks.length) : 0;
+      return { player, disc, track: Number.isInteger(track) && track > 0 ? track : 0, tracks: Math.min(tracks, 255) };
+    });
+
+    db.setPlaylist(bus, queue);
+    const cmd = db.queueCommand('playlist', null, null, null, bus);
+    res.json({ success: true, queued: true, commandId: cmd.id, entries: queue });
+  } catch (error) {
+    console.error('Error queueing playlist:', error);
+    res.status(500).json({ error: 'Failed to queue playlist' });
+  }
+});
+
+/**
+ * GET /api/playlist
+ * The queue last sent to a bus (query param bus, default 0)
+ */
+router.get('/playlist', (req, res) => {
+  try {
+    const bus = req.query.bus ? parseInt(req.query.bus) : 0;
+    res.json(db.getPlaylist(bus));
+  } catch (error) {
+    console.error('Error fetching playlist:', error);
+    res.status(500).json({ error: 'Failed to fetch playlist' });
+  }
+});
+
 /**
  * POST /api/control/play
- * Play specific disc/track
+ * Play specific disc/track (optional bus, default 0)
  */
 router.post('/control/play', (req, res) => {
   try {
-    const { player, disc, track } = req.body;
+    const { player, disc, track, bus = 0 } = req.body;
 
     if (!player || !disc) {
       return res.status(400).json({ error: 'Player and disc number required' });
     }
 
-    const cmd = db.queueCommand('play', player, disc, track || 1);
+    // The ESP32 would drop it anyway
+    if (isPlayerOff(bus, player)) {
+      return res.status(409).json({ error: 'Player is offline or powered off' });
+    }
+
+    const cmd = db.queueCommand('play', player, disc, track || 1, bus);
     res.json({ success: true, queued: true, commandId: cmd.id });
   } catch (error) {
     console.error('Error queueing play command:', error);
@@ -237,6 +596,25 @@ router.post('/control/previous', (req, res) => {
   }
 });
 
+/**
+ * GET /api/control/:id
+ * Outcome of a queued command: queued, delivered (waiting for the changer
+ * to confirm), confirmed or failed, with the measured latency
+ */
+router.get('/control/:id', (req, res) => {
+  try {
+    const cmd = db.getCommand(req.params.id);
+
+    if (!cmd) {
+      return res.status(404).json({ error: 'Command not found' });
+    }
+    res.json(cmd);
+  } catch (error) {
+    console.error('Error getting command:', error);
+    res.status(500).json({ error: 'Failed to get command' });
+  }
+});
+
 /**
  * GET /api/esp32/poll
  * ESP32 polls for pending commands
@@ -256,19 +634,36 @@ router.get('/esp32/poll', (req, res) => {
   }
 });
 
+/**
+ * GET /api/esp32/playlist
+ * ESP32 fetches the queue after a 'playlist' command (query param bus)
+ */
+router.get('/esp32/playlist', (req, res) => {
+  try {
+    const bus = req.query.bus ? parseInt(req.query.bus) : 0;
+    res.json({ entries: db.getPlaylist(bus).entries });
+  } catch (error) {
+    console.error('Error fetching playlist:', error);
+    res.status(500).json({ error: 'Failed to fetch playlist' });
+  }
+});
+
 /**
  * POST /api/esp32/ack
  * ESP32 acknowledges command execution
  */
 router.post('/esp32/ack', (req, res) => {
   try {
-    const { id, success } = req.body;
+    const { id, success, latencyMs, result } = req.body;
 
     if (!id) {
       return res.status(400).json({ error: 'Command ID required' });
     }
 
-    db.acknowledgeCommand(id);
+    // Older firmware acks without a result: treat as success
+    db.acknowledgeCommand(id, success !== false,
+                          Number.isInteger(latencyMs) ? latencyMs : null,
+                          typeof result === 'string' ? result : null);
     res.json({ success: true });
   } catch (error) {
     console.error('Error acknowledging command:', error);
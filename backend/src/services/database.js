@@ -195,6 +195,7 @@ class DatabaseService {
   getPlaybackState() {
     const state = this.db.prepare(`
       SELECT
+        ps.current_bus,
         ps.current_player,
         ps.current_disc,
         ps.current_track,
@@ -218,7 +219,7 @@ class DatabaseService {
   /**
    * Update playback state
    */
-  updatePlaybackState(player, disc, track, state) {
+  updatePlaybackState(player, disc, track, state, bus = 0) {
     // Get current state before updating
     const currentState = this.db.prepare(`
       SELECT current_player, current_disc, current_track, state
@@ -227,11 +228,11 @@ class DatabaseService {
 
     const stmt = this.db.prepare(`
       UPDATE playback_state
-      SET current_player = ?, current_disc = ?, current_track = ?, state = ?, updated_at = CURRENT_TIMESTAMP
+      SET current_bus = ?, current_player = ?, current_disc = ?, current_track = ?, state = ?, updated_at = CURRENT_TIMESTAMP
       WHERE id = 1
     `);
 
-    stmt.run(player, disc, track, state);
+    stmt.run(bus, player, disc, track, state);
 
     // Record track play when track changes and state is 'play'
     if (player && disc && track && state === 'play') {
@@ -324,54 +325,199 @@ class DatabaseService {
     return result.count;
   }
 
+  /**
+   * Replace one player's slot bitsets
+   */
+  setSlotInventory(bus, player, loaded, known) {
+    this.db.prepare(`
+      INSERT INTO slot_inventory (bus, player, loaded, known, updated_at)
+      VALUES (?, ?, ?, ?, CURRENT_TIMESTAMP)
+      ON CONFLICT(bus, player) DO UPDATE SET
+        loaded = excluded.loaded,
+        known = excluded.known,
+        updated_at = CURRENT_TIMESTAMP
+    `).run(bus, player, loaded, known);
+  }
+
+  /**
+   * Get slot bitsets of every player on a bus
+   */
+  getSlotInventory(bus = 0) {
+    return this.db.prepare(`
+      SELECT bus, player, loaded, known, updated_at FROM slot_inventory WHERE bus = ?
+    `).all(bus);
+  }
+
+  /**
+   * Store a batch of full scan results of one player
+   */
+  setSlotScan(bus, player, slots) {
+    const upsert = this.db.prepare(`
+      INSERT INTO slot_scan (bus, player, slot, loaded, first_track, load_ms, scanned_at)
+      VALUES (?, ?, ?, ?, ?, ?, CURRENT_TIMESTAMP)
+      ON CONFLICT(bus, player, slot) DO UPDATE SET
+        loaded = excluded.loaded,
+        first_track = excluded.first_track,
+        load_ms = excluded.load_ms,
+        scanned_at = CURRENT_TIMESTAMP
+    `);
+    const transaction = this.db.transaction((rows) => {
+      for (const s of rows) {
+        upsert.run(bus, player, s.disc, s.loaded ? 1 : 0, s.track || null, s.loadMs || null);
+      }
+    });
+    transaction(slots);
+  }
+
+  /**
+   * Get the full scan results of every player on a bus
+   */
+  getSlotScan(bus = 0) {
+    return this.db.prepare(`
+      SELECT bus, player, slot, loaded, first_track, load_ms, scanned_at
+      FROM slot_scan WHERE bus = ? ORDER BY player, slot
+    `).all(bus).map((row) => ({ ...row, loaded: !!row.loaded }));
+  }
+
+  /**
+   * Replace one player's load time model
+   */
+  setSeekModel(bus, player, bucketSlots, meanMs, samples, baseMs = null, msPerSlot = null) {
+    this.db.prepare(`
+      INSERT INTO seek_model (bus, player, bucket_slots, mean_ms, samples, base_ms, ms_per_slot, updated_at)
+      VALUES (?, ?, ?, ?, ?, ?, ?, CURRENT_TIMESTAMP)
+      ON CONFLICT(bus, player) DO UPDATE SET
+        bucket_slots = excluded.bucket_slots,
+        mean_ms = excluded.mean_ms,
+        samples = excluded.samples,
+        base_ms = excluded.base_ms,
+        ms_per_slot = excluded.ms_per_slot,
+        updated_at = CURRENT_TIMESTAMP
+    `).run(bus, player, bucketSlots, JSON.stringify(meanMs), JSON.stringify(samples), baseMs, msPerSlot);
+  }
+
+  /**
+   * Get the load time models of every player on a bus
+   */
+  getSeekModels(bus = 0) {
+    return this.db.prepare(`
+      SELECT bus, player, bucket_slots, mean_ms, samples, base_ms, ms_per_slot, updated_at
+      FROM seek_model WHERE bus = ?
+    `).all(bus).map((row) => ({
+      ...row,
+      mean_ms: JSON.parse(row.mean_ms),
+      samples: JSON.parse(row.samples)
+    }));
+  }
+
+  /**
+   * Replace the disc queue of a bus
+   */
+  setPlaylist(bus, entries) {
+    this.db.prepare(`
+      INSERT INTO playlist (bus, entries, updated_at)
+      VALUES (?, ?, CURRENT_TIMESTAMP)
+      ON CONFLICT(bus) DO UPDATE SET
+        entries = excluded.entries,
+        updated_at = CURRENT_TIMESTAMP
+    `).run(bus, JSON.stringify(entries));
+  }
+
+  /**
+   * Get the disc queue of a bus (empty if none was sent)
+   */
+  getPlaylist(bus = 0) {
+    const row = this.db.prepare(`
+      SELECT bus, entries, updated_at FROM playlist WHERE bus = ?
+    `).get(bus);
+    return row ? { ...row, entries: JSON.parse(row.entries) } : { bus, entries: [], updated_at: null };
+  }
+
   /**
    * Add command to queue
    */
-  queueCommand(command, player = null, disc = null, track = null) {
+  queueCommand(command, player = null, disc = null, track = null, bus = 0) {
     const id = `cmd-${Date.now()}-${Math.random().toString(36).substring(2, 11)}`;
 
     this.db.prepare(`
-      INSERT INTO command_queue (id, command, player, disc, track)
-      VALUES (?, ?, ?, ?, ?)
-    `).run(id, command, player, disc, track);
+      INSERT INTO command_queue (id, command, player, disc, track, bus)
+      VALUES (?, ?, ?, ?, ?, ?)
+    `).run(id, command, player, disc, track, bus);
 
-    return { id, command, player, disc, track };
+    return { id, command, player, disc, track, bus };
   }
 
   /**
-   * Get pending command (for ESP32 polling)
+   * Get pending command (for ESP32 polling). The ESP32 only acks once the
+   * changer has confirmed the command, which can take a while, so a
+   * delivered command is handed out again only after a redelivery timeout
+   * and later commands are not held up behind it.
    */
   getPendingCommand() {
     const cmd = this.db.prepare(`
-      SELECT id, command, player, disc, track, created_at
+      SELECT id, command, player, disc, track, bus, created_at
       FROM command_queue
       WHERE acknowledged = 0
+      AND (delivered_at IS NULL OR datetime(delivered_at) < datetime('now', '-30 seconds'))
       ORDER BY created_at ASC
       LIMIT 1
     `).get();
 
     // Map command field to action for ESP32 compatibility
     if (cmd) {
+      this.db.prepare(`
+        UPDATE command_queue SET delivered_at = CURRENT_TIMESTAMP WHERE id = ?
+      `).run(cmd.id);
+
       return {
         id: cmd.id,
         action: cmd.command,
         player: cmd.player,
         disc: cmd.disc,
-        track: cmd.track
+        track: cmd.track,
+        bus: cmd.bus || 0
       };
     }
     return null;
   }
 
   /**
-   * Acknowledge command
+   * Acknowledge command with the outcome the ESP32 observed
    */
-  acknowledgeCommand(id) {
+  acknowledgeCommand(id, success = true, latencyMs = null, result = null) {
     this.db.prepare(`
       UPDATE command_queue
-      SET acknowledged = 1
+      SET acknowledged = 1, success = ?, latency_ms = ?, result = ?
       WHERE id = ?
-    `).run(id);
+    `).run(success ? 1 : 0, latencyMs, result, id);
+  }
+
+  /**
+   * Get one command and its outcome (null if unknown)
+   */
+  getCommand(id) {
+    const cmd = this.db.prepare(`
+      SELECT id, command, player, disc, track, bus, created_at, delivered_at,
+             acknowledged, success, latency_ms, result
+      FROM command_queue
+      WHERE id = ?
+    `).get(id);
+
+    if (!cmd) return null;
+    return {
+      id: cmd.id,
+      action: cmd.command,
+      player: cmd.player,
+      disc: cmd.disc,
+      track: cmd.track,
+      bus: cmd.bus || 0,
+      createdAt: cmd.created_at,
+      deliveredAt: cmd.delivered_at,
+      status: !cmd.acknowledged ? (cmd.delivered_at ? 'delivered' : 'queued')
+            : cmd.success ? 'confirmed' : 'failed',
+      latencyMs: cmd.latency_ms,
+      result: cmd.result
+    };
   }
 
   /**
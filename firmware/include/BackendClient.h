@@ -1,6 +1,7 @@
 #pragma once
 
-#include <Arduino.h>
+#include "SlinkHal.h"
+#include "SlinkDevices.h"
 
 // State to send to backend
 struct PlayerState {
@@ -8,16 +9,56 @@ struct PlayerState {
     int disc;        // 1-300
     int track;       // 1-99
     const char* state;  // "play", "pause", "stop"
+    int bus = 0;     // S-Link bus the player is on
+};
+
+// Playback position to send to backend
+struct PlayerPosition {
+    int bus;
+    int player;      // 1 or 2
+    int disc;        // 1-300
+    int track;       // 1-99
+    int position;    // seconds into the track
+};
+
+// Disc load times of one player by carousel distance (see SlinkSeekProfile)
+struct SeekModel {
+    int             bus;
+    int             player;
+    int             bucketSlots;    // distances per bucket; bucket 0 is distance 0
+    int             buckets;
+    const uint16_t* meanMs;
+    const uint16_t* samples;
+    bool            hasFit = false;
+    float           baseMs = 0;     // ms = baseMs + msPerSlot * distance
+    float           msPerSlot = 0;
+};
+
+// One slot as found by a full inventory scan (see SlinkInventoryScan)
+struct ScanSlot {
+    int  disc;
+    bool loaded;
+    int  firstTrack;    // 0 = none reported
+    int  loadMs;        // 0 if empty
+};
+
+// One disc of a play queue pushed by the backend
+struct PlaylistItem {
+    int player;
+    int disc;
+    int track;       // 0 = first
+    int tracks;      // on the disc, 0 = unknown
 };
 
 // Command received from backend
 struct BackendCommand {
     bool valid;
-    char action[16];  // "play", "pause", "stop", "next", "previous"
+    char action[16];  // "play", "pause", "stop", "next", "previous", "playlist"
     int player;       // For "play" command (1 or 2)
     int disc;         // For "play" command
     int track;        // For "play" command
     char id[32];      // Command ID for acknowledgment
+    int bus;          // S-Link bus to send on (0 if not given)
 };
 
 class BackendClient {
@@ -35,6 +76,35 @@ public:
     // Returns true if sent successfully
     bool sendState(const PlayerState& state);
 
+    // Send the playback position of a playing player. Rate limited per bus
+    // and player: the backend extrapolates at 1s/s, so an update only goes
+    // out on a track change, when the decoded position drifts from that
+    // extrapolation by more than POSITION_DRIFT_S, or every
+    // POSITION_REFRESH_MS as a keep-alive. Returns true if the backend is
+    // up to date (sent now or not needed).
+    bool sendPosition(const PlayerPosition& pos);
+
+    // Report a player's presence ("unknown", "online", "offline",
+    // "powered-off"); sent on change only
+    bool sendPresence(int bus, int player, const char* state);
+
+    // Send one player's slot bitsets (see SlinkInventory) as hex
+    bool sendInventory(int bus, int player, const uint8_t* loaded,
+                       const uint8_t* known, int bytes);
+
+    // Send one player's load time model
+    bool sendSeekModel(const SeekModel& model);
+
+    // Send a batch of inventory scan results of one player (up to
+    // MAX_SCAN_SLOTS)
+    bool sendScanResults(int bus, int player, const ScanSlot* slots, int count);
+    static const int MAX_SCAN_SLOTS = 50;
+
+    // Fetch a bus's play queue (after a "playlist" command) into items.
+    // Returns the number of items, or -1 if it couldn't be fetched.
+    int fetchPlaylist(int bus, PlaylistItem* items, int maxItems);
+    static const int MAX_PLAYLIST = 32;
+
     // Check if there's a pending command from backend
     // Returns true if command available
     bool hasCommand();
@@ -42,8 +112,10 @@ public:
     // Get the pending command (clears it)
     BackendCommand getCommand();
 
-    // Acknowledge a command was executed
-    bool acknowledgeCommand(const char* commandId);
+    // Report a command's outcome: whether the changer confirmed it, how
+    // long that took and why not (result, may be null)
+    bool acknowledgeCommand(const char* commandId, bool success = true,
+                            uint32_t latencyMs = 0, const char* result = nullptr);
 
     // Status getters
     bool isWifiConnected();
@@ -74,12 +146,28 @@ private:
     // HTTP helpers
     bool _httpPost(const char* path, const char* json);
     bool _httpGet(const char* path, char* response, size_t maxLen);
-
-    // State tracking to avoid duplicate sends
-    int _lastPlayer;
-    int _lastDisc;
-    int _lastTrack;
-    const char* _lastState;
+    void _printHttpError(int httpCode);
+
+    // State tracking to avoid duplicate sends, per bus and player so that
+    // alternating reports from several changers don't defeat it
+    struct SentState {
+        int disc;
+        int track;
+        const char* state;
+    };
+    SentState _lastSent[SLINK_MAX_BUSES][SLINK_MAX_PLAYERS];
+
+    // Last position sent, per bus and player
+    struct SentPosition {
+        int disc;
+        int track;
+        int position;
+        unsigned long sentAt;
+    };
+    SentPosition _lastPosition[SLINK_MAX_BUSES][SLINK_MAX_PLAYERS];
+    static const int POSITION_DRIFT_S = 2;
+    static const unsigned long POSITION_MIN_INTERVAL_MS = 1000;   // between drift corrections
+    static const unsigned long POSITION_REFRESH_MS = 30000;
 
     // Failure tracking for backoff
     int _consecutiveFailures;
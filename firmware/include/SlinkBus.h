@@ -0,0 +1,114 @@
+#pragma once
+
+#include "SlinkDecoder.h"
+#include "SlinkTx.h"
+#include "SlinkPresence.h"
+#include "SlinkInventory.h"
+#include "SlinkBusLoad.h"
+#include "SlinkConfirm.h"
+#include "SlinkSeekProfile.h"
+#include "SlinkPlaylist.h"
+#include "SlinkInventoryScan.h"
+#include "SlinkDiscovery.h"
+
+// Pins and RMT channels of one S-Link bus. RX takes two channels' worth of
+// RMT memory (rxChannel and the next one), so TX goes on the channel after.
+struct SlinkBusConfig {
+    int           rxPin;
+    int           txPin;
+    rmt_channel_t rxChannel;
+    rmt_channel_t txChannel;
+};
+
+// One S-Link bus (a rack of changers): its own decoder, transmitter
+// (carrier sensing on the RX pin), player presence (which gates the
+// transmitter), slot inventory (and its full scan), bus load, command
+// confirmation, disc load times, play queue and protocol discovery.
+// Buses are plain members of a fixed array built from compile-time config,
+// so frames reach their decoder without any per-frame dispatch.
+class SlinkBus {
+public:
+    SlinkBus(int id, const SlinkBusConfig& cfg)
+        : decoder(cfg.rxPin, cfg.rxChannel)
+        , tx(cfg.txPin, cfg.txChannel)
+        , presence(id)
+        , inventory(id)
+        , load(id)
+        , confirm(tx, decoder)
+        , seek(decoder, id)
+        , playlist(tx, decoder)
+        , scan(tx, decoder, inventory, seek, id)
+        , discovery(tx, id)
+        , _id(id)
+        , _cfg(cfg) {
+        decoder.setBusId(id);
+        SlinkDecoderEvents& ev = decoder.events();
+        ev.activity.subscribe<SlinkPresence, &SlinkPresence::onActivity>(&presence);
+        ev.loaded.subscribe<SlinkInventory, &SlinkInventory::onLoaded>(&inventory);
+        ev.status.subscribe<SlinkInventory, &SlinkInventory::onStatus>(&inventory);
+        ev.echo.subscribe<SlinkTx, &SlinkTx::onEcho>(&tx);
+        ev.traffic.subscribe<SlinkBusLoad, &SlinkBusLoad::onTraffic>(&load);
+        ev.status.subscribe<SlinkConfirm, &SlinkConfirm::onStatus>(&confirm);
+        ev.transport.subscribe<SlinkConfirm, &SlinkConfirm::onTransport>(&confirm);
+        ev.traffic.subscribe<SlinkSeekProfile, &SlinkSeekProfile::onTraffic>(&seek);
+        ev.statusFrame.subscribe<SlinkSeekProfile, &SlinkSeekProfile::onStatusFrame>(&seek);
+        ev.status.subscribe<SlinkPlaylist, &SlinkPlaylist::onStatus>(&playlist);
+        ev.transport.subscribe<SlinkPlaylist, &SlinkPlaylist::onTransport>(&playlist);
+        ev.statusFrame.subscribe<SlinkInventoryScan, &SlinkInventoryScan::onStatusFrame>(&scan);
+        ev.transport.subscribe<SlinkInventoryScan, &SlinkInventoryScan::onTransport>(&scan);
+        ev.traffic.subscribe<SlinkDiscovery, &SlinkDiscovery::onTraffic>(&discovery);
+        ev.unknown.subscribe<SlinkDiscovery, &SlinkDiscovery::onUnknown>(&discovery);
+        tx.setGate(SlinkPresence::txGate, &presence);
+        tx.setPositionSource(_position, this);
+        tx.setCarrierSense(cfg.rxPin);
+        tx.setSlotCheck(SlinkBusLoad::txSlot, &load);
+    }
+
+    void begin() {
+        decoder.begin();
+        tx.begin();
+        seek.begin();
+        scan.begin();
+    }
+
+    void loop() {
+        decoder.loop();
+        presence.loop();
+        tx.loop();
+        confirm.loop();
+        seek.loop();
+        playlist.loop();
+        scan.loop();
+        discovery.loop();
+    }
+
+    int id() const { return _id; }
+    const SlinkBusConfig& config() const { return _cfg; }
+
+    SlinkDecoder decoder;
+    SlinkTx      tx;
+    SlinkPresence presence;
+    SlinkInventory inventory;
+    SlinkBusLoad  load;
+    SlinkConfirm  confirm;
+    SlinkSeekProfile seek;
+    SlinkPlaylist playlist;
+    SlinkInventoryScan scan;
+    SlinkDiscovery discovery;
+
+private:
+    // Committed disc/track, and the track count if the play queue has the
+    // disc, for the transmitter's skip coalescing
+    static bool _position(void* ctx, int player, int* disc, int* track, int* tracks) {
+        const SlinkBus* bus = static_cast<SlinkBus*>(ctx);
+        const SlinkTrackStatus& st = bus->decoder.state(player);
+        if (!st.haveStatus || st.discNumber < 1 || st.trackNumber < 1) return false;
+        *disc = st.discNumber;
+        *track = st.trackNumber;
+        *tracks = bus->playlist.tracks(player, st.discNumber);
+        return true;
+    }
+
+    int            _id;
+    SlinkBusConfig _cfg;
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "SlinkHal.h"
+#include "SlinkEvents.h"
+
+// Bus load on one S-Link bus, from decoded traffic.
+//
+// Changers talk on their own schedule: the Command Mode 3 player heartbeats
+// every few seconds and repeats its extended status, time frames stream
+// while it plays. Each (device, frame type, length) is tracked as a source
+// with its emission period and jitter; one whose intervals agree (allowing
+// for frames we failed to decode) becomes periodic, and its next frames
+// are predicted. Status frames only come on state changes and never do.
+//
+// Installed as the bus transmitter's slot check: a frame that would
+// overlap a predicted one waits until it has gone by. Also keeps bus
+// utilization and the distribution of idle gaps between frames.
+class SlinkBusLoad {
+public:
+    explicit SlinkBusLoad(int bus = 0);
+
+    // Decoder traffic subscriber
+    void onTraffic(const SlinkTrafficEvent& ev);
+
+    // Whether a frame of durationUs starting at startUs misses every
+    // predicted frame; if not, clearAtUs is when the last one it hits ends
+    bool clearFor(unsigned long startUs, uint32_t durationUs, unsigned long* clearAtUs) const;
+
+    // SlinkTxSlotCheck
+    static bool txSlot(void* ctx, unsigned long startUs, uint32_t durationUs, unsigned long* clearAtUs);
+
+    // Busy share of the bus in per mille: over the last UTIL_WINDOW_S
+    // seconds, and since the first frame
+    uint16_t utilization() const;
+    uint16_t utilizationTotal() const;
+
+    int periodicSources() const;
+
+    void printReport(Print& out) const;
+
+private:
+    struct Source {
+        uint8_t       device;
+        uint8_t       type;         // byte 2
+        uint8_t       len;
+        uint8_t       hits;         // intervals in a row that fit the period
+        uint32_t      frames;
+        unsigned long lastUs;       // start of the latest frame
+        uint32_t      periodUs;     // 0 = one frame seen so far
+        uint32_t      jitterUs;     // mean deviation from the period
+        uint32_t      durationUs;
+    };
+
+    static const int      MAX_SOURCES = 12;
+    static const uint8_t  PERIODIC_HITS = 3;
+    static const uint32_t MIN_PERIOD_US = 100000;       // faster is a burst, not a cadence
+    static const uint32_t MAX_PERIOD_US = 60000000;
+    static const int      MAX_MISSED = 3;               // undecoded frames bridged per interval
+    static const uint32_t GUARD_US = 3000;              // around a predicted frame, plus 2x jitter
+
+    static const int      UTIL_WINDOW_S = 10;
+    static const int      GAP_BUCKETS = 10;
+    static const uint16_t GAP_LIMIT_MS[GAP_BUCKETS - 1];
+
+    int      _bus;
+    Source   _sources[MAX_SOURCES];
+    int      _numSources = 0;
+
+    uint32_t      _frames = 0;
+    uint32_t      _ours = 0;
+    unsigned long _firstUs = 0;
+    unsigned long _lastEndUs = 0;
+    uint64_t      _busyUs = 0;
+    uint32_t      _gaps[GAP_BUCKETS] = {};
+    uint32_t      _secBusyUs[UTIL_WINDOW_S] = {};
+    unsigned long _secStamp[UTIL_WINDOW_S] = {};
+
+    bool _periodic(const Source& s, unsigned long now) const;
+    void _learn(Source& s, unsigned long startUs, uint32_t durationUs);
+    Source& _source(const SlinkTrafficEvent& ev);
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "SlinkHal.h"
+#include "SpscQueue.h"
+
+// Pulse capture back-ends for SlinkDecoder.
+//
+// Every back-end hands out blocks in the RMT item layout (two durations per
+// item, a zero duration marks the idle end of a burst), so the decoder's
+// framer consumes them unchanged. Dispatch is virtual per block, not per
+// pulse.
+//
+//   SlinkRmtCapture   RMT RX channel; hardware timestamps, one interrupt
+//                     per capture. Default.
+//   SlinkGpioCapture  GPIO change interrupt + hardware idle timer, for when
+//                     the RMT channels are needed for TX or other buses.
+//                     One interrupt per edge; timing picks up ISR latency.
+//
+// PCNT is not offered: it counts edges but cannot timestamp them, and the
+// S-Link bits are encoded purely in mark widths.
+
+struct SlinkCaptureStats {
+    uint32_t blocks     = 0;   // blocks handed to the decoder
+    uint32_t items      = 0;   // RMT items in those blocks
+    uint32_t interrupts = 0;   // capture interrupts taken
+    uint32_t overruns   = 0;   // pulses lost because the decoder fell behind
+};
+
+class SlinkCapture {
+public:
+    virtual ~SlinkCapture() {}
+
+    virtual bool begin() = 0;
+
+    // Borrow the next block. Returns nullptr if nothing completed within
+    // timeoutMs (0 = poll). Must be handed back via release().
+    virtual rmt_item32_t* receive(size_t* numItems, uint32_t timeoutMs) = 0;
+    virtual void          release(rmt_item32_t* items) = 0;
+
+    virtual const char*   name() const = 0;
+
+    const SlinkCaptureStats& stats() const { return _stats; }
+
+    // Idle threshold in µs - if line is idle this long, the capture ends.
+    // Handled by RMT hardware (or the edge back-end's idle timer).
+    static const uint16_t IDLE_THRESHOLD_US = 20000;  // 20ms
+
+protected:
+    SlinkCaptureStats _stats;
+};
+
+class SlinkRmtCapture : public SlinkCapture {
+public:
+    // memBlocks x 64 items of RMT memory; frames cut off by a full block
+    // are carried over by the decoder, so 2 is plenty for S-Link bursts
+    SlinkRmtCapture(int rxPin, rmt_channel_t channel, uint8_t memBlocks = 2);
+
+    bool          begin() override;
+    rmt_item32_t* receive(size_t* numItems, uint32_t timeoutMs) override;
+    void          release(rmt_item32_t* items) override;
+    const char*   name() const override { return "rmt"; }
+
+    rmt_channel_t channel() const { return _channel; }
+
+private:
+    int             _rxPin;
+    rmt_channel_t   _channel;
+    uint8_t         _memBlocks;
+    SlinkHal::RmtRx _rx;
+};
+
+class SlinkGpioCapture : public SlinkCapture {
+public:
+    explicit SlinkGpioCapture(int rxPin);
+
+    bool          begin() override;
+    rmt_item32_t* receive(size_t* numItems, uint32_t timeoutMs) override;
+    void          release(rmt_item32_t* items) override;
+    const char*   name() const override { return "gpio"; }
+
+private:
+    static const int      BLOCK_ITEMS = 64;
+    static const int      QUEUE_LEN = 512;       // durations, ~5 frames
+    static const uint32_t GLITCH_US = 100;       // same as the RMT filter
+
+    int _rxPin;
+
+    // ISR side
+    SpscQueue<uint16_t, QUEUE_LEN> _durations;   // 0 = idle end
+    unsigned long _lastEdgeUs = 0;
+    uint32_t      _held = 0;                     // last level, not yet pushed
+    bool          _idle = true;
+    bool          _merge = false;
+    volatile uint32_t _interrupts = 0;
+
+    static void IRAM_ATTR _onEdge(void* arg, unsigned long us);
+    static void IRAM_ATTR _onIdle(void* arg);
+    void IRAM_ATTR        _push(uint32_t us);
+
+    // Decoder side: durations staged into a block until the idle end
+    rmt_item32_t _items[BLOCK_ITEMS];
+    int          _staged = 0;
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <stdint.h>
+
+// S-Link number codecs, shared by RX (SlinkDecoder) and TX (SlinkTx).
+//
+// Status frames carry disc/track/time as "power-of-4" codes: every binary
+// digit of an index becomes a base-4 digit of the code, so index 5 (0b101)
+// is sent as 0x0011. Decoding is therefore bit extraction, and the
+// index -> disc/track number step is a constexpr lookup table.
+
+namespace SlinkCodec {
+
+// ---------------- Index <-> bus code ----------------
+
+// Spread the low 8 bits of n onto the even bit positions
+constexpr uint16_t encodeIndex(uint16_t n) {
+    uint16_t x = n & 0x00FF;
+    x = (x | (x << 4)) & 0x0F0F;
+    x = (x | (x << 2)) & 0x3333;
+    x = (x | (x << 1)) & 0x5555;
+    return x;
+}
+
+// Inverse of encodeIndex. Returns -1 if the code has odd bits set (not a
+// power-of-4 code) or the index is 0 or above maxIndex.
+constexpr int decodeIndex(uint16_t code, uint16_t maxIndex) {
+    if (code & 0xAAAA) return -1;
+    uint16_t x = code & 0x5555;
+    x = (x | (x >> 1)) & 0x3333;
+    x = (x | (x >> 2)) & 0x0F0F;
+    x = (x | (x >> 4)) & 0x00FF;
+    return (x == 0 || x > maxIndex) ? -1 : (int)x;
+}
+
+// Time digits use the same scheme on single bytes:
+// 0x00=0, 0x01=1, 0x04=2, 0x05=3, 0x10=4, 0x11=5, 0x14=6, 0x15=7, 0x40=8, 0x41=9
+constexpr int decodeTimeValue(uint8_t code) {
+    return (code & 0x03)
+         + ((code >> 2) & 0x03) * 2
+         + ((code >> 4) & 0x03) * 4
+         + ((code >> 6) & 0x03) * 8;
+}
+
+// ---------------- Index <-> disc/track number ----------------
+
+// Numbers 1..99 skip the 0xA-0xF nibbles: index = n + 6 * floor(n / 10)
+// Discs 100..200 (low device): index = n + 54
+// Discs 201..300 (high device): index = n - 200
+constexpr int indexFromNumber(int n) {
+    return n <= 99 ? n + 6 * (n / 10) : (n <= 200 ? n + 54 : n - 200);
+}
+
+static const int MAX_INDEX = 255;
+
+struct NumberTable {
+    int16_t number[MAX_INDEX + 1];
+
+    constexpr NumberTable() : number() {
+        for (int i = 0; i <= MAX_INDEX; ++i) number[i] = -1;
+        for (int n = 1; n <= 200; ++n) number[indexFromNumber(n)] = (int16_t)n;
+    }
+};
+
+inline constexpr NumberTable NUMBERS{};
+
+// Track numbers 1..99
+constexpr int trackNumberFromIndex(int idx) {
+    return (idx >= 1 && idx <= indexFromNumber(99)) ? NUMBERS.number[idx] : -1;
+}
+
+// Disc numbers 1..200 (low-range device, e.g. dev=0x40)
+constexpr int discNumberLowFromIndex(int idx) {
+    return (idx >= 1 && idx <= indexFromNumber(200)) ? NUMBERS.number[idx] : -1;
+}
+
+// Disc numbers 201..300 (high-range device, e.g. dev=0x45): idx = 1..100
+constexpr int discNumberHighFromIndex(int idx) {
+    return (idx >= 1 && idx <= 100) ? idx + 200 : -1;
+}
+
+// ---------------- TX parameter bytes ----------------
+
+// Disc encoding for S-Link TX commands:
+// 1-99:    Standard BCD (disc 1 = 0x01, disc 99 = 0x99)
+// 100-200: (disc - 100) + 0x9A  (disc 100=0x9A, disc 150=0xCC, disc 200=0xFE)
+// 201-300: Raw value (disc - 200) as single byte
+//          Device interprets as: disc = 200 + byte_value
+constexpr uint8_t encodeDiscByte(int disc) {
+    return disc <= 0   ? 0x00
+         : disc <= 99  ? (uint8_t)(((disc / 10) << 4) | (disc % 10))
+         : disc <= 200 ? (uint8_t)((disc - 100) + 0x9A)
+         : disc <= 300 ? (uint8_t)(disc - 200)
+         : 0x00;
+}
+
+// Track as BCD, 0 for "first track"
+constexpr uint8_t encodeTrackByte(int track) {
+    return (track > 0 && track <= 99) ? (uint8_t)(((track / 10) << 4) | (track % 10)) : 0x00;
+}
+
+// Inverse of encodeTrackByte; 0 for "first track" or not BCD
+constexpr int decodeTrackByte(uint8_t b) {
+    return ((b >> 4) <= 9 && (b & 0x0F) <= 9) ? (b >> 4) * 10 + (b & 0x0F) : 0;
+}
+
+// Inverse of encodeDiscByte for the addressed range; -1 if not a disc.
+// Extended status frames report the loaded disc this way (high range
+// observed: disc 201 = 0x01).
+constexpr int decodeDiscByte(uint8_t b, bool highRange) {
+    return highRange                              ? ((b >= 1 && b <= 100) ? 200 + b : -1)
+         : b >= 0x9A && b <= 0xFE                 ? b - 0x9A + 100
+         : (b >> 4) <= 9 && (b & 0x0F) <= 9 && b  ? (b >> 4) * 10 + (b & 0x0F)
+         : -1;
+}
+
+// ---------------- Compile-time checks ----------------
+
+// Exhaustive round trips over every index and every disc/track number
+constexpr bool _selfTest() {
+    for (int i = 1; i <= MAX_INDEX; ++i) {
+        if (decodeIndex(encodeIndex(i), MAX_INDEX) != i) return false;
+        if (decodeTimeValue((uint8_t)encodeIndex(i & 0x0F)) != (i & 0x0F)) return false;
+    }
+    for (int n = 1; n <= 99; ++n) {
+        if (trackNumberFromIndex(decodeIndex(encodeIndex(indexFromNumber(n)), 200)) != n) return false;
+    }
+    for (int n = 1; n <= 200; ++n) {
+        if (discNumberLowFromIndex(decodeIndex(encodeIndex(indexFromNumber(n)), 300)) != n) return false;
+    }
+    for (int n = 201; n <= 300; ++n) {
+        if (discNumberHighFromIndex(decodeIndex(encodeIndex(indexFromNumber(n)), 300)) != n) return false;
+    }
+    for (int n = 0; n <= 99; ++n) {
+        if (decodeTrackByte(encodeTrackByte(n)) != n) return false;
+    }
+    for (int n = 1; n <= 300; ++n) {
+        if (decodeDiscByte(encodeDiscByte(n), n > 200) != n) return false;
+    }
+    return true;
+}
+
+static_assert(_selfTest(), "S-Link codec round trip failed");
+
+}  // namespace SlinkCodec
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "SlinkHal.h"
+#include "SlinkDevices.h"
+#include "SlinkEvents.h"
+#include "SlinkTx.h"
+
+class SlinkDecoder;
+struct SlinkTrackStatus;
+struct SlinkConfirmResult;
+
+// What a command is for, and so what the changer should report back
+enum SlinkConfirmAction : uint8_t {
+    SLINK_CONFIRM_PLAY_DISC = 0,    // track status for that disc (and track, if given)
+    SLINK_CONFIRM_PLAY,             // transport play
+    SLINK_CONFIRM_STOP,             // transport stop
+    SLINK_CONFIRM_PAUSE,            // toggle: pause, or play if it was paused
+    SLINK_CONFIRM_NEXT,             // a track status with another track
+    SLINK_CONFIRM_PREVIOUS,
+};
+
+struct SlinkConfirmStats {
+    uint32_t issued    = 0;
+    uint32_t confirmed = 0;
+    uint32_t failed    = 0;     // timed out, not sent or superseded
+    uint32_t resent    = 0;
+    uint32_t maxLatencyMs = 0;  // of confirmed commands
+    uint64_t totalLatencyMs = 0;
+};
+
+// Closed-loop commands on one bus.
+//
+// issue() sends a command and then watches the decoder for the outcome it
+// should cause. Until the changer reacts at all (any transport frame or
+// status change from the player, e.g. 0x40 while it loads a disc) it is resent
+// every RESEND_MS; play disc, play and stop only, since next, previous and
+// pause would act twice. Without the outcome by its deadline the command
+// has failed. A newer command to the same player supersedes a pending one
+// that hasn't gone out yet, or that would be resent over it; one already
+// on the wire that won't be repeated (next, previous, pause) still takes
+// effect and ends on its own outcome. Skips the same way add up instead
+// (the transmitter folds them together): one issued behind pending skips
+// counts from where the first of them started, so a quick double next is
+// confirmed at the second track along. Each command ends in exactly one
+// result event.
+class SlinkConfirm {
+public:
+    SlinkConfirm(SlinkTx& tx, const SlinkDecoder& decoder);
+
+    // Decoder subscribers
+    void onStatus(const SlinkTrackStatus& st);
+    void onTransport(const SlinkTransportEvent& ev);
+
+    // Resends and deadlines; call from loop()
+    void loop();
+
+    // tag (copied, may be null) names the command for isPending() and the
+    // result. disc/track are for play disc (track 0 = any). false if the
+    // command could not be queued; its failed result has been sent.
+    bool issue(const char* tag, SlinkConfirmAction action, int player,
+               int disc = 0, int track = 0);
+
+    bool isPending(const char* tag) const;
+    int  pending() const;
+
+    SlinkEventChannel<SlinkConfirmResult>& results() { return _results; }
+
+    const SlinkConfirmStats& stats() const { return _stats; }
+    void printReport(Print& out) const;
+
+    static const char* actionName(SlinkConfirmAction action);
+
+    static const int TAG_LEN = 32;
+
+private:
+    struct Pending {
+        SlinkConfirm* owner;        // for the TX completion
+        bool          used;
+        uint8_t       queued;       // frames with the transmitter (slot stays until 0)
+        bool          already;      // in the target state before we sent it
+        bool          sent;         // a frame went out
+        bool          heard;        // the changer reacted
+        uint8_t       attempts;
+        uint8_t       action;
+        int8_t        player;
+        int16_t       disc;
+        int8_t        track;
+        bool          wasPaused;
+        int16_t       discBefore;
+        int8_t        trackBefore;
+        int8_t        steps;        // next/previous: tracks from Before, earlier skips included
+        char          tag[TAG_LEN];
+        unsigned long issuedMs;
+        unsigned long sentMs;       // latest attempt
+        unsigned long deadlineMs;
+    };
+
+    static const int           MAX_PENDING = 4;
+    static const uint8_t       MAX_ATTEMPTS = 3;
+    static const unsigned long RESEND_MS = 1500;
+    static const unsigned long DISC_DEADLINE_MS = 20000;   // the carousel may turn half way
+    static const unsigned long DEADLINE_MS = 5000;
+
+    SlinkTx&            _tx;
+    const SlinkDecoder& _decoder;
+    Pending             _pending[MAX_PENDING];
+    SlinkConfirmStats   _stats;
+    SlinkEventChannel<SlinkConfirmResult> _results;
+
+    bool _send(Pending& p);
+    static void _onSent(void* ctx, const SlinkTxCompletion& c);
+    static bool _resendable(const Pending& p);
+    void _finish(Pending& p, bool success, const char* reason);
+};
+
+struct SlinkConfirmResult {
+    const char*        tag;         // "" if issued without one
+    SlinkConfirmAction action;
+    int                player;
+    bool               success;
+    uint8_t            attempts;    // frames sent for it
+    uint32_t           latencyMs;   // issue() until the outcome (or giving up)
+    const char*        reason;      // "confirmed", "already", "timeout", "not sent", "superseded"
+};
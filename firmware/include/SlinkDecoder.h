@@ -1,7 +1,11 @@
 #pragma once
 
-#include <Arduino.h>
-#include <driver/rmt.h>
+#include "SlinkHal.h"
+#include "SpscQueue.h"
+#include "SlinkDevices.h"
+#include "SlinkPulseClassifier.h"
+#include "SlinkEvents.h"
+#include "SlinkCapture.h"
 
 struct SlinkTrackStatus {
     bool   playing = false;
@@ -17,69 +21,195 @@ struct SlinkTrackStatus {
     int      discNumber = -1;   // 1–300
     int      trackNumber = -1;  // 1–99
     int      player = 0;        // 1 or 2 (0 = unknown)
+    int      bus = 0;           // S-Link bus the player is on
 };
 
-typedef void (*SlinkStatusCallback)(const SlinkTrackStatus& status);
-typedef void (*SlinkTransportCallback)(uint8_t code);
+// One decoded bus frame, as handed from the RX task to the application
+struct SlinkFrame {
+    uint8_t       len = 0;
+    uint8_t       bytes[16];
+    unsigned long rxMicros = 0;
+    uint8_t       confidence = 100; // worst pulse margin in the frame (%)
+    uint16_t      widthUs[3] = {};  // mean mark per pulse class (echoes only)
+    unsigned long startUs = 0;      // first and last pulse on the wire, as
+    unsigned long endUs = 0;        // estimated from when the capture ended
+};
+
+// Framer counters (written by whichever task runs RMT receive)
+struct SlinkRxStats {
+    uint32_t captures  = 0;   // RMT ring-buffer items consumed
+    uint32_t frames    = 0;   // frames delivered (any header byte)
+    uint32_t truncated = 0;   // ended mid-byte or overran the frame buffer
+    uint32_t dropped   = 0;   // sync with no complete byte, or stale carry-over
+    uint32_t carried   = 0;   // frames reassembled across two captures
+    uint32_t lowConfidence = 0; // frames with a pulse near a window edge
+};
+
+// Track status confirmation counters (loop() side)
+struct SlinkStatusStats {
+    uint32_t observed  = 0;   // track status frames from known players
+    uint32_t invalid   = 0;   // of those, disc or track failed to decode
+    uint32_t committed = 0;   // disc/track changes passed to subscribers
+};
+
+// Frame handler for registered frame types. Return false to pass the frame
+// on to later rules (and finally the unknown-frame log). The rule has
+// already matched len, so fixed-length handlers leave it unnamed.
+typedef bool (*SlinkFrameHandler)(void* ctx, const uint8_t* bytes, int len);
 
 class SlinkDecoder {
 public:
-    explicit SlinkDecoder(int rxPin);
+    // Captures from an RMT channel on rxPin by default
+    explicit SlinkDecoder(int rxPin, rmt_channel_t channel = RMT_CHANNEL_0);
+
+    // Bus id stamped on states and events (call before begin())
+    void setBusId(int bus) { _busId = bus; }
+    int  busId() const { return _busId; }
+
+    // Use another capture back-end instead (call before begin())
+    void setCapture(SlinkCapture* capture) { _capture = capture; }
+    const SlinkCapture& capture() const { return *_capture; }
 
     void begin();
-    void loop();
 
-    void onStatus(SlinkStatusCallback cb);
-    void onTransport(SlinkTransportCallback cb);
+    // Optional: decode in a dedicated task that blocks on the RMT ring
+    // buffer, so ingest keeps up while loop() is stuck in HTTP or the CLI.
+    // Frames then reach loop() through a bounded SPSC queue and all
+    // callbacks still run on the caller of loop(). Call after begin().
+    bool startTask(int core, int priority);
 
-private:
-    // config
-    int _rxPin;
-    rmt_channel_t _rmtChannel;
+    // Polls RMT (or drains the RX task's frame queue) and runs callbacks
+    void loop();
 
-    // RMT item buffer for received pulses
-    static const int MAX_RMT_ITEMS = 256;
-    rmt_item32_t _rmtItems[MAX_RMT_ITEMS];
+    // Frames lost because loop() fell behind the RX task
+    uint32_t droppedFrames() const { return _frameQueue.dropped(); }
+
+    const SlinkRxStats& rxStats() const { return _rxStats; }
+
+    // Pulse classifier (learned widths, histograms). Runs on the RX task in
+    // task mode; reading its stats from loop() is fine, reconfigure it
+    // before startTask().
+    SlinkPulseClassifier&       classifier()       { return _classifier; }
+    const SlinkPulseClassifier& classifier() const { return _classifier; }
+
+    // Decoded frame events. Subscribers run on the caller of loop(); status
+    // events carry the reporting player in status.player. Subscribe before
+    // startTask()/loop().
+    SlinkDecoderEvents& events() { return _events; }
+
+    // Frames are dispatched once on (length, bytes 1-3); byte 0 is always
+    // 0x41 (anything else is one of our commands echoed back, see
+    // events().echo). Rules are tried in registration order within their
+    // length, the built-in frame types first. Register before
+    // startTask()/loop().
+    static constexpr uint32_t frameKey(uint8_t b1, uint8_t b2, uint8_t b3) {
+        return (uint32_t(b1) << 16) | (uint32_t(b2) << 8) | b3;
+    }
+    bool registerFrameHandler(uint8_t len, uint32_t key, uint32_t mask,
+                              SlinkFrameHandler fn, void* ctx = nullptr);
+
+    // A disc/track change is committed (and the status event fires) only
+    // once n of the last m track status frames from that player agree on
+    // it; with windowMs set, older frames don't count. Default 2 of 3.
+    void setConfirmation(uint8_t n, uint8_t m, uint32_t windowMs = 0);
+    const SlinkStatusStats& statusStats() const { return _statusStats; }
+
+    // Latest committed state for player 1..SLINK_MAX_PLAYERS
+    const SlinkTrackStatus& state(int player) const { return _states[player - 1]; }
 
-    // Pulse buffer for decoding
-    static const int MAX_PULSES = 256;
-    unsigned long _pulses[MAX_PULSES];
-    int _pulseCount = 0;
+private:
+    // pulse source
+    SlinkRmtCapture _rmtCapture;
+    SlinkCapture*   _capture;
+    int             _busId = 0;
+
+    // Streaming framer state (pulses are consumed in place from RMT items).
+    // A frame still open when a capture ends without an idle marker is
+    // carried over into the next capture.
+    enum RxPhase : uint8_t { RX_HUNT, RX_BITS };
+    RxPhase _rxPhase = RX_HUNT;
+    uint8_t _rxBytes[16];
+    int     _rxLen  = 0;
+    uint8_t _rxByte = 0;
+    int     _rxBits = 0;
+    bool    _rxOverrun = false;
+    bool    _rxCarried = false;
+    uint8_t _rxMinMargin = 100;
+    uint32_t _rxWidthSum[3];        // marks of the open frame, per pulse class
+    uint16_t _rxWidthCount[3];
+    unsigned long _rxClockUs = 0;   // wire time of the next pulse
+    unsigned long _rxFrameStartUs = 0;
+    unsigned long _rxFrameEndUs = 0;
+    unsigned long _handlingStartUs = 0; // wire start of the frame being handled
+    SlinkRxStats _rxStats;
+    SlinkPulseClassifier _classifier;
 
     // Frame accumulation
     unsigned long _lastRxTime = 0;
 
-    // last track signature
-    uint8_t             _lastSig[8];
-    bool                _haveLastSig = false;
-
-    // state
-    SlinkTrackStatus    _state;
-
-    // callbacks
-    SlinkStatusCallback    _statusCb = nullptr;
-    SlinkTransportCallback _transportCb = nullptr;
+    // RX task mode
+    static const int      FRAME_QUEUE_LEN = 16;
+    static const uint32_t RX_TASK_WAIT_MS = 100;
+    bool                  _taskMode = false;
+    SpscQueue<SlinkFrame, FRAME_QUEUE_LEN> _frameQueue;
+
+    // per-player committed state and recent disc/track observations
+    static const uint8_t MAX_CONFIRM_M = 8;
+    struct StatusObservation {
+        int16_t       disc;
+        int8_t        track;
+        unsigned long ms;
+    };
+    struct StatusHistory {
+        StatusObservation obs[MAX_CONFIRM_M];
+        uint8_t           next = 0;
+        uint8_t           count = 0;
+    };
+    SlinkTrackStatus    _states[SLINK_MAX_PLAYERS];
+    StatusHistory       _history[SLINK_MAX_PLAYERS];
+    uint8_t             _confirmN = 2;
+    uint8_t             _confirmM = 3;
+    uint32_t            _confirmWindowMs = 0;
+    SlinkStatusStats    _statusStats;
+
+    // Dispatch table: rules chained per frame length
+    static const int MAX_FRAME_RULES = 16;
+    static const int MAX_FRAME_LEN = 16;
+    struct FrameRule {
+        uint32_t          key;
+        uint32_t          mask;
+        SlinkFrameHandler fn;
+        void*             ctx;
+        int8_t            next;
+    };
+    FrameRule _rules[MAX_FRAME_RULES];
+    int       _numRules = 0;
+    int8_t    _ruleHead[MAX_FRAME_LEN + 1];
+    int8_t    _ruleTail[MAX_FRAME_LEN + 1];
+
+    SlinkDecoderEvents _events;
 
     // low-level helpers
-    void   _pollRmt();
-    void   _processFrame();
-    void   _decodeFrame();
-    char   _classifyPulse(unsigned long dt);
+    static void _rxTask(void* arg);
+    void   _pollCapture(uint32_t timeoutMs);
+    void   _resetFramer();
+    void   _feedPulse(uint32_t dt);
+    void   _startFrame();
+    void   _finishFrame();
+    void   _emitFrame(const uint8_t* bytes, int len, uint8_t confidence);
+    void   _deliverFrame(const SlinkFrame& frame);
 
     // frame handlers
+    template <bool (SlinkDecoder::*Handler)(const uint8_t*, int)>
+    static bool _member(void* ctx, const uint8_t* bytes, int len) {
+        return (static_cast<SlinkDecoder*>(ctx)->*Handler)(bytes, len);
+    }
     void   _handleFrame(const uint8_t* bytes, int len);
-    void   _handleTransportFrame(const uint8_t* bytes, int len);
-    void   _handleTrackStatusFrame(const uint8_t* bytes, int len);
-    void   _handleTimeStatusFrame(const uint8_t* bytes, int len);
-    void   _handleExtendedStatusFrame(const uint8_t* bytes, int len);
-    void   _handleHeartbeatFrame(const uint8_t* bytes, int len);
+    bool   _handleTransportFrame(const uint8_t* bytes, int len);
+    bool   _handleTrackStatusFrame(const uint8_t* bytes, int len);
+    bool   _confirmStatus(int player, int disc, int track);
+    bool   _handleTimeStatusFrame(const uint8_t* bytes, int len);
+    bool   _handleExtendedStatusFrame(const uint8_t* bytes, int len);
+    bool   _handleHeartbeatFrame(const uint8_t* bytes, int len);
     void   _handleOtherFrame(const uint8_t* bytes, int len);
-
-    // encoding/decoding helpers
-    uint16_t _encodeIndex(uint16_t n);
-    int      _decodeIndexFromCode(uint16_t code, uint16_t maxIndex);
-    int      _decodeTimeValue(uint8_t code);
-    int      _decodeTrackNumberFromIndex(int idx);
-    int      _decodeDiscNumber_1to200_FromIndex(int idx);
-    int      _decodeDiscNumber_201to300_FromIndex(int idx);
 };
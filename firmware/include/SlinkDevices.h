@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+
+// S-Link device addresses per player (changer).
+//
+// Each CX355 answers on two addresses, one per disc range. Adding another
+// changer is one row in PLAYERS plus bumping SLINK_MAX_PLAYERS; the decoder,
+// TX and backend state tables are all sized from it.
+
+#ifndef SLINK_MAX_PLAYERS
+#define SLINK_MAX_PLAYERS 2
+#endif
+
+// Independent S-Link buses (racks) one controller can serve; each has the
+// full player table above
+#ifndef SLINK_MAX_BUSES
+#define SLINK_MAX_BUSES 2
+#endif
+
+namespace SlinkDevices {
+
+struct PlayerAddress {
+    uint8_t rxLo;   // status/transport frames, discs 1-200
+    uint8_t rxHi;   // status frames, discs 201-300
+    uint8_t txLo;   // commands, discs 1-200
+    uint8_t txHi;   // commands, discs 201-300
+};
+
+inline constexpr PlayerAddress PLAYERS[SLINK_MAX_PLAYERS] = {
+    {0x40, 0x45, 0x90, 0x93},   // Player 1
+    {0x44, 0x51, 0x92, 0x95},   // Player 2
+};
+
+// Heartbeats (41 04 00 55) carry no player address; only the changer in
+// Command Mode 3 (low-range address 0x44) sends them
+inline constexpr uint8_t HEARTBEAT_DEVICE = 0x04;
+inline constexpr uint8_t MODE3_RX_LO = 0x44;
+
+// Device byte -> player number (1-based, 0 = unknown), high-range flag in bit 7
+struct DeviceTable {
+    uint8_t entry[256];
+
+    constexpr DeviceTable() : entry() {
+        for (int p = 0; p < SLINK_MAX_PLAYERS; ++p) {
+            entry[PLAYERS[p].rxLo] = (uint8_t)(p + 1);
+            entry[PLAYERS[p].rxHi] = (uint8_t)((p + 1) | 0x80);
+        }
+    }
+};
+
+inline constexpr DeviceTable DEVICES{};
+
+constexpr int playerForDevice(uint8_t dev) {
+    return DEVICES.entry[dev] & 0x7F;
+}
+
+constexpr bool isHighRange(uint8_t dev) {
+    return (DEVICES.entry[dev] & 0x80) != 0;
+}
+
+// Transport frames only come from the low-range address
+constexpr bool isTransportDevice(uint8_t dev) {
+    return playerForDevice(dev) != 0 && !isHighRange(dev);
+}
+
+constexpr uint8_t txDevice(int player, int disc) {
+    return disc > 200 ? PLAYERS[player - 1].txHi : PLAYERS[player - 1].txLo;
+}
+
+// Command address -> player number (0 = not a player address)
+constexpr int playerForTxDevice(uint8_t dev) {
+    for (int p = 0; p < SLINK_MAX_PLAYERS; ++p) {
+        if (PLAYERS[p].txLo == dev || PLAYERS[p].txHi == dev) return p + 1;
+    }
+    return 0;
+}
+
+// Player whose changer sends the heartbeat (0 = none configured in Mode 3)
+constexpr int heartbeatPlayer() {
+    for (int p = 0; p < SLINK_MAX_PLAYERS; ++p) {
+        if (PLAYERS[p].rxLo == MODE3_RX_LO) return p + 1;
+    }
+    return 0;
+}
+
+constexpr bool isValidPlayer(int player) {
+    return player >= 1 && player <= SLINK_MAX_PLAYERS;
+}
+
+constexpr bool isValidBus(int bus) {
+    return bus >= 0 && bus < SLINK_MAX_BUSES;
+}
+
+}  // namespace SlinkDevices
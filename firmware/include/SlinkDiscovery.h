@@ -0,0 +1,107 @@
+#pragma once
+
+#include "SlinkHal.h"
+#include "SlinkEvents.h"
+
+class SlinkTx;
+struct SlinkTxCompletion;
+
+// Protocol discovery on one bus, in the background: sends a probe per
+// step (one command to a range of device codes, or a range of command
+// codes to one device) and attributes what the changers say back.
+//
+// Before the first probe it listens for BASELINE_MS and remembers the kinds
+// of frame (length and bytes 1-3) that come anyway: heartbeats, time and
+// extended status frames. During the run a frame of such a kind is only
+// counted as ambient. Any other changer frame goes to the probe last put on
+// the wire before it started, with its delay; frames no decoder rule
+// claimed (the unknown channel) are flagged. A probe's window runs until the
+// next one goes out, stepMs after it.
+//
+// printResults() writes one CSV row per response (and one per probe that
+// got none).
+class SlinkDiscovery {
+public:
+    enum Mode : uint8_t { DEVICES = 0, COMMANDS };
+
+    static const int MAX_PROBES = 256;
+    static const int MAX_RESPONSES = 64;
+    static const int MAX_AMBIENT = 16;
+
+    // A changer frame attributed to a probe
+    struct Response {
+        uint8_t  probe;
+        uint8_t  len;
+        bool     unknown;       // no decoder rule claimed it
+        uint16_t afterMs;       // from the probe's start on the wire
+        uint8_t  bytes[16];
+    };
+
+    explicit SlinkDiscovery(SlinkTx& tx, int bus = 0);
+
+    // Decoder subscribers
+    void onTraffic(const SlinkTrafficEvent& ev);
+    void onUnknown(const SlinkUnknownFrameEvent& ev);
+
+    // Baseline, probes and the end of the run; call from loop()
+    void loop();
+
+    // cmd to each device code first..last
+    bool startDevices(uint8_t first, uint8_t last, uint8_t cmd, unsigned long stepMs = 500);
+    // Each command code first..last to device
+    bool startCommands(uint8_t device, uint8_t first, uint8_t last, unsigned long stepMs = 2000);
+    void stop();
+
+    bool active() const { return _phase != IDLE; }
+    int  probes() const { return _count; }
+    int  responses() const { return _responseCount; }
+    const Response& response(int i) const { return _responses[i]; }
+    uint8_t device(int probe) const { return _mode == DEVICES ? (uint8_t)(_first + probe) : _fixed; }
+    uint8_t command(int probe) const { return _mode == COMMANDS ? (uint8_t)(_first + probe) : _fixed; }
+
+    void printReport(Print& out) const;
+    void printResults(Print& out) const;
+
+private:
+    enum Phase : uint8_t { IDLE = 0, BASELINE, PROBING, DRAINING };
+
+    struct Probe {
+        uint8_t       state;        // PROBE_*
+        uint8_t       responses;
+        uint8_t       unknown;
+        uint8_t       ambient;
+    };
+    enum : uint8_t { PROBE_PENDING = 0, PROBE_QUEUED, PROBE_SENT, PROBE_NOT_SENT };
+
+    static const unsigned long BASELINE_MS = 3000;
+
+    SlinkTx&      _tx;
+    int           _bus;
+    Phase         _phase = IDLE;
+    Mode          _mode = DEVICES;
+    uint8_t       _fixed = 0;           // cmd (DEVICES) or device (COMMANDS)
+    uint8_t       _first = 0;
+    int           _count = 0;
+    int           _next = 0;            // next probe to queue
+    int           _current = -1;        // on the wire last
+    unsigned long _stepMs = 0;
+    unsigned long _phaseMs = 0;         // baseline start, or the last probe queued
+    unsigned long _currentUs = 0;       // when _current started on the wire
+
+    Probe    _probes[MAX_PROBES];
+    Response _responses[MAX_RESPONSES];
+    int      _responseCount = 0;
+    uint32_t _dropped = 0;              // responses beyond MAX_RESPONSES
+    uint32_t _ambient[MAX_AMBIENT];
+    int      _ambientCount = 0;
+    // What the last frame went to, for the unknown event that may follow
+    int      _last = -1;                // response kept
+    int      _lastProbe = -1;
+
+    bool _start(Mode mode, uint8_t fixed, uint8_t first, uint8_t last, unsigned long stepMs);
+    void _probe();
+    void _finish();
+    static uint32_t _kind(const uint8_t* bytes, int len);
+    bool _isAmbient(uint32_t kind) const;
+    static void _onSent(void* ctx, const SlinkTxCompletion& c);
+};
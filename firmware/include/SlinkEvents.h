@@ -0,0 +1,156 @@
+#pragma once
+
+#include <stdint.h>
+#include "SlinkHal.h"
+
+// Typed, multi-subscriber event channels.
+//
+// A subscriber is a plain function pointer plus a context pointer, or an
+// object and member function bound at compile time through a trampoline.
+// Subscribers live in a fixed array, so no allocation happens. emit()
+// passes the event by const reference to each subscriber in turn and
+// never copies it. A subscriber that doesn't fit is logged, not silently
+// lost: raise that channel's MaxSubscribers.
+
+template <typename Event, int MaxSubscribers = 4>
+class SlinkEventChannel {
+public:
+    typedef void (*Handler)(void* ctx, const Event& ev);
+
+    bool subscribe(Handler fn, void* ctx = nullptr) {
+        if (!fn) return false;
+        if (_count >= MaxSubscribers) {
+            Print& log = SlinkHal::log();
+            log.print(F("[EVENTS] Channel full ("));
+            log.print(MaxSubscribers);
+            log.println(F(" subscribers), subscriber dropped"));
+            return false;
+        }
+        _subs[_count++] = Subscriber{fn, ctx};
+        return true;
+    }
+
+    // channel.subscribe<Sync, &Sync::onStatus>(&sync)
+    template <typename T, void (T::*Method)(const Event&)>
+    bool subscribe(T* obj) {
+        return subscribe(&_thunk<T, Method>, obj);
+    }
+
+    void emit(const Event& ev) const {
+        for (uint8_t i = 0; i < _count; ++i) {
+            _subs[i].fn(_subs[i].ctx, ev);
+        }
+    }
+
+    bool empty() const { return _count == 0; }
+
+private:
+    struct Subscriber {
+        Handler fn;
+        void*   ctx;
+    };
+    Subscriber _subs[MaxSubscribers];
+    uint8_t    _count = 0;
+
+    template <typename T, void (T::*Method)(const Event&)>
+    static void _thunk(void* ctx, const Event& ev) {
+        (static_cast<T*>(ctx)->*Method)(ev);
+    }
+};
+
+// ---- Decoder events ----
+
+struct SlinkTrackStatus;
+
+// Transport frame: 41 XX 00 CC
+struct SlinkTransportEvent {
+    int     bus;
+    int     player;     // 1..SLINK_MAX_PLAYERS
+    uint8_t code;       // 0x00 play, 0x01 stop, 0x04 pause, others raw
+};
+
+// Track status frame (41 XX 11 00) that decoded, as heard: not yet
+// confirmed n of m, so the first one of a change comes before the status
+// event (if it ever commits)
+struct SlinkStatusFrameEvent {
+    int           bus;
+    int           player;     // 1..SLINK_MAX_PLAYERS
+    int           disc;
+    int           track;
+    unsigned long startUs;    // on the wire, as in SlinkTrafficEvent
+};
+
+// Time status frame: 41 XX 11 01 (elapsed time of the current track)
+struct SlinkTimeEvent {
+    int     bus;
+    int     player;     // 0 = unknown device
+    uint8_t device;
+    int     minutes;
+    int     seconds;
+};
+
+// Heartbeat frame: 41 04 00 55
+struct SlinkHeartbeatEvent {
+    int     bus;
+    uint8_t device;
+};
+
+// Extended status frame: 41 XX 15 00 + 10 bytes (disc in the player)
+struct SlinkLoadedDiscEvent {
+    int     bus;
+    int     player;
+    int     disc;       // 1..300
+};
+
+// Any frame from a known player, or a heartbeat (attributed to the
+// Command Mode 3 player). Fires before the frame's own event.
+struct SlinkActivityEvent {
+    int     bus;
+    int     player;     // 1..SLINK_MAX_PLAYERS
+    uint8_t device;
+    bool    heartbeat;
+};
+
+// Every decoded frame, a changer's or our own echo, with its span on the
+// wire (estimated from when the capture ended). Fires before any other
+// event for the frame. bytes is only valid during emit().
+struct SlinkTrafficEvent {
+    int            bus;
+    const uint8_t* bytes;
+    int            len;
+    unsigned long  startUs;
+    unsigned long  endUs;
+    bool           ours;       // byte 0 not 0x41
+};
+
+// A frame that isn't from a changer (byte 0 not 0x41): our own command as
+// it came back off the wire. Mean mark widths per class, 0 if the frame had
+// none. bytes is only valid during emit().
+struct SlinkEchoEvent {
+    int            bus;
+    const uint8_t* bytes;
+    int            len;
+    uint16_t       syncUs;
+    uint16_t       oneUs;
+    uint16_t       zeroUs;
+    unsigned long  rxMicros;
+};
+
+// Any frame no dispatch rule claimed. bytes is only valid during emit().
+struct SlinkUnknownFrameEvent {
+    const uint8_t* bytes;
+    int            len;
+};
+
+struct SlinkDecoderEvents {
+    SlinkEventChannel<SlinkTrackStatus, 6>    status;
+    SlinkEventChannel<SlinkStatusFrameEvent>  statusFrame;
+    SlinkEventChannel<SlinkTransportEvent, 6> transport;
+    SlinkEventChannel<SlinkTimeEvent>         time;
+    SlinkEventChannel<SlinkHeartbeatEvent>    heartbeat;
+    SlinkEventChannel<SlinkLoadedDiscEvent>   loaded;
+    SlinkEventChannel<SlinkActivityEvent>     activity;
+    SlinkEventChannel<SlinkTrafficEvent>      traffic;
+    SlinkEventChannel<SlinkEchoEvent>         echo;
+    SlinkEventChannel<SlinkUnknownFrameEvent> unknown;
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <Arduino.h>
+#include <driver/rmt.h>
+
+// Thin hardware abstraction layer.
+//
+// Everything the S-Link and backend code needs from the board goes through
+// here, so the same sources build for both environments:
+//   env:esp32dev -> src/SlinkHalEsp32.cpp  (RMT, GPIO, WiFi/HTTPClient, NVS, Serial)
+//   env:native   -> native/src/SlinkHalNative.cpp (virtual clock, injected
+//                   RMT captures, scripted HTTP, stdout log)
+
+namespace SlinkHal {
+
+// ---- Clock ----
+
+unsigned long nowMicros();
+unsigned long nowMillis();
+
+// ---- GPIO / timing sink ----
+
+void pinOutput(int pin);
+void pinWrite(int pin, bool high);
+void delayMicros(unsigned long us);
+void delayMillis(unsigned long ms);
+
+// ---- Tasks ----
+
+// Start fn(arg) in its own task pinned to core (-1 = no affinity).
+// fn must never return.
+bool startTask(void (*fn)(void*), void* arg, const char* name,
+               uint32_t stackBytes, int priority, int core);
+
+// ---- RMT ring-buffer source ----
+
+struct RmtRxConfig {
+    uint8_t  clkDiv;            // 80MHz / clkDiv = tick rate
+    uint8_t  memBlocks;         // 64 items per block
+    uint16_t idleThreshold;     // ticks of idle that end a capture
+    uint8_t  filterTicks;       // glitch filter (0 = off)
+    size_t   ringBufferBytes;   // driver ring buffer size
+};
+
+class RmtRx {
+public:
+    bool begin(int rxPin, rmt_channel_t channel, const RmtRxConfig& cfg);
+
+    // Borrow the next captured block of items. Returns nullptr if nothing
+    // arrived within timeoutMs (0 = poll). Must be handed back via release().
+    rmt_item32_t* receive(size_t* numItems, uint32_t timeoutMs);
+    void          release(rmt_item32_t* items);
+
+private:
+    rmt_channel_t _channel = RMT_CHANNEL_0;
+    void*         _ringbuf = nullptr;
+};
+
+// ---- RMT transmitter ----
+
+struct RmtTxConfig {
+    uint8_t  clkDiv;            // 80MHz / clkDiv = tick rate
+    uint8_t  memBlocks;         // 64 items per block
+};
+
+// Runs in interrupt context once the last item of a write() is out
+typedef void (*RmtTxDone)(void* arg);
+
+class RmtTx {
+public:
+    // The pin idles low between writes
+    bool begin(int txPin, rmt_channel_t channel, const RmtTxConfig& cfg,
+               RmtTxDone onDone = nullptr, void* arg = nullptr);
+
+    // Start sending items, ending at a zero-duration item, and return at
+    // once. items must stay valid until done. false if still busy.
+    bool write(const rmt_item32_t* items, size_t numItems);
+
+    // Block until the current write is out; false on timeout
+    bool waitDone(uint32_t timeoutMs);
+
+private:
+    rmt_channel_t _channel = RMT_CHANNEL_0;
+    int           _pin = -1;
+};
+
+// ---- GPIO edge capture ----
+
+// onEdge(arg, us) runs in interrupt context on every level change of pin,
+// with the edge time taken at ISR entry. onIdle(arg) runs once the line has
+// been quiet for idleUs after the last edge (hardware timer). Both are
+// installed on the calling core and never nest; keep them in IRAM. Only one
+// edge capture can be active.
+typedef void (*EdgeIsr)(void* arg, unsigned long us);
+typedef void (*IdleIsr)(void* arg);
+bool edgeCaptureBegin(int pin, uint32_t idleUs, EdgeIsr onEdge, IdleIsr onIdle, void* arg);
+
+// ---- Line activity ----
+
+// Watches an input pin from its edge interrupt, to tell whether the bus is
+// in use. Shares the interrupt with edge capture on the same pin.
+class LineMonitor {
+public:
+    bool begin(int pin);
+    bool active() const { return _pin >= 0; }
+
+    // Line pulled low by someone right now (RX pin high)
+    bool          mark() const;
+    unsigned long lastEdgeUs() const;
+    // Edges in (fromUs, toUs], as far back as the edge history goes
+    uint32_t      edgesBetween(unsigned long fromUs, unsigned long toUs) const;
+
+    // From the pin interrupt
+    void IRAM_ATTR edge(unsigned long us);
+
+private:
+    static const int HISTORY = 128;     // a 4-byte frame is 66 edges
+    int                    _pin = -1;
+    volatile uint32_t      _edges = 0;
+    volatile unsigned long _history[HISTORY] = {};
+};
+
+// ---- Network / HTTP transport ----
+
+// IPv4 addresses are packed as a.b.c.d -> (a << 24) | (b << 16) | (c << 8) | d
+bool     netBegin(const char* ssid, const char* password, unsigned long timeoutMs);
+bool     netConnected();
+void     netReconnect();
+uint32_t netLocalIp();
+
+bool     mdnsBegin(const char* hostname);
+// Returns number of instances found; first one's address/port written out
+int      mdnsQueryService(const char* service, const char* proto, uint32_t* ip, int* port);
+uint32_t mdnsQueryHost(const char* hostname, unsigned long timeoutMs);
+
+// Return the HTTP status code, or a negative HTTPClient error code
+int httpPost(const char* url, const char* json, unsigned long timeoutMs);
+int httpGet(const char* url, char* response, size_t maxLen, unsigned long timeoutMs);
+
+// ---- Persistent storage ----
+
+// Small blobs that survive a reset (NVS on the ESP32, memory on the host).
+// storeLoad() is false unless a blob of exactly len bytes is stored under
+// key. Flash wears: save seldom.
+bool storeLoad(const char* key, void* data, size_t len);
+bool storeSave(const char* key, const void* data, size_t len);
+
+// ---- Log sink ----
+
+Print& log();
+
+}  // namespace SlinkHal
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "SlinkDecoder.h"
+
+// Which of the 300 slots of each changer on one bus hold a disc.
+//
+// Two bitsets per player, bit (disc - 1) % 8 of byte (disc - 1) / 8:
+// known (we have evidence either way) and loaded. A slot becomes known
+// loaded when an extended status frame reports it as the player's loaded
+// disc, or a committed track status plays from it; setSlot() records
+// results from elsewhere (a failed play, a scan). A player's bitsets are
+// marked dirty on any change so they can be synced as a whole.
+class SlinkInventory {
+public:
+    enum Slot : uint8_t { UNKNOWN = 0, LOADED, EMPTY };
+
+    static const int SLOTS = 300;
+    static const int BITSET_BYTES = (SLOTS + 7) / 8;
+
+    explicit SlinkInventory(int bus = 0);
+
+    // Decoder subscribers
+    void onLoaded(const SlinkLoadedDiscEvent& ev);
+    void onStatus(const SlinkTrackStatus& st);
+
+    void setSlot(int player, int disc, bool loaded);
+    Slot slot(int player, int disc) const;
+    int  count(int player, Slot s) const;
+
+    const uint8_t* knownBits(int player) const  { return _players[player - 1].known; }
+    const uint8_t* loadedBits(int player) const { return _players[player - 1].loaded; }
+
+    bool dirty(int player) const { return _players[player - 1].dirty; }
+    void clearDirty(int player)  { _players[player - 1].dirty = false; }
+
+    void printReport(Print& out) const;
+
+private:
+    struct Player {
+        uint8_t known[BITSET_BYTES] = {};
+        uint8_t loaded[BITSET_BYTES] = {};
+        bool    dirty = false;
+    };
+
+    int    _bus;
+    Player _players[SLINK_MAX_PLAYERS];
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "SlinkHal.h"
+#include "SlinkDevices.h"
+#include "SlinkEvents.h"
+
+class SlinkDecoder;
+class SlinkTx;
+class SlinkInventory;
+class SlinkSeekProfile;
+
+// Full catalogue scan of one bus: plays every slot of each changer and
+// records whether it holds a disc.
+//
+// Each player walks its slots upwards, one play disc at a time, so every
+// step is the shortest carousel move. The players run independently: one
+// turns its carousel while the other reports, and the next slot goes out
+// the moment a player has answered. A slot is loaded at the first status
+// frame for it from that player (not waiting for n-of-m confirmation; the
+// track it names is kept as the first track). It is empty if the player,
+// having reacted (0x40 while it turns the carousel; play and near end may
+// still be the slot before), stops or reports another disc, or nothing comes
+// by the deadline: the load time the seek profile predicts plus
+// DEADLINE_MARGIN_MS, DEADLINE_MS without a prediction. A play disc the
+// player doesn't react to within RESEND_MS is resent; after MAX_ATTEMPTS
+// that player's scan stops where it is.
+//
+// Results go into the slot inventory as they come in. Progress and results
+// are saved to flash every SAVE_EVERY slots, so an interrupted scan resumes
+// where it was saved (start() with resume). The results themselves are
+// uploaded in batches (uploadDue(), markSent()).
+class SlinkInventoryScan {
+public:
+    static const int SLOTS = 300;
+    static const int UPLOAD_BATCH = 50;
+
+    struct Result {
+        uint8_t  state;         // SlinkInventory::Slot
+        uint8_t  firstTrack;    // reported when it loaded, 0 = none
+        uint16_t loadMs;        // play disc to the first status frame
+    };
+
+    SlinkInventoryScan(SlinkTx& tx, const SlinkDecoder& decoder, SlinkInventory& inventory,
+                       const SlinkSeekProfile& seek, int bus = 0);
+
+    // Load saved progress
+    void begin();
+
+    // Decoder subscribers
+    void onStatusFrame(const SlinkStatusFrameEvent& ev);
+    void onTransport(const SlinkTransportEvent& ev);
+
+    // Next slots, resends, deadlines and saving; call from loop()
+    void loop();
+
+    // Scan the players in mask (bit player - 1). resume carries on from
+    // the saved progress of each (players already done are skipped),
+    // otherwise they start over from slot 1.
+    bool start(uint8_t players, bool resume);
+    void stop();
+
+    bool active() const;
+    // A saved scan that didn't finish
+    bool resumable() const;
+
+    // Next slot to scan, SLOTS + 1 when done
+    int next(int player) const { return _players[player - 1].next; }
+    const Result& result(int player, int disc) const { return _results[player - 1][disc - 1]; }
+
+    // Results not uploaded yet, from *fromDisc: due once UPLOAD_BATCH have
+    // come in, or the player's scan has ended
+    bool uploadDue(int player, int* fromDisc, int* count) const;
+    void markSent(int player, int count);
+
+    void printReport(Print& out) const;
+
+private:
+    struct Player {
+        bool          scanning;
+        bool          waiting;      // play disc out for slot next
+        bool          heard;        // the player reacted to it
+        uint8_t       attempts;
+        int16_t       next;
+        int16_t       sent;         // first slot not uploaded
+        int16_t       from;         // carousel position before the play disc
+        uint16_t      unsaved;
+        unsigned long sentMs;
+        unsigned long deadlineMs;
+        unsigned long startMs;
+        unsigned long elapsedMs;    // scanning time, over resumes
+    };
+    // The flash blob
+    struct Stored {
+        uint32_t magic;
+        uint8_t  scanning;          // mask of players not finished
+        int16_t  next[SLINK_MAX_PLAYERS];
+        int16_t  sent[SLINK_MAX_PLAYERS];
+        uint32_t elapsedMs[SLINK_MAX_PLAYERS];
+        Result   results[SLINK_MAX_PLAYERS][SLOTS];
+    };
+
+    static const uint32_t      STORE_MAGIC = 0x494E5331;    // "INS1", bump on layout change
+    static const unsigned long RESEND_MS = 1500;
+    static const uint8_t       MAX_ATTEMPTS = 3;
+    static const unsigned long DEADLINE_MS = 20000;
+    static const unsigned long DEADLINE_MARGIN_MS = 1500;
+    static const uint16_t      SAVE_EVERY = 10;
+
+    SlinkTx&                _tx;
+    const SlinkDecoder&     _decoder;
+    SlinkInventory&         _inventory;
+    const SlinkSeekProfile& _seek;
+    int                     _bus;
+    char                    _key[8];
+    Player                  _players[SLINK_MAX_PLAYERS];
+    Result                  _results[SLINK_MAX_PLAYERS][SLOTS];
+    uint8_t                 _interrupted = 0;   // saved mask, until started
+
+    void _send(int player);
+    void _record(int player, uint8_t state, int track);
+    void _end(int player, bool finished);
+    void _save();
+};
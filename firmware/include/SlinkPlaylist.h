@@ -0,0 +1,108 @@
+#pragma once
+
+#include "SlinkHal.h"
+#include "SlinkDevices.h"
+#include "SlinkEvents.h"
+
+class SlinkDecoder;
+class SlinkTx;
+struct SlinkTrackStatus;
+
+struct SlinkPlaylistEntry {
+    uint8_t player;     // 1..SLINK_MAX_PLAYERS
+    int16_t disc;       // 1-300
+    uint8_t track;      // to start from (0 = first)
+    uint8_t tracks;     // on the disc, 0 = unknown
+};
+
+// Play queue of whole discs across the players of one bus.
+//
+// The current entry plays on its player. Once that player reaches the
+// disc's last track (at once if the track count is unknown), the next
+// entry is pre-positioned when it is on another player: play disc, then
+// pause as soon as that changer reacts, so it turns the carousel and
+// waits paused at the start of the disc. When the current disc ends (its
+// player reports stop, or moves on to another disc by itself, which is
+// then stopped) the ready player is resumed with a single pause toggle.
+// The gap is one command round-trip instead of a whole carousel seek.
+// A next entry on the same player, or one whose pre-positioning failed,
+// starts cold with play disc.
+//
+// A stop on the current player before its last track is the user's doing
+// and ends the queue.
+class SlinkPlaylist {
+public:
+    static const int MAX_ENTRIES = 32;
+
+    SlinkPlaylist(SlinkTx& tx, const SlinkDecoder& decoder);
+
+    // Decoder subscribers
+    void onStatus(const SlinkTrackStatus& st);
+    void onTransport(const SlinkTransportEvent& ev);
+
+    // Timeouts; call from loop()
+    void loop();
+
+    // Replace the queue (entries beyond MAX_ENTRIES are dropped); start
+    // plays the first entry now
+    int  load(const SlinkPlaylistEntry* entries, int count, bool start = true);
+    bool start();
+    void clear();
+
+    bool active() const { return _active; }
+    int  size() const { return _count; }
+    int  position() const { return _current; }
+    // Track count of a queued disc, 0 if unknown or not queued
+    int  tracks(int player, int disc) const;
+
+    // Between discs: current player's end to the next one playing
+    uint32_t handovers() const { return _handovers; }
+    uint32_t warmHandovers() const { return _warm; }
+    uint32_t lastGapMs() const { return _lastGapMs; }
+    uint32_t maxGapMs() const { return _maxGapMs; }
+
+    void printReport(Print& out) const;
+
+private:
+    enum Prep : uint8_t {
+        PREP_NONE = 0,
+        PREP_LOADING,       // play disc sent, waiting for the changer to react
+        PREP_PAUSING,       // pause sent
+        PREP_READY,         // paused on the disc
+        PREP_FAILED,        // start it cold
+    };
+
+    static const unsigned long PREP_TIMEOUT_MS = 30000;
+    static const uint8_t       MAX_PAUSES = 3;
+
+    SlinkTx&            _tx;
+    const SlinkDecoder& _decoder;
+    SlinkPlaylistEntry  _entries[MAX_ENTRIES];
+    int                 _count = 0;
+    int                 _current = 0;
+    bool                _active = false;
+    bool                _started = false;   // current player reported its disc playing
+    bool                _onLastTrack = false;
+
+    Prep          _prep = PREP_NONE;
+    bool          _prepOnDisc = false;  // the changer reported the disc
+    bool          _prepPaused = false;
+    uint8_t       _prepPauses = 0;
+    unsigned long _prepSinceMs = 0;
+
+    // Handover in progress: the next player hasn't reported play yet
+    bool          _handingOver = false;
+    unsigned long _endMs = 0;
+
+    uint32_t _handovers = 0;
+    uint32_t _warm = 0;
+    uint32_t _lastGapMs = 0;
+    uint32_t _maxGapMs = 0;
+
+    const SlinkPlaylistEntry* _next() const;
+    void _play(const SlinkPlaylistEntry& e);
+    void _prepare();
+    void _pause(int player);
+    void _handover(bool stopCurrent);
+    void _check();
+};
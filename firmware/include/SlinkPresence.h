@@ -0,0 +1,84 @@
+#pragma once
+
+#include "SlinkHal.h"
+#include "SlinkDevices.h"
+#include "SlinkEvents.h"
+
+struct SlinkPresenceEvent;
+
+// Per-player presence on one bus, from frame activity.
+//
+//   UNKNOWN      nothing heard since boot (or since a power-on command)
+//   ONLINE       a frame from the player within its timeout
+//   OFFLINE      silent for longer than its timeout
+//   POWERED_OFF  we sent it power-off and it has stayed quiet since
+//
+// Only the Command Mode 3 changer heartbeats, so only its silence is
+// meaningful by default; the others only talk when their state changes and
+// never time out unless an activity timeout is set.
+//
+// Installed as the bus transmitter's gate: commands to an OFFLINE or
+// POWERED_OFF player are dropped (power-on always goes out).
+class SlinkPresence {
+public:
+    enum State : uint8_t { UNKNOWN = 0, ONLINE, OFFLINE, POWERED_OFF };
+
+    explicit SlinkPresence(int bus = 0);
+
+    // heartbeatMs: silence after which the heartbeating player is offline
+    // activityMs:  same for the other players (0 = never)
+    void setTimeouts(uint32_t heartbeatMs, uint32_t activityMs);
+
+    // Decoder activity subscriber
+    void onActivity(const SlinkActivityEvent& ev);
+
+    // Applies timeouts; call from loop()
+    void loop();
+
+    State state(int player) const { return _players[player - 1].state; }
+    unsigned long lastSeenMs(int player) const { return _players[player - 1].lastSeenMs; }
+
+    // Whether commands to this player go onto the bus
+    bool accepts(int player) const;
+
+    // SlinkTxGate
+    static bool txGate(void* ctx, uint8_t device, uint8_t cmd);
+
+    static const char* stateName(State s);
+
+    // Fires on every state change
+    SlinkEventChannel<SlinkPresenceEvent>& changed() { return _changed; }
+
+    void printReport(Print& out) const;
+
+private:
+    struct Player {
+        State         state = UNKNOWN;
+        unsigned long lastSeenMs = 0;
+        unsigned long powerOffMs = 0;
+        uint32_t      frames = 0;
+        uint32_t      heartbeats = 0;
+    };
+
+    int      _bus;
+    Player   _players[SLINK_MAX_PLAYERS];
+    uint32_t _heartbeatTimeoutMs = 15000;   // heartbeats come every few seconds
+    uint32_t _activityTimeoutMs = 0;
+
+    // Frames right after power-off (the changer's own stop report) don't
+    // count as it being on
+    static const unsigned long POWER_OFF_GRACE_MS = 3000;
+
+    SlinkEventChannel<SlinkPresenceEvent> _changed;
+
+    uint32_t _timeout(int player) const;
+    void     _set(int player, State s);
+};
+
+// Presence change of one player
+struct SlinkPresenceEvent {
+    int                  bus;
+    int                  player;
+    SlinkPresence::State state;
+    SlinkPresence::State previous;
+};
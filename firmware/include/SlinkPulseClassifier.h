@@ -0,0 +1,75 @@
+#pragma once
+
+#include "SlinkHal.h"
+#include "SlinkDevices.h"
+
+// Per-class timing statistics
+struct SlinkPulseClassStats {
+    uint32_t count = 0;
+    uint16_t minUs = 0xFFFF;
+    uint16_t maxUs = 0;
+    uint16_t centerUs = 0;          // current learned width
+    uint8_t  minMargin = 100;       // worst margin seen (%)
+    uint16_t hist[16] = {};         // 50µs bins, centerUs-400 .. centerUs+400
+};
+
+// Self-calibrating S-Link pulse classifier.
+//
+// Starts from the nominal widths (sync 2400, one 1200, zero 600 µs) with
+// windows that reproduce the old fixed thresholds exactly, then follows
+// drift by averaging the widths of confidently classified pulses inside
+// frames. Every classification also reports its margin: how far the pulse
+// sat from the window edge on its side, as % of the center-to-edge distance.
+class SlinkPulseClassifier {
+public:
+    enum Class : uint8_t { ZERO = 0, ONE = 1, SYNC = 2, NUM_CLASSES = 3 };
+
+    SlinkPulseClassifier();
+
+    void reset();
+
+    // false = fixed windows (the pre-calibration behaviour)
+    void setAdaptive(bool adaptive) { _adaptive = adaptive; }
+    bool isAdaptive() const { return _adaptive; }
+
+    // Returns 'Y' sync, 'L' one, 'S' zero, 'G' huge gap or '?' unknown
+    char classify(uint32_t dt, uint8_t* marginPct);
+
+    // Feed back a pulse that was used inside a frame
+    void learn(char symbol, uint32_t dt, uint8_t marginPct);
+
+    // Frame boundaries, for per-player width averages
+    void frameBegin();
+    void frameEnd(int player);
+
+    // Frames whose worst pulse margin was below this are low confidence
+    static const uint8_t LOW_CONFIDENCE_PCT = 20;
+
+    const SlinkPulseClassStats& stats(Class c) const { return _stats[c]; }
+    uint16_t playerWidthUs(int player, Class c) const { return _playerWidth[player - 1][c]; }
+
+    void printReport(Print& out) const;
+
+private:
+    bool     _adaptive = true;
+
+    // Learned centers in 1/16 µs
+    int32_t  _centerX16[NUM_CLASSES];
+
+    // Window edges derived from the centers
+    uint32_t _zeroOneUs;
+    uint32_t _oneSyncUs;
+    uint32_t _syncMaxUs;
+
+    SlinkPulseClassStats _stats[NUM_CLASSES];
+
+    // Current frame sums and per-player averages
+    uint32_t _frameSum[NUM_CLASSES];
+    uint16_t _frameCount[NUM_CLASSES];
+    uint16_t _playerWidth[SLINK_MAX_PLAYERS][NUM_CLASSES];
+
+    static const int LEARN_SHIFT = 5;   // EWMA weight 1/32
+
+    void     _updateWindows();
+    uint8_t  _margin(uint32_t dt, uint32_t lo, int c, uint32_t hi) const;
+};
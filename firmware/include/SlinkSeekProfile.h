@@ -0,0 +1,125 @@
+#pragma once
+
+#include "SlinkHal.h"
+#include "SlinkDevices.h"
+#include "SlinkEvents.h"
+
+class SlinkDecoder;
+class SlinkTx;
+class SlinkInventory;
+
+// How long each changer on one bus takes to load a disc, by carousel
+// distance.
+//
+// Every play disc we send is timed from the end of its frame on the wire
+// (our own traffic, heard back) to the first track status frame from that
+// player for the requested disc, before n-of-m confirmation. A repeat of
+// the same command restarts the clock: the changer evidently didn't act on
+// the first. The from slot is the player's committed disc when the frame
+// went out; without one there is no sample.
+//
+// The 300 x 300 (from, to) pairs are folded into the distance the carousel
+// turns, the shorter way round (0 = same disc, a track seek; at most 150),
+// in buckets of SLOTS_PER_BUCKET. Each bucket keeps a running mean that
+// turns into a moving average after AVERAGE_OVER samples, and a line fitted
+// through the buckets covers distances not measured yet. The model is
+// saved to flash at most every SAVE_INTERVAL_MS and loaded by begin().
+//
+// A sweep (startSweep()) plays discs at spread distances one after the
+// other to fill the model, using the slot inventory to pick loaded slots.
+class SlinkSeekProfile {
+public:
+    static const int SLOTS = 300;
+    static const int SLOTS_PER_BUCKET = 10;
+    static const int BUCKETS = 1 + (SLOTS / 2 + SLOTS_PER_BUCKET - 1) / SLOTS_PER_BUCKET;
+
+    SlinkSeekProfile(const SlinkDecoder& decoder, int bus = 0);
+
+    // Load the saved model
+    void begin();
+
+    // Decoder subscribers
+    void onTraffic(const SlinkTrafficEvent& ev);
+    void onStatusFrame(const SlinkStatusFrameEvent& ev);
+
+    // Timeouts, sweep steps and saving; call from loop()
+    void loop();
+
+    // Predicted load time in ms, 0 if the model has nothing for it yet
+    uint32_t predictMs(int player, int fromDisc, int toDisc) const;
+
+    // Carousel distance between two slots (0-150)
+    static int distance(int fromDisc, int toDisc);
+
+    // Line through the measured buckets: ms = baseMs + msPerSlot * distance.
+    // false until two buckets beyond distance 0 have samples.
+    bool fit(int player, float* baseMs, float* msPerSlot) const;
+
+    const uint16_t* meanMs(int player) const  { return _players[player - 1].meanMs; }
+    const uint16_t* samples(int player) const { return _players[player - 1].samples; }
+    uint32_t        sampleCount(int player) const;
+
+    // Changed since the backend last had it
+    bool dirty(int player) const { return _players[player - 1].dirty; }
+    void clearDirty(int player)  { _players[player - 1].dirty = false; }
+
+    // Play count discs on player, one at a time, each SWEEP_STEPS distance
+    // on from the last (needs the transmitter and, optionally, inventory)
+    bool startSweep(SlinkTx& tx, const SlinkInventory* inventory, int player, int count);
+    void stopSweep() { _sweepLeft = 0; }
+    bool sweeping() const { return _sweepLeft > 0; }
+
+    // Forget every sample (and the saved model)
+    void reset();
+    bool save();
+
+    void printReport(Print& out) const;
+
+private:
+    struct Player {
+        uint16_t meanMs[BUCKETS];
+        uint16_t samples[BUCKETS];
+        bool     dirty;
+    };
+    // The flash blob
+    struct Stored {
+        uint32_t magic;
+        uint16_t meanMs[SLINK_MAX_PLAYERS][BUCKETS];
+        uint16_t samples[SLINK_MAX_PLAYERS][BUCKETS];
+    };
+    // Play disc on the wire, waiting for the player to report the disc
+    struct Timing {
+        bool          active;
+        int16_t       fromDisc;
+        int16_t       toDisc;
+        unsigned long sentUs;
+    };
+
+    static const uint32_t      STORE_MAGIC = 0x534B5031;    // "SKP1", bump on layout change
+    static const uint16_t      AVERAGE_OVER = 8;
+    static const uint16_t      MIN_SAMPLES = 2;             // in a bucket before it beats the fit
+    static const uint32_t      SAMPLE_TIMEOUT_MS = 30000;
+    static const unsigned long SAVE_INTERVAL_MS = 60000;
+    static const unsigned long SWEEP_SETTLE_MS = 2000;      // after a sample, before the next step
+    static const int           SWEEP_STEPS[];
+    static const int           NUM_SWEEP_STEPS;
+
+    const SlinkDecoder& _decoder;
+    int           _bus;
+    char          _key[8];
+    Player        _players[SLINK_MAX_PLAYERS];
+    Timing        _timing[SLINK_MAX_PLAYERS];
+    bool          _unsaved = false;
+    unsigned long _lastSaveMs = 0;
+
+    SlinkTx*              _sweepTx = nullptr;
+    const SlinkInventory* _sweepInventory = nullptr;
+    int8_t                _sweepPlayer = 0;
+    int16_t               _sweepLeft = 0;
+    uint8_t               _sweepStep = 0;
+    unsigned long         _sweepNextMs = 0;
+
+    static int _bucket(int distance);
+    void _add(int player, int distance, uint32_t ms);
+    void _sweepNext(unsigned long now);
+};
@@ -1,6 +1,9 @@
 #pragma once
 
-#include <Arduino.h>
+#include "SlinkHal.h"
+#include "SlinkDevices.h"
+#include "SlinkEvents.h"
+#include "SlinkPulseClassifier.h"
 
 // Device addresses for sending commands
 // Player 1
@@ -21,47 +24,331 @@
 #define SLINK_CMD_POWER_ON      0x2E
 #define SLINK_CMD_POWER_OFF     0x2F
 
+// Decides whether a command may go onto the bus (see SlinkTx::setGate)
+typedef bool (*SlinkTxGate)(void* ctx, uint8_t device, uint8_t cmd);
+
+// One queued command, done with: on the wire, folded into a queued command
+// that carries it there, or dropped unsent because a later command
+// superseded it or a more urgent one evicted it
+struct SlinkTxCompletion {
+    uint8_t       device;
+    uint8_t       cmd;
+    bool          sent;
+    uint8_t       retries;      // resent after a collision
+    unsigned long queuedUs;     // sendAsync() called
+    unsigned long startUs;      // handed to the RMT channel (0 if not sent)
+    unsigned long doneUs;       // last item out (echo back, if verified), or dropped
+    bool          verified;     // our own echo came back intact
+    uint8_t       bitErrors;    // in the last echo that came back
+    uint32_t      echoUs;       // frame start to echo received (0 if none)
+    bool          coalesced;    // sent as part of another command, no frame of its own
+};
+
+// Queue order: lower goes first, FIFO within a priority
+enum SlinkTxPriority : uint8_t {
+    SLINK_TX_URGENT = 0,        // stop, pause, power
+    SLINK_TX_SELECT,            // play, play disc
+    SLINK_TX_BROWSE,            // next/previous track, anything else
+};
+
+// Whether a frame of durationUs starting at startUs is expected to miss
+// other traffic; if not, clearAtUs is when to try again
+typedef bool (*SlinkTxSlotCheck)(void* ctx, unsigned long startUs, uint32_t durationUs,
+                                 unsigned long* clearAtUs);
+
+// Where a player is now: fill in disc/track and the disc's track count (0 =
+// unknown), and return true if known
+typedef bool (*SlinkTxPositionSource)(void* ctx, int player, int* disc, int* track, int* tracks);
+
+struct SlinkTxStats {
+    uint32_t queued     = 0;    // commands accepted into the queue
+    uint32_t sent       = 0;    // frames put on the wire
+    uint32_t coalesced  = 0;    // merged into a queued command (no frame of their own)
+    uint32_t superseded = 0;    // queued commands dropped by a later one
+    uint32_t evicted    = 0;    // dropped for a more urgent command, queue full
+    uint32_t rejected   = 0;    // refused, queue full of more urgent commands
+    uint32_t skipsResolved = 0; // multi-track skips sent as one play disc
+    uint8_t  maxDepth   = 0;
+    uint32_t started    = 0;    // commands that reached the wire
+    uint32_t maxWaitUs  = 0;    // queued until first on the wire
+    uint64_t totalWaitUs = 0;
+    uint64_t busUs      = 0;    // wire time of all frames sent
+
+    // Carrier sense
+    uint32_t lineWaits  = 0;    // commands that found the line busy
+    uint32_t forced     = 0;    // sent anyway, line never went idle
+    uint32_t collisions = 0;    // frames someone else talked over
+    uint32_t retries    = 0;    // frames sent again for a collision
+    uint32_t maxLineWaitUs = 0;
+    uint32_t deferred   = 0;    // commands held back for predicted traffic
+    uint32_t maxDeferUs = 0;
+
+    // Echo verification
+    uint32_t echoes     = 0;    // frames that came back intact
+    uint32_t mangled    = 0;    // came back with bit errors
+    uint32_t lost       = 0;    // never came back
+    uint32_t echoRetries = 0;   // frames sent again for a bad or missing echo
+    uint32_t bitErrors  = 0;
+    uint32_t maxEchoUs  = 0;    // frame start to echo received
+    uint64_t totalEchoUs = 0;
+};
+
+// Runs from SlinkTx::loop() (or flush()), not from the interrupt
+typedef void (*SlinkTxDone)(void* ctx, const SlinkTxCompletion& c);
+
+// Pulse widths and idle gaps of a transmitted frame (µs)
+struct SlinkTxTiming {
+    uint16_t syncUs      = 2400;
+    uint16_t oneUs       = 1200;
+    uint16_t zeroUs      = 600;
+    uint16_t delimiterUs = 600;
+    uint16_t leadInUs    = 5000;    // line left idle before each frame (no carrier sense)
+    uint16_t trailUs     = 2000;    // and after it
+};
+
+// S-Link transmitter on an RMT TX channel.
+//
+// Commands wait in a small queue ordered by priority. The one at the head
+// is encoded into RMT items (idle gaps included) and the RMT hardware
+// clocks it out while the CPU carries on; loop() starts the next one when
+// the channel reports the end. The command methods below are blocking by
+// default (queue, then flush()), so they behave as before; with
+// setBlocking(false) they return as soon as the command is queued.
+//
+// While queued, commands to the same player coalesce so that the user's
+// intent reaches the changer in the fewest frames:
+//   next/previous   add up into a net skip (cancelling out entirely), or
+//                   move the track of a queued play disc; a forward skip
+//                   of more than one track goes out as a single play disc
+//                   when the position source knew the track it started from
+//                   and the disc has the target track (past the last one
+//                   the changer moves on or stops, so that steps)
+//   play disc       replaces a queued play disc, play or skip
+//   stop            drops a queued play, play disc or skip
+//   play, stop,     duplicates are dropped
+//   power on/off
+// Pause is a toggle and never coalesces. Commands with different
+// completion callbacks are not merged. A next/previous with the same
+// callback but its own context is (unless it would cancel the skip out),
+// and completes at once as coalesced.
+//
+// With carrier sense (setCarrierSense(rxPin)) a frame only starts once the
+// RX line has been idle for LINE_READY_US plus a random backoff, instead of
+// after a blind lead-in. Edges seen during our marks that aren't our own
+// mean someone talked over us; the frame is sent again, up to MAX_RETRIES
+// times, with the backoff window doubling each time. A slot check
+// (setSlotCheck(), normally SlinkBusLoad) can also hold a frame back from
+// a window where a changer's periodic frame is predicted.
+//
+// Every frame we send is heard again by our own RX side (onEcho()). Once
+// echoes have been seen, a frame only completes when its echo is back:
+// an echo with bit errors, or none within ECHO_TIMEOUT_US, sends it again
+// (same retry budget), except for next/previous/pause, which would act
+// twice. Intact echoes also calibrate the transmitter: the mark widths
+// measured on the way back are steered onto the nominal timing.
 class SlinkTx {
 public:
-    explicit SlinkTx(int txPin);
+    explicit SlinkTx(int txPin, rmt_channel_t channel = RMT_CHANNEL_2);
 
     void begin();
 
+    // Starts queued commands and runs completion callbacks
+    void loop();
+
+    // Every send returns false if the gate held the command back
+
     // Basic transport commands (affect currently selected player/disc)
-    void play();
-    void stop();
-    void pause();
-    void nextTrack();
-    void prevTrack();
-    void powerOn();
-    void powerOff();
+    bool play();
+    bool stop();
+    bool pause();
+    bool nextTrack();
+    bool prevTrack();
+    bool powerOn();
+    bool powerOff();
 
     // Play specific disc/track on specific player
     // player: 1 or 2
     // disc: 1-300
     // track: 1-99 (0 = first track)
-    void playDisc(int player, int disc, int track = 0);
+    bool playDisc(int player, int disc, int track = 0);
 
     // Low-level: send arbitrary command
-    void sendCommand(uint8_t device, uint8_t cmd);
-    void sendCommand(uint8_t device, uint8_t cmd, uint8_t param1);
-    void sendCommand(uint8_t device, uint8_t cmd, uint8_t param1, uint8_t param2);
+    bool sendCommand(uint8_t device, uint8_t cmd);
+    bool sendCommand(uint8_t device, uint8_t cmd, uint8_t param1);
+    bool sendCommand(uint8_t device, uint8_t cmd, uint8_t param1, uint8_t param2);
+
+    // Queue a 2-4 byte command (device, cmd, params) and return at once.
+    // done(ctx, ...) runs from loop() once it is on the wire (and, when
+    // verifying, its echo is back). false if the gate held it back or the
+    // queue is full.
+    bool sendAsync(const uint8_t* bytes, int len,
+                   SlinkTxDone done = nullptr, void* ctx = nullptr);
+
+    // Block until every queued command is on the wire. Doesn't wait for
+    // echoes: they arrive through the decoder's loop().
+    void flush();
+
+    void setBlocking(bool blocking) { _blocking = blocking; }
+    int  pending() const { return _count; }
+
+    // false = plain priority queue, every command sent as given
+    void setCoalescing(bool coalescing) { _coalescing = coalescing; }
+    void setPositionSource(SlinkTxPositionSource fn, void* ctx) { _position = fn; _positionCtx = ctx; }
+
+    static SlinkTxPriority priorityOf(uint8_t cmd);
+
+    const SlinkTxStats& stats() const { return _stats; }
+    void printStats(Print& out) const;
+
+    // Watch the bus on this RX pin before sending (-1 = blind lead-in). Set
+    // before begin().
+    void setCarrierSense(int rxPin) { _rxPin = rxPin; }
+
+    // Consulted once the line is ready; a frame it predicts to collide waits
+    // until clearAtUs (nullptr = off)
+    void setSlotCheck(SlinkTxSlotCheck fn, void* ctx) { _slotCheck = fn; _slotCtx = ctx; }
+
+    // Our own frame as received off the bus (see SlinkDecoderEvents::echo)
+    void onEcho(const SlinkEchoEvent& ev);
+
+    // Correct mark widths from echoes (on by default). skewUs() is how much
+    // longer than programmed a mark of that pulse class comes back.
+    void setCalibration(bool on) { _calibrate = on; }
+    int  skewUs(SlinkPulseClassifier::Class c) const { return _skewX16[c] / 16; }
+
+    void setTiming(const SlinkTxTiming& timing) { _timing = timing; }
+    const SlinkTxTiming& timing() const { return _timing; }
+
+    // Consulted before each command; returning false drops it without
+    // touching the bus. Also sees every command that does go out.
+    void setGate(SlinkTxGate gate, void* ctx) { _gate = gate; _gateCtx = ctx; }
+    uint32_t gatedCommands() const { return _gated; }
 
 private:
-    int _txPin;
-
-    // Timing constants (microseconds)
-    static const unsigned long SYNC_PULSE_US  = 2400;
-    static const unsigned long BIT_ONE_US     = 1200;
-    static const unsigned long BIT_ZERO_US    = 600;
-    static const unsigned long DELIMITER_US   = 600;
-    static const unsigned long LINE_READY_US  = 3000;  // Bus must be idle this long
-
-    void _waitForBus();
-    void _writeSync();
-    void _writeByte(uint8_t b);
-    void _writeBit(bool bit);
-
-    // Disc number encoding for commands
-    uint8_t _encodeDiscBCD(int disc);
+    int              _txPin;
+    rmt_channel_t    _channel;
+    SlinkHal::RmtTx  _rmt;
+    SlinkTxTiming    _timing;
+    bool             _blocking = true;
+
+    int                   _rxPin = -1;
+    SlinkHal::LineMonitor _line;
+    bool                  _waiting = false;   // head command waiting for the line
+    bool                  _lineBusy = false;
+    unsigned long         _waitSinceUs = 0;
+    uint32_t              _backoffUs = 0;
+    uint32_t              _random = 1;
+
+    SlinkTxSlotCheck      _slotCheck = nullptr;
+    void*                 _slotCtx = nullptr;
+    bool                  _deferred = false;  // head command held for predicted traffic
+    unsigned long         _deferSinceUs = 0;
+    unsigned long         _holdUntilUs = 0;
+
+    SlinkTxGate _gate = nullptr;
+    void*       _gateCtx = nullptr;
+    uint32_t    _gated = 0;
+
+    bool                _coalescing = true;
+    SlinkTxPositionSource _position = nullptr;
+    void*                 _positionCtx = nullptr;
+    SlinkTxStats        _stats;
+
+    // lead-in + sync + 8 per byte + trail + end marker
+    static const int MAX_CMD_BYTES = 4;
+    static const int MAX_ITEMS = 1 + 1 + 8 * MAX_CMD_BYTES + 1 + 1;
+    static const int QUEUE_LEN = 8;
+    static const uint32_t FLUSH_TIMEOUT_MS = 200;
+
+    struct Entry {
+        uint8_t       bytes[MAX_CMD_BYTES];
+        uint8_t       len;
+        uint8_t       priority;
+        int8_t        skip;         // next/previous: tracks still to skip (+ next, - previous)
+        int8_t        stepped;      // and already skipped
+        int16_t       baseDisc;     // where the skip started (0 = unknown)
+        int8_t        baseTrack;
+        uint8_t       baseTracks;   // on that disc (0 = unknown)
+        uint8_t       retries;
+        uint8_t       frameRetries; // of the current frame (skip step)
+        bool          started;
+        bool          verified;
+        uint8_t       bitErrors;
+        uint32_t      echoUs;
+        SlinkTxDone   done;
+        void*         ctx;
+        unsigned long queuedUs;
+        unsigned long startUs;
+    };
+    Entry         _queue[QUEUE_LEN];      // in order; [0] is on the wire while _inFlight
+    int           _count = 0;
+    bool          _inFlight = false;
+    unsigned long _frameStartUs = 0;
+    unsigned long _marksStartUs = 0;      // first and last mark of the frame on the wire
+    unsigned long _marksEndUs = 0;
+    uint16_t      _frameEdges = 0;        // our own edges in it
+    int8_t        _frameSkip = 0;         // tracks the frame on the wire skips
+    volatile bool _txEnd = false;
+
+    // Frame currently on the wire
+    rmt_item32_t  _items[MAX_ITEMS];
+    uint8_t       _frameBytes[MAX_CMD_BYTES];
+    uint8_t       _frameLen = 0;
+    uint16_t      _frameWidthUs[3];       // marks as programmed, per pulse class
+
+    // Frames sent and waiting for their echo, oldest first. The command
+    // goes along with its last frame and completes from here.
+    struct Verify {
+        Entry         entry;
+        bool          hasEntry;
+        uint8_t       bytes[MAX_CMD_BYTES];
+        uint8_t       len;
+        uint16_t      widthUs[3];
+        unsigned long startUs;
+        unsigned long endUs;
+    };
+    static const int VERIFY_LEN = 4;
+    Verify        _verify[VERIFY_LEN + 1];    // one over while _complete() settles
+    int           _verifyCount = 0;
+    bool          _echoSeen = false;      // RX hears us: verify from now on
+    uint8_t       _echoLostRun = 0;
+    bool          _calibrate = true;
+    int32_t       _skewX16[3] = {};       // measured - programmed, x16, averaged
+
+    static const unsigned long ECHO_TIMEOUT_US = 100000;    // after the frame ends
+    static const uint8_t       ECHO_LOST_LIMIT = 5;         // in a row: stop verifying
+    static const int           MAX_SKEW_US     = 300;
+
+    // Last frame to each player. A changer takes a while to report the
+    // track a command moved it to, so its position is only trusted once
+    // it has been left alone this long.
+    unsigned long _lastSentMs[SLINK_MAX_PLAYERS] = {};
+    static const unsigned long POSITION_SETTLE_MS = 3000;
+
+    static const unsigned long LINE_READY_US   = 3000;     // Bus must be idle this long
+    static const uint32_t      BACKOFF_SLOT_US = 1000;     // first backoff window
+    static const int           MAX_RETRIES     = 2;
+    static const unsigned long LINE_WAIT_MAX_US = 500000;  // then send regardless
+    static const unsigned long LINE_POLL_US    = 100;      // flush() waiting for the line
+
+    static void IRAM_ATTR _onTxEnd(void* arg);
+    bool _submit(const uint8_t* bytes, int len);
+    static bool _sameTarget(uint8_t a, uint8_t b);
+    static bool _isSkip(const Entry& e);
+    bool _coalesce(const Entry& e);
+    void _insert(const Entry& e);
+    Entry _take(int index);
+    void _finish(const Entry& e, bool sent, bool coalesced = false);
+    void _remove(int index, bool sent) { _finish(_take(index), sent); }
+    bool _lineReady();
+    bool _slotFree(unsigned long now);
+    uint32_t _frameUs(const Entry& e) const;
+    bool _collided() const;
+    int  _encode(const uint8_t* bytes, int len, rmt_item32_t* items, uint16_t leadInUs) const;
+    void _start();
+    void _complete();
+    uint16_t _width(SlinkPulseClassifier::Class c) const;
+    void _verifyPush();
+    void _verifyDone(bool echoed, uint8_t bitErrors, unsigned long echoUs);
+    void _calibrateFrom(const Verify& v, const SlinkEchoEvent& ev);
 };
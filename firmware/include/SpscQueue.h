@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Bounded lock-free single-producer / single-consumer queue.
+//
+// One task (or ISR) calls push(), one task calls pop(). Capacity N must be a power
+// of two; a full queue rejects the push and counts it in dropped().
+
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    bool push(const T& item) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t tail = _tail.load(std::memory_order_acquire);
+        if (head - tail >= N) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _items[head & (N - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t head = _head.load(std::memory_order_acquire);
+        if (tail == head) {
+            return false;
+        }
+        item = _items[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    uint32_t dropped() const {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    T                     _items[N];
+    std::atomic<size_t>   _head{0};
+    std::atomic<size_t>   _tail{0};
+    std::atomic<uint32_t> _dropped{0};
+};
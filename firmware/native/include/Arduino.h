@@ -0,0 +1,66 @@
+#pragma once
+
+// Minimal Arduino core surface for env:native.
+//
+// Only what the shared sources touch directly: fixed-width types, Print,
+// F(), IRAM_ATTR and the HEX/DEC bases. Timing, GPIO, RMT and networking go through
+// SlinkHal, which is implemented for the host in native/src/SlinkHalNative.cpp.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEC 10
+#define HEX 16
+
+#define F(s) (s)
+
+#define IRAM_ATTR
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(const uint8_t* buf, size_t len) = 0;
+
+    size_t print(const char* s)                  { return write((const uint8_t*)s, strlen(s)); }
+    size_t print(char c)                         { return write((const uint8_t*)&c, 1); }
+    size_t print(unsigned char n, int base = DEC) { return _printNumber(n, base); }
+    size_t print(int n, int base = DEC)           { return _printSigned(n, base); }
+    size_t print(unsigned int n, int base = DEC)  { return _printNumber(n, base); }
+    size_t print(long n, int base = DEC)          { return _printSigned(n, base); }
+    size_t print(unsigned long n, int base = DEC) { return _printNumber(n, base); }
+    size_t print(double n, int digits = 2) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.*f", digits, n);
+        return print(buf);
+    }
+
+    size_t println()                                { return print("\r\n"); }
+    template <typename T>
+    size_t println(T v)                             { size_t n = print(v); return n + println(); }
+    template <typename T>
+    size_t println(T v, int base)                   { size_t n = print(v, base); return n + println(); }
+
+private:
+    size_t _printSigned(long n, int base) {
+        if (base == DEC && n < 0) {
+            return print('-') + _printNumber((unsigned long)(-n), base);
+        }
+        return _printNumber((unsigned long)n, base);
+    }
+
+    size_t _printNumber(unsigned long n, int base) {
+        char buf[8 * sizeof(long) + 1];
+        char* p = &buf[sizeof(buf) - 1];
+        *p = '\0';
+        if (base < 2) base = DEC;
+        do {
+            char c = n % base;
+            n /= base;
+            *--p = c < 10 ? c + '0' : c + 'A' - 10;
+        } while (n);
+        return print(p);
+    }
+};
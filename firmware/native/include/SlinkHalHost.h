@@ -0,0 +1,70 @@
+#pragma once
+
+#include "SlinkHal.h"
+
+// Host-side controls for the native HAL: drive the virtual clock, inject
+// RMT captures and GPIO edges, script HTTP responses and silence or capture
+// the log.
+
+namespace SlinkHal {
+namespace Host {
+
+// Virtual clock. delayMicros()/delayMillis() advance it instead of sleeping,
+// so stall time of blocking code paths can be measured exactly.
+void          setMicros(unsigned long us);
+void          advanceMicros(unsigned long us);
+
+// Queue one RMT capture (copied) to be returned by the next RmtRx::receive()
+// on that channel
+bool          injectRmt(const rmt_item32_t* items, size_t numItems,
+                        rmt_channel_t channel = RMT_CHANNEL_0);
+size_t        pendingRmt(rmt_channel_t channel = RMT_CHANNEL_0);
+
+// Build a capture from raw durations (µs), paired into items as the RMT
+// hardware would, terminated by a zero-length end marker unless idleEnd is
+// false (capture cut off by full RMT memory; count should then be even).
+bool          injectDurations(const uint16_t* durations, size_t count, bool idleEnd = true,
+                              rmt_channel_t channel = RMT_CHANNEL_0);
+
+// Drive the edge capture ISRs: one edge, then one after each duration (µs),
+// then the idle timer. Edge stamps lag by up to latencyUs (ISR latency).
+bool          injectEdges(const uint16_t* durations, size_t count, uint32_t latencyUs = 0);
+// Detach the edge capture so another one can begin()
+void          endEdgeCapture();
+
+// Every pinWrite() since the last clear, with the virtual time it happened.
+// RmtTx::write() adds its whole waveform at once, stamped ahead of the
+// clock; the write completes (done callback) once the clock passes its end.
+struct PinEvent {
+    unsigned long us;
+    int           pin;
+    bool          high;
+};
+size_t          pinEventCount();
+const PinEvent* pinEvents();
+void            clearPinEvents();
+
+// The S-Link wire as LineMonitor sees it: marks (line pulled low) by pin,
+// from lineMarks() and from RmtTx writes on a TX pin wired to it. Marks may
+// lie ahead of the clock; monitors only see what the clock has passed.
+void          wire(int txPin, int rxPin);
+// Alternating mark/space durations (µs) starting with a mark at startUs
+void          lineMarks(int rxPin, unsigned long startUs, const uint16_t* durations, size_t count);
+void          clearLines();
+
+// HTTP transport. The handler returns a status code and may fill response.
+typedef int (*HttpHandler)(const char* method, const char* url, const char* body,
+                           char* response, size_t maxLen);
+void          setHttpHandler(HttpHandler handler);
+void          setNetConnected(bool connected);
+
+// Persistent store (storeLoad/storeSave): forget everything, as after
+// erasing flash; and how many saves there have been
+void          clearStore();
+uint32_t      storeWrites();
+
+// Log sink (stdout by default; nullptr discards)
+void          setLogFile(FILE* f);
+
+}  // namespace Host
+}  // namespace SlinkHal
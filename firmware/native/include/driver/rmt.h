@@ -0,0 +1,30 @@
+#pragma once
+
+// Host stand-in for the ESP-IDF RMT types used by the decoder.
+// Layout matches the hardware item so recorded captures replay unchanged.
+
+#include <stdint.h>
+
+typedef enum {
+    RMT_CHANNEL_0 = 0,
+    RMT_CHANNEL_1,
+    RMT_CHANNEL_2,
+    RMT_CHANNEL_3,
+    RMT_CHANNEL_4,
+    RMT_CHANNEL_5,
+    RMT_CHANNEL_6,
+    RMT_CHANNEL_7,
+    RMT_CHANNEL_MAX
+} rmt_channel_t;
+
+typedef struct {
+    union {
+        struct {
+            uint32_t duration0 : 15;
+            uint32_t level0    : 1;
+            uint32_t duration1 : 15;
+            uint32_t level1    : 1;
+        };
+        uint32_t val;
+    };
+} rmt_item32_t;
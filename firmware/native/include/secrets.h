@@ -0,0 +1,10 @@
+// Placeholder credentials for env:native builds (no WiFi on the host).
+// Device builds use include/secrets.h, see include/secrets.h.example.
+
+#pragma once
+
+#define WIFI_SSID "native"
+#define WIFI_PASSWORD ""
+
+#define BACKEND_HOST "127.0.0.1"
+#define BACKEND_PORT 3000
@@ -0,0 +1,493 @@
+#ifndef ARDUINO
+
+#include "SlinkHalHost.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace SlinkHal {
+
+static unsigned long _virtualMicros = 0;
+
+// One capture queue per RMT channel, like the per-channel driver ring buffers
+struct HostRmtChannel {
+    std::deque<std::vector<rmt_item32_t>> queue;
+    std::vector<rmt_item32_t>             borrowed;
+};
+static std::mutex     _rmtLock;
+static HostRmtChannel _rmtChannels[RMT_CHANNEL_MAX];
+static const size_t   RMT_QUEUE_MAX = 64;
+
+static std::vector<Host::PinEvent> _pinEvents;
+
+// RMT transmitters: a write() lays its waveform into the pin events ahead of
+// the clock and completes when the clock passes its end
+struct HostTxChannel {
+    bool          busy = false;
+    unsigned long endUs = 0;
+    RmtTxDone     fn = nullptr;
+    void*         arg = nullptr;
+};
+static HostTxChannel _txChannels[RMT_CHANNEL_MAX];
+
+// The wire: marks sorted by start, merged into segments where they overlap
+// (open collector: low while anyone pulls it low). Segments the clock left
+// behind long ago are dropped, keeping only their edge count.
+struct HostLine {
+    std::vector<std::pair<unsigned long, unsigned long>> marks;
+    uint32_t      prunedEdges = 0;
+    unsigned long prunedLastEdge = 0;
+};
+static std::map<int, HostLine> _lines;      // by RX pin
+static std::map<int, int>      _wires;      // TX pin -> RX pin
+static const unsigned long     LINE_KEEP_US = 200000;
+
+static void _addMark(int rxPin, unsigned long startUs, unsigned long endUs) {
+    HostLine& line = _lines[rxPin];
+    auto mark = std::make_pair(startUs, endUs);
+    line.marks.insert(std::upper_bound(line.marks.begin(), line.marks.end(), mark), mark);
+
+    // Drop whole segments that ended before the kept window
+    while (!line.marks.empty()) {
+        unsigned long segEnd = line.marks.front().second;
+        size_t n = 1;
+        while (n < line.marks.size() && line.marks[n].first <= segEnd) {
+            segEnd = std::max(segEnd, line.marks[n].second);
+            n++;
+        }
+        if (segEnd + LINE_KEEP_US > _virtualMicros) break;
+        line.prunedEdges += 2;
+        line.prunedLastEdge = segEnd;
+        line.marks.erase(line.marks.begin(), line.marks.begin() + n);
+    }
+}
+
+// Calls fn(us) for each edge of the merged marks up to the clock
+template <typename Fn>
+static void _forEachEdge(const HostLine& line, Fn fn) {
+    size_t i = 0;
+    while (i < line.marks.size() && line.marks[i].first <= _virtualMicros) {
+        unsigned long segStart = line.marks[i].first;
+        unsigned long segEnd = line.marks[i].second;
+        for (++i; i < line.marks.size() && line.marks[i].first <= segEnd; ++i) {
+            segEnd = std::max(segEnd, line.marks[i].second);
+        }
+        fn(segStart);
+        if (segEnd <= _virtualMicros) fn(segEnd);
+    }
+}
+
+static void _advance(unsigned long us) {
+    _virtualMicros += us;
+    for (HostTxChannel& ch : _txChannels) {
+        if (ch.busy && (long)(_virtualMicros - ch.endUs) >= 0) {
+            ch.busy = false;
+            if (ch.fn) ch.fn(ch.arg);
+        }
+    }
+}
+
+static EdgeIsr  _edgeFn = nullptr;
+static IdleIsr  _idleFn = nullptr;
+static void*    _edgeArg = nullptr;
+static uint32_t _edgeIdleUs = 0;
+static uint32_t _edgeSeed = 1;
+
+static Host::HttpHandler _httpHandler = nullptr;
+static bool              _netConnected = true;
+
+class HostLog : public Print {
+public:
+    FILE* file = stdout;
+
+    size_t write(const uint8_t* buf, size_t len) override {
+        if (!file) return len;
+        return fwrite(buf, 1, len, file);
+    }
+};
+
+static HostLog _log;
+
+// ---------------- Clock ----------------
+
+unsigned long nowMicros() {
+    return _virtualMicros;
+}
+
+unsigned long nowMillis() {
+    return _virtualMicros / 1000UL;
+}
+
+// ---------------- GPIO / timing ----------------
+
+void pinOutput(int pin) {
+    (void)pin;
+}
+
+void pinWrite(int pin, bool high) {
+    _pinEvents.push_back(Host::PinEvent{_virtualMicros, pin, high});
+}
+
+void delayMicros(unsigned long us) {
+    _advance(us);
+}
+
+void delayMillis(unsigned long ms) {
+    _advance(ms * 1000UL);
+}
+
+// ---------------- Tasks ----------------
+
+bool startTask(void (*fn)(void*), void* arg, const char* name,
+               uint32_t stackBytes, int priority, int core) {
+    (void)name;
+    (void)stackBytes;
+    (void)priority;
+    (void)core;
+    std::thread(fn, arg).detach();
+    return true;
+}
+
+// ---------------- RMT RX ----------------
+
+bool RmtRx::begin(int rxPin, rmt_channel_t channel, const RmtRxConfig& cfg) {
+    (void)rxPin;
+    (void)cfg;
+    _channel = channel;
+    _ringbuf = &_rmtChannels[channel];
+    return true;
+}
+
+rmt_item32_t* RmtRx::receive(size_t* numItems, uint32_t timeoutMs) {
+    *numItems = 0;
+    {
+        std::lock_guard<std::mutex> lock(_rmtLock);
+        HostRmtChannel& ch = *static_cast<HostRmtChannel*>(_ringbuf);
+        if (!ch.queue.empty()) {
+            ch.borrowed.swap(ch.queue.front());
+            ch.queue.pop_front();
+            *numItems = ch.borrowed.size();
+            return ch.borrowed.data();
+        }
+    }
+    // Nothing queued: a blocking receiver (RX task) waits in real time
+    if (timeoutMs > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return nullptr;
+}
+
+void RmtRx::release(rmt_item32_t* items) {
+    (void)items;
+    static_cast<HostRmtChannel*>(_ringbuf)->borrowed.clear();
+}
+
+// ---------------- RMT TX ----------------
+
+bool RmtTx::begin(int txPin, rmt_channel_t channel, const RmtTxConfig& cfg,
+                  RmtTxDone onDone, void* arg) {
+    (void)cfg;
+    _channel = channel;
+    _pin = txPin;
+    _txChannels[channel] = HostTxChannel{false, 0, onDone, arg};
+    return true;
+}
+
+bool RmtTx::write(const rmt_item32_t* items, size_t numItems) {
+    HostTxChannel& ch = _txChannels[_channel];
+    if (ch.busy) return false;
+
+    auto wired = _wires.find(_pin);
+    unsigned long t = _virtualMicros;
+    for (size_t i = 0; i < numItems; ++i) {
+        const rmt_item32_t& it = items[i];
+        if (it.duration0 == 0) break;
+        _pinEvents.push_back(Host::PinEvent{t, _pin, it.level0 != 0});
+        if (it.level0 && wired != _wires.end()) _addMark(wired->second, t, t + it.duration0);
+        t += it.duration0;
+        if (it.duration1 == 0) break;
+        _pinEvents.push_back(Host::PinEvent{t, _pin, it.level1 != 0});
+        if (it.level1 && wired != _wires.end()) _addMark(wired->second, t, t + it.duration1);
+        t += it.duration1;
+    }
+    _pinEvents.push_back(Host::PinEvent{t, _pin, false});   // idle level
+
+    ch.busy = true;
+    ch.endUs = t;
+    return true;
+}
+
+bool RmtTx::waitDone(uint32_t timeoutMs) {
+    HostTxChannel& ch = _txChannels[_channel];
+    if (!ch.busy) return true;
+    unsigned long left = ch.endUs - _virtualMicros;
+    if (left > timeoutMs * 1000UL) {
+        _advance(timeoutMs * 1000UL);
+        return false;
+    }
+    _advance(left);
+    return true;
+}
+
+// ---------------- GPIO edge capture ----------------
+
+bool edgeCaptureBegin(int pin, uint32_t idleUs, EdgeIsr onEdge, IdleIsr onIdle, void* arg) {
+    (void)pin;
+    if (_edgeFn || !onEdge || !onIdle) return false;
+    _edgeFn = onEdge;
+    _idleFn = onIdle;
+    _edgeArg = arg;
+    _edgeIdleUs = idleUs;
+    return true;
+}
+
+// ---------------- Line activity ----------------
+
+bool LineMonitor::begin(int pin) {
+    _pin = pin;
+    return true;
+}
+
+bool LineMonitor::mark() const {
+    auto it = _lines.find(_pin);
+    if (it == _lines.end()) return false;
+    for (const auto& m : it->second.marks) {
+        if (m.first > _virtualMicros) break;
+        if (m.second > _virtualMicros) return true;
+    }
+    return false;
+}
+
+unsigned long LineMonitor::lastEdgeUs() const {
+    auto it = _lines.find(_pin);
+    if (it == _lines.end()) return 0;
+    unsigned long last = it->second.prunedLastEdge;
+    _forEachEdge(it->second, [&](unsigned long us) { last = std::max(last, us); });
+    return last;
+}
+
+uint32_t LineMonitor::edgesBetween(unsigned long fromUs, unsigned long toUs) const {
+    auto it = _lines.find(_pin);
+    if (it == _lines.end()) return 0;
+    uint32_t count = 0;
+    _forEachEdge(it->second, [&](unsigned long us) {
+        if (us > fromUs && us <= toUs) count++;
+    });
+    return count;
+}
+
+void LineMonitor::edge(unsigned long us) {
+    (void)us;
+}
+
+// ---------------- Network ----------------
+
+bool netBegin(const char* ssid, const char* password, unsigned long timeoutMs) {
+    (void)ssid;
+    (void)password;
+    (void)timeoutMs;
+    return _netConnected;
+}
+
+bool netConnected() {
+    return _netConnected;
+}
+
+void netReconnect() {
+}
+
+uint32_t netLocalIp() {
+    return 0x7F000001;  // 127.0.0.1
+}
+
+bool mdnsBegin(const char* hostname) {
+    (void)hostname;
+    return true;
+}
+
+int mdnsQueryService(const char* service, const char* proto, uint32_t* ip, int* port) {
+    (void)service;
+    (void)proto;
+    (void)ip;
+    (void)port;
+    return 0;
+}
+
+uint32_t mdnsQueryHost(const char* hostname, unsigned long timeoutMs) {
+    (void)hostname;
+    (void)timeoutMs;
+    return 0;
+}
+
+int httpPost(const char* url, const char* json, unsigned long timeoutMs) {
+    (void)timeoutMs;
+    if (!_httpHandler) return -1;  // CONNECTION_REFUSED
+    char discard[1];
+    return _httpHandler("POST", url, json, discard, 0);
+}
+
+int httpGet(const char* url, char* response, size_t maxLen, unsigned long timeoutMs) {
+    (void)timeoutMs;
+    if (!_httpHandler) return -1;
+    if (maxLen > 0) response[0] = '\0';
+    return _httpHandler("GET", url, nullptr, response, maxLen);
+}
+
+// ---------------- Persistent storage ----------------
+
+static std::map<std::string, std::vector<uint8_t>> _store;
+static uint32_t _storeWrites = 0;
+
+bool storeLoad(const char* key, void* data, size_t len) {
+    auto it = _store.find(key);
+    if (it == _store.end() || it->second.size() != len) return false;
+    memcpy(data, it->second.data(), len);
+    return true;
+}
+
+bool storeSave(const char* key, const void* data, size_t len) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    _store[key].assign(bytes, bytes + len);
+    _storeWrites++;
+    return true;
+}
+
+// ---------------- Log ----------------
+
+Print& log() {
+    return _log;
+}
+
+// ---------------- Host controls ----------------
+
+namespace Host {
+
+void setMicros(unsigned long us) {
+    _virtualMicros = us;
+}
+
+void advanceMicros(unsigned long us) {
+    _advance(us);
+}
+
+bool injectRmt(const rmt_item32_t* items, size_t numItems, rmt_channel_t channel) {
+    std::lock_guard<std::mutex> lock(_rmtLock);
+    HostRmtChannel& ch = _rmtChannels[channel];
+    if (ch.queue.size() >= RMT_QUEUE_MAX) return false;  // ring buffer full
+    ch.queue.emplace_back(items, items + numItems);
+    return true;
+}
+
+size_t pendingRmt(rmt_channel_t channel) {
+    std::lock_guard<std::mutex> lock(_rmtLock);
+    return _rmtChannels[channel].queue.size();
+}
+
+bool injectDurations(const uint16_t* durations, size_t count, bool idleEnd, rmt_channel_t channel) {
+    std::vector<rmt_item32_t> items;
+    items.reserve(count / 2 + 1);
+
+    for (size_t i = 0; i < count; i += 2) {
+        rmt_item32_t item;
+        item.val = 0;
+        item.level0 = 1;
+        item.duration0 = durations[i];
+        if (i + 1 < count) {
+            item.duration1 = durations[i + 1];
+        }
+        items.push_back(item);
+    }
+    if (idleEnd && count % 2 == 0) {
+        rmt_item32_t end;
+        end.val = 0;
+        items.push_back(end);
+    }
+    return injectRmt(items.data(), items.size(), channel);
+}
+
+bool injectEdges(const uint16_t* durations, size_t count, uint32_t latencyUs) {
+    if (!_edgeFn) return false;
+
+    // Edge times are stamped late by a pseudo-random 0..latencyUs, as an
+    // ISR held off by other interrupts would see them
+    auto stamp = [latencyUs]() {
+        _edgeSeed = _edgeSeed * 1103515245u + 12345u;
+        return _virtualMicros + (latencyUs ? (_edgeSeed >> 16) % (latencyUs + 1) : 0);
+    };
+
+    _edgeFn(_edgeArg, stamp());
+    for (size_t i = 0; i < count; ++i) {
+        _virtualMicros += durations[i];
+        _edgeFn(_edgeArg, stamp());
+    }
+    _virtualMicros += _edgeIdleUs;
+    _idleFn(_edgeArg);
+    return true;
+}
+
+void endEdgeCapture() {
+    _edgeFn = nullptr;
+    _idleFn = nullptr;
+    _edgeArg = nullptr;
+}
+
+size_t pinEventCount() {
+    return _pinEvents.size();
+}
+
+const PinEvent* pinEvents() {
+    return _pinEvents.data();
+}
+
+void clearPinEvents() {
+    _pinEvents.clear();
+}
+
+void wire(int txPin, int rxPin) {
+    _wires[txPin] = rxPin;
+}
+
+void lineMarks(int rxPin, unsigned long startUs, const uint16_t* durations, size_t count) {
+    unsigned long t = startUs;
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 2 == 0) _addMark(rxPin, t, t + durations[i]);
+        t += durations[i];
+    }
+}
+
+void clearLines() {
+    _lines.clear();
+    _wires.clear();
+}
+
+void setHttpHandler(HttpHandler handler) {
+    _httpHandler = handler;
+}
+
+void setNetConnected(bool connected) {
+    _netConnected = connected;
+}
+
+void setLogFile(FILE* f) {
+    _log.file = f;
+}
+
+void clearStore() {
+    _store.clear();
+}
+
+uint32_t storeWrites() {
+    return _storeWrites;
+}
+
+}  // namespace Host
+
+}  // namespace SlinkHal
+
+#endif  // !ARDUINO
@@ -0,0 +1,2490 @@
+// Host runner for env:native.
+//
+//   .pio/build/native/program replay <file>   decode a recorded pulse capture
+//   .pio/build/native/program bench [frames]  time the decode / TX hot paths
+//   .pio/build/native/program backend         step BackendClient against a fake server
+//
+// Capture files hold pulse durations in µs, whitespace separated, one symbol
+// per duration as the decoder consumes them. A line containing only '-' ends
+// one RMT capture and starts the next.
+
+#ifndef ARDUINO
+
+#include "SlinkHalHost.h"
+#include "SlinkDecoder.h"
+#include "SlinkBus.h"
+#include "SlinkCodec.h"
+#include "SlinkTx.h"
+#include "BackendClient.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static Print& Log = SlinkHal::log();
+
+// ---------------- Frame synthesis ----------------
+
+static const uint16_t SYNC_US = 2400;
+static const uint16_t ONE_US  = 1200;
+static const uint16_t ZERO_US = 600;
+
+static void appendFrame(std::vector<uint16_t>& out, const uint8_t* bytes, int len) {
+    out.push_back(SYNC_US);
+    for (int i = 0; i < len; ++i) {
+        for (int b = 7; b >= 0; --b) {
+            out.push_back(((bytes[i] >> b) & 1) ? ONE_US : ZERO_US);
+        }
+    }
+}
+
+static int buildTrackStatus(uint8_t* bytes, int player, int disc, int track) {
+    uint8_t dev;
+    if (player == 2) dev = disc > 200 ? 0x51 : 0x44;
+    else             dev = disc > 200 ? 0x45 : 0x40;
+
+    uint16_t discCode  = SlinkCodec::encodeIndex(SlinkCodec::indexFromNumber(disc));
+    uint16_t trackCode = SlinkCodec::encodeIndex(SlinkCodec::indexFromNumber(track));
+
+    bytes[0] = 0x41;
+    bytes[1] = dev;
+    bytes[2] = 0x11;
+    bytes[3] = 0x00;
+    bytes[4] = discCode >> 8;
+    bytes[5] = discCode & 0xFF;
+    bytes[6] = trackCode >> 8;
+    bytes[7] = trackCode & 0xFF;
+    for (int i = 8; i < 12; ++i) bytes[i] = 0;
+    return 12;
+}
+
+// ---------------- Reference codec ----------------
+
+// The linear-search index decode SlinkCodec replaced, kept for comparison
+static uint16_t legacyEncodeIndex(uint16_t n, unsigned long* iterations) {
+    uint16_t code = 0;
+    uint16_t bitPos = 0;
+    uint16_t temp = n;
+
+    while (temp) {
+        if (temp & 1) {
+            uint16_t pow4 = 1;
+            for (uint16_t i = 0; i < bitPos; ++i) {
+                pow4 *= 4;
+                (*iterations)++;
+            }
+            code += pow4;
+        }
+        temp >>= 1;
+        bitPos++;
+        (*iterations)++;
+    }
+    return code;
+}
+
+static int legacyDecodeIndex(uint16_t code, uint16_t maxIndex, unsigned long* iterations) {
+    for (uint16_t idx = 1; idx <= maxIndex; ++idx) {
+        if (legacyEncodeIndex(idx, iterations) == code) {
+            return (int)idx;
+        }
+    }
+    return -1;
+}
+
+// ---------------- Modes ----------------
+
+static int decodedFrames = 0;
+
+static void countStatus(void*, const SlinkTrackStatus& st) {
+    (void)st;
+    decodedFrames++;
+}
+
+static void printStatus(void*, const SlinkTrackStatus& st) {
+    printf("status player=%d disc=%d track=%d\n", st.player, st.discNumber, st.trackNumber);
+}
+
+static int runReplay(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return 1;
+    }
+
+    SlinkDecoder decoder(34);
+    decoder.begin();
+    decoder.events().status.subscribe(printStatus);
+
+    std::vector<uint16_t> capture;
+    char tok[32];
+    while (fscanf(f, "%31s", tok) == 1) {
+        if (tok[0] == '-') {
+            SlinkHal::Host::injectDurations(capture.data(), capture.size());
+            decoder.loop();
+            capture.clear();
+        } else {
+            capture.push_back((uint16_t)strtoul(tok, nullptr, 10));
+        }
+    }
+    if (!capture.empty()) {
+        SlinkHal::Host::injectDurations(capture.data(), capture.size());
+        decoder.loop();
+    }
+    fclose(f);
+
+    decoder.classifier().printReport(Log);
+    return 0;
+}
+
+static int benchCodec() {
+    // Every (disc, track) code pair a status frame can carry
+    std::vector<uint16_t> discCodes, trackCodes;
+    for (int disc = 1; disc <= 300; ++disc) {
+        discCodes.push_back(SlinkCodec::encodeIndex(SlinkCodec::indexFromNumber(disc)));
+        trackCodes.push_back(SlinkCodec::encodeIndex(SlinkCodec::indexFromNumber(1 + disc % 99)));
+    }
+
+    // Equivalence over the full 16-bit code space (code 0 is never a valid index)
+    unsigned long iterations = 0;
+    int mismatches = 0;
+    for (uint32_t code = 1; code <= 0xFFFF; ++code) {
+        if (legacyDecodeIndex(code, 300, &iterations) != SlinkCodec::decodeIndex(code, 300)) mismatches++;
+        if (legacyDecodeIndex(code, 200, &iterations) != SlinkCodec::decodeIndex(code, 200)) mismatches++;
+    }
+
+    iterations = 0;
+    volatile int sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < discCodes.size(); ++i) {
+        sink += legacyDecodeIndex(discCodes[i], 300, &iterations);
+        sink += legacyDecodeIndex(trackCodes[i], 200, &iterations);
+    }
+    auto mid = std::chrono::steady_clock::now();
+    for (int rep = 0; rep < 1000; ++rep) {
+        for (size_t i = 0; i < discCodes.size(); ++i) {
+            sink += SlinkCodec::decodeIndex(discCodes[i], 300);
+            sink += SlinkCodec::decodeIndex(trackCodes[i], 200);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    (void)sink;
+
+    double n = (double)discCodes.size();
+    double legacyNs = std::chrono::duration<double, std::nano>(mid - start).count() / n;
+    double codecNs  = std::chrono::duration<double, std::nano>(end - mid).count() / (n * 1000);
+
+    Log.print(F("[BENCH] codec mismatches vs linear search: "));
+    Log.println(mismatches);
+    Log.print(F("[BENCH] index decode per frame: linear "));
+    Log.print(legacyNs, 1);
+    Log.print(F(" ns ("));
+    Log.print((unsigned long)(iterations / n));
+    Log.print(F(" loop iterations), codec "));
+    Log.print(codecNs, 1);
+    Log.println(F(" ns (0 iterations)"));
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Back-to-back frames in one capture, and one frame split across two
+static int benchBurst() {
+    SlinkDecoder decoder(34);
+    decoder.setConfirmation(1, 1);     // every frame is a new disc/track
+    decoder.begin();
+    decoder.events().status.subscribe(countStatus);
+    decodedFrames = 0;
+
+    int sent = 0;
+    std::vector<uint16_t> burst;
+    for (int disc = 1; disc <= 3; ++disc) {
+        uint8_t bytes[12];
+        appendFrame(burst, bytes, buildTrackStatus(bytes, 1, disc, 1));
+        sent++;
+    }
+    SlinkHal::Host::injectDurations(burst.data(), burst.size());
+    decoder.loop();
+
+    std::vector<uint16_t> split;
+    uint8_t bytes[12];
+    appendFrame(split, bytes, buildTrackStatus(bytes, 2, 250, 7));
+    sent++;
+    size_t half = (split.size() / 2) & ~size_t(1);
+    SlinkHal::Host::injectDurations(split.data(), half, false);
+    decoder.loop();
+    SlinkHal::Host::injectDurations(split.data() + half, split.size() - half);
+    decoder.loop();
+
+    const SlinkRxStats& st = decoder.rxStats();
+    SlinkHal::Host::setLogFile(stdout);
+    Log.print(F("[BENCH] burst: decoded "));
+    Log.print(decodedFrames);
+    Log.print(F("/"));
+    Log.print(sent);
+    Log.print(F(" frames (carried="));
+    Log.print(st.carried);
+    Log.print(F(" truncated="));
+    Log.print(st.truncated);
+    Log.print(F(" dropped="));
+    Log.print(st.dropped);
+    Log.println(F(")"));
+    SlinkHal::Host::setLogFile(nullptr);
+    return decodedFrames == sent ? 0 : 1;
+}
+
+// Pulse trains whose timing drifts slowly away from nominal (temperature,
+// cable length) with per-pulse jitter, decoded with fixed and with adaptive
+// windows. A frame counts as an error unless it decodes to the sent disc/track.
+static int expectDisc = 0;
+static int expectTrack = 0;
+static int correctFrames = 0;
+
+static void checkStatus(void*, const SlinkTrackStatus& st) {
+    if (st.discNumber == expectDisc && st.trackNumber == expectTrack) {
+        correctFrames++;
+    }
+}
+
+static int benchDriftRun(bool adaptive, double endScale, int frames, uint32_t* lowConfidence) {
+    SlinkDecoder decoder(34);
+    decoder.setConfirmation(1, 1);     // every frame is a new disc/track
+    decoder.begin();
+    decoder.classifier().setAdaptive(adaptive);
+    decoder.events().status.subscribe(checkStatus);
+    correctFrames = 0;
+
+    uint32_t seed = 12345;
+    for (int i = 0; i < frames; ++i) {
+        double scale = 1.0 + (endScale - 1.0) * i / frames;
+        int player = 1 + (i & 1);
+        expectDisc = 1 + (i * 7) % 300;
+        expectTrack = 1 + i % 99;
+
+        uint8_t bytes[12];
+        std::vector<uint16_t> cap;
+        appendFrame(cap, bytes, buildTrackStatus(bytes, player, expectDisc, expectTrack));
+        for (uint16_t& d : cap) {
+            seed = seed * 1103515245u + 12345u;
+            double jitter = 1.0 + (int)((seed >> 16) % 161 - 80) / 1000.0;   // ±8%
+            d = (uint16_t)(d * scale * jitter);
+        }
+        SlinkHal::Host::injectDurations(cap.data(), cap.size());
+        decoder.loop();
+    }
+
+    *lowConfidence = decoder.rxStats().lowConfidence;
+    return frames - correctFrames;
+}
+
+static int benchDrift(int frames) {
+    static const double END_SCALES[] = { 1.55, 0.72 };
+    int result = 0;
+
+    for (double endScale : END_SCALES) {
+        uint32_t lowFixed, lowAdaptive;
+        int errFixed    = benchDriftRun(false, endScale, frames, &lowFixed);
+        int errAdaptive = benchDriftRun(true,  endScale, frames, &lowAdaptive);
+
+        SlinkHal::Host::setLogFile(stdout);
+        Log.print(F("[BENCH] drift 1.00->"));
+        Log.print(endScale, 2);
+        Log.print(F(": errors fixed "));
+        Log.print(errFixed);
+        Log.print(F("/"));
+        Log.print(frames);
+        Log.print(F(" (low conf "));
+        Log.print(lowFixed);
+        Log.print(F("), adaptive "));
+        Log.print(errAdaptive);
+        Log.print(F("/"));
+        Log.print(frames);
+        Log.print(F(" (low conf "));
+        Log.print(lowAdaptive);
+        Log.println(F(")"));
+        SlinkHal::Host::setLogFile(nullptr);
+
+        if (errAdaptive > errFixed) result = 1;
+    }
+    return result;
+}
+
+// The same pulse stream through each capture back-end: host CPU time per
+// frame (edge ISRs included), capture interrupts per frame and decode
+// errors. Edge timestamps pick up simulated ISR latency.
+static int benchCaptureRun(SlinkCapture* capture, uint32_t latencyUs, int frames,
+                           double* nsPerFrame, double* irqPerFrame) {
+    SlinkDecoder decoder(34);
+    decoder.setConfirmation(1, 1);     // every frame is a new disc/track
+    if (capture) decoder.setCapture(capture);
+    decoder.begin();
+    decoder.events().status.subscribe(checkStatus);
+    correctFrames = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i) {
+        expectDisc = 1 + (i * 7) % 300;
+        expectTrack = 1 + i % 99;
+
+        uint8_t bytes[12];
+        std::vector<uint16_t> cap;
+        appendFrame(cap, bytes, buildTrackStatus(bytes, 1 + (i & 1), expectDisc, expectTrack));
+        if (capture) {
+            SlinkHal::Host::injectEdges(cap.data(), cap.size(), latencyUs);
+        } else {
+            SlinkHal::Host::injectDurations(cap.data(), cap.size());
+        }
+        decoder.loop();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    *nsPerFrame = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+    *irqPerFrame = (double)decoder.capture().stats().interrupts / frames;
+    SlinkHal::Host::endEdgeCapture();
+    return frames - correctFrames;
+}
+
+static int benchCapture(int frames) {
+    static const uint32_t LATENCIES_US[] = { 0, 50, 300 };
+    int result = 0;
+    double ns, irq;
+
+    int errRmt = benchCaptureRun(nullptr, 0, frames, &ns, &irq);
+    SlinkHal::Host::setLogFile(stdout);
+    Log.print(F("[BENCH] capture rmt: "));
+    Log.print(ns, 1);
+    Log.print(F(" ns/frame, "));
+    Log.print(irq, 1);
+    Log.print(F(" irq/frame, errors "));
+    Log.print(errRmt);
+    Log.print(F("/"));
+    Log.println(frames);
+    SlinkHal::Host::setLogFile(nullptr);
+    if (errRmt != 0) result = 1;
+
+    for (uint32_t latency : LATENCIES_US) {
+        SlinkGpioCapture gpio(34);
+        int err = benchCaptureRun(&gpio, latency, frames, &ns, &irq);
+        SlinkHal::Host::setLogFile(stdout);
+        Log.print(F("[BENCH] capture gpio (isr latency <="));
+        Log.print(latency);
+        Log.print(F("us): "));
+        Log.print(ns, 1);
+        Log.print(F(" ns/frame, "));
+        Log.print(irq, 1);
+        Log.print(F(" irq/frame, errors "));
+        Log.print(err);
+        Log.print(F("/"));
+        Log.println(frames);
+        SlinkHal::Host::setLogFile(nullptr);
+        if (latency == 0 && err != 0) result = 1;
+    }
+    return result;
+}
+
+// Several buses, each with its own RMT channel and RX task, all fed at
+// once. Each bus is kept at most BUS_IN_FLIGHT frames ahead of its loop()
+// so nothing overflows; aggregate throughput is compared with a single bus.
+// The RX tasks never exit, so the decoders are leaked and this runs last.
+static const int BUS_IN_FLIGHT = 8;
+
+static void countBusStatus(void* ctx, const SlinkTrackStatus& st) {
+    (void)st;
+    (*static_cast<int*>(ctx))++;
+}
+
+static double benchBusesRun(int firstChannel, int numBuses, int frames) {
+    std::vector<SlinkDecoder*> decoders;
+    std::vector<int> delivered(numBuses, 0);
+    std::vector<int> injected(numBuses, 0);
+    for (int b = 0; b < numBuses; ++b) {
+        SlinkDecoder* d = new SlinkDecoder(34, (rmt_channel_t)(firstChannel + b));
+        d->setConfirmation(1, 1);
+        d->setBusId(b);
+        d->begin();
+        d->events().status.subscribe(countBusStatus, &delivered[b]);
+        d->startTask(-1, 5);
+        decoders.push_back(d);
+    }
+
+    std::vector<std::vector<uint16_t>> captures;
+    for (int disc = 1; disc <= 300; ++disc) {
+        uint8_t bytes[12];
+        std::vector<uint16_t> cap;
+        appendFrame(cap, bytes, buildTrackStatus(bytes, 1 + disc % 2, disc, 1 + disc % 99));
+        captures.push_back(cap);
+    }
+
+    int total = 0;
+    int want = frames * numBuses;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::seconds(30);
+    while (total < want && std::chrono::steady_clock::now() < deadline) {
+        total = 0;
+        for (int b = 0; b < numBuses; ++b) {
+            if (injected[b] < frames && injected[b] - delivered[b] < BUS_IN_FLIGHT) {
+                const std::vector<uint16_t>& cap = captures[injected[b] % captures.size()];
+                if (SlinkHal::Host::injectDurations(cap.data(), cap.size(), true,
+                                                        (rmt_channel_t)(firstChannel + b))) {
+                    injected[b]++;
+                }
+            }
+            decoders[b]->loop();
+            total += delivered[b];
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    uint32_t dropped = 0;
+    for (SlinkDecoder* d : decoders) dropped += d->droppedFrames();
+
+    double secs = std::chrono::duration<double>(end - start).count();
+    SlinkHal::Host::setLogFile(stdout);
+    Log.print(F("[BENCH] buses x"));
+    Log.print(numBuses);
+    Log.print(F(": decoded "));
+    Log.print(total);
+    Log.print(F("/"));
+    Log.print(want);
+    Log.print(F(" frames (queue dropped "));
+    Log.print(dropped);
+    Log.print(F("), "));
+    Log.print(total / secs / 1000.0, 1);
+    Log.print(F(" kframes/s, "));
+    Log.print(total / secs / numBuses / 1000.0, 1);
+    Log.println(F(" kframes/s per bus"));
+    SlinkHal::Host::setLogFile(nullptr);
+
+    return total == want ? total / secs : 0.0;
+}
+
+static int benchBuses(int frames) {
+    // Separate channels per run: the leaked RX tasks keep polling theirs
+    double one = benchBusesRun(0, 1, frames);
+    double all = benchBusesRun(1, 4, frames);
+    return (one > 0 && all > 0) ? 0 : 1;
+}
+
+// A player reporting the same disc/track repeatedly, with a fraction of
+// frames corrupted by a flipped bit in the disc or track code. Counts the
+// status events (each one is a backend POST) and wrong commits.
+static int statusEvents = 0;
+static int wrongCommits = 0;
+
+static void checkCommit(void*, const SlinkTrackStatus& st) {
+    statusEvents++;
+    if (st.discNumber != expectDisc || st.trackNumber != expectTrack) {
+        wrongCommits++;
+    }
+}
+
+static void benchConfirmRun(uint8_t n, uint8_t m, int frames) {
+    SlinkDecoder decoder(34);
+    decoder.begin();
+    decoder.setConfirmation(n, m);
+    decoder.events().status.subscribe(checkCommit);
+    statusEvents = 0;
+    wrongCommits = 0;
+
+    uint32_t seed = 777;
+    for (int i = 0; i < frames; ++i) {
+        // A track change every 50 frames
+        expectDisc = 1 + (i / 50) % 300;
+        expectTrack = 1 + (i / 50) % 99;
+
+        uint8_t bytes[12];
+        int len = buildTrackStatus(bytes, 1, expectDisc, expectTrack);
+        seed = seed * 1103515245u + 12345u;
+        if ((seed >> 16) % 10 == 0) {                   // 10% corrupted
+            bytes[4 + (seed >> 8) % 4] ^= (uint8_t)(1u << ((seed >> 4) % 8));
+        }
+        std::vector<uint16_t> cap;
+        appendFrame(cap, bytes, len);
+        SlinkHal::Host::injectDurations(cap.data(), cap.size());
+        decoder.loop();
+    }
+
+    SlinkHal::Host::setLogFile(stdout);
+    Log.print(F("[BENCH] confirm "));
+    Log.print(n);
+    Log.print(F("-of-"));
+    Log.print(m);
+    Log.print(F(": "));
+    Log.print(statusEvents);
+    Log.print(F(" status events for "));
+    Log.print(frames / 50);
+    Log.print(F(" real changes, "));
+    Log.print(wrongCommits);
+    Log.print(F(" wrong ("));
+    Log.print(decoder.statusStats().invalid);
+    Log.println(F(" undecodable frames)"));
+    SlinkHal::Host::setLogFile(nullptr);
+}
+
+static int benchConfirm(int frames) {
+    benchConfirmRun(1, 1, frames);
+    benchConfirmRun(2, 3, frames);
+    return wrongCommits == 0 ? 0 : 1;
+}
+
+// Presence from heartbeats and the TX gate: the Mode 3 player (2) goes
+// offline when its heartbeats stop, player 1 is powered off by command,
+// and commands to either are held back without costing bus time.
+static void injectFrame(const uint8_t* bytes, int len) {
+    std::vector<uint16_t> cap;
+    appendFrame(cap, bytes, len);
+    SlinkHal::Host::injectDurations(cap.data(), cap.size());
+}
+
+static unsigned long timedPlayDisc(SlinkTx& tx, int player) {
+    unsigned long t0 = SlinkHal::nowMicros();
+    tx.playDisc(player, 10, 1);
+    return SlinkHal::nowMicros() - t0;
+}
+
+static int benchPresence() {
+    SlinkBus bus(0, {34, 25, RMT_CHANNEL_0, RMT_CHANNEL_2});
+    bus.begin();
+    SlinkPresence& presence = bus.presence;
+    const uint8_t heartbeat[] = {0x41, 0x04, 0x00, 0x55};
+    int result = 0;
+
+    // 30 s of heartbeats, then 20 s of silence
+    for (int t = 0; t < 50; t += 3) {
+        if (t < 30) injectFrame(heartbeat, sizeof(heartbeat));
+        bus.loop();
+        SlinkHal::Host::advanceMicros(3000UL * 1000UL);
+    }
+    bus.loop();
+    if (presence.state(2) != SlinkPresence::OFFLINE) result = 1;
+    unsigned long offStall = timedPlayDisc(bus.tx, 2);
+
+    injectFrame(heartbeat, sizeof(heartbeat));
+    bus.loop();
+    if (presence.state(2) != SlinkPresence::ONLINE) result = 1;
+    unsigned long onStall = timedPlayDisc(bus.tx, 2);
+
+    bus.tx.powerOff();
+    if (presence.state(1) != SlinkPresence::POWERED_OFF) result = 1;
+    unsigned long poweredOffStall = timedPlayDisc(bus.tx, 1);
+
+    SlinkHal::Host::setLogFile(stdout);
+    Log.print(F("[BENCH] presence: playDisc stall online "));
+    Log.print(onStall);
+    Log.print(F(" us, offline "));
+    Log.print(offStall);
+    Log.print(F(" us, powered-off "));
+    Log.print(poweredOffStall);
+    Log.print(F(" us, "));
+    Log.print(bus.tx.gatedCommands());
+    Log.println(result ? F(" held back, WRONG STATES") : F(" held back"));
+    presence.printReport(Log);
+    SlinkHal::Host::setLogFile(nullptr);
+    return result;
+}
+
+// One frame as it went out on a TX pin, parsed from the pin events: a
+// sync mark starts a frame
+struct WireFrame {
+    std::vector<uint8_t>  bytes;
+    std::vector<uint16_t> marks;    // widths, sync first
+    unsigned long         startUs;  // first mark
+    unsigned long         endUs;    // end of the last delimiter
+};
+
+static std::vector<WireFrame> wireFrames(int pin) {
+    std::vector<WireFrame> frames;
+    const SlinkHal::Host::PinEvent* ev = SlinkHal::Host::pinEvents();
+    size_t count = SlinkHal::Host::pinEventCount();
+    int bits = 0;
+    for (size_t i = 0; i + 1 < count; ++i) {
+        if (ev[i].pin != pin || !ev[i].high) continue;
+        size_t j = i + 1;
+        while (j < count && ev[j].pin != pin) ++j;
+        if (j == count) break;
+        unsigned long width = ev[j].us - ev[i].us;
+        if (width > 1800) {
+            frames.push_back(WireFrame{{}, {}, ev[i].us, 0});
+            bits = 0;
+        } else if (frames.empty()) {
+            continue;
+        } else {
+            std::vector<uint8_t>& bytes = frames.back().bytes;
+            if (bits % 8 == 0) bytes.push_back(0);
+            bytes.back() = (uint8_t)((bytes.back() << 1) | (width > 900));
+            bits++;
+        }
+        frames.back().marks.push_back((uint16_t)width);
+        frames.back().endUs = ev[j].us + 600;
+    }
+    return frames;
+}
+
+// Commands as they went out on the TX pin
+static std::vector<std::vector<uint8_t>> sentFrames(int pin) {
+    std::vector<std::vector<uint8_t>> frames;
+    for (const WireFrame& f : wireFrames(pin)) frames.push_back(f.bytes);
+    return frames;
+}
+
+// Start/end of each frame on the TX pin, in the order sentFrames()
+// returns them
+static std::vector<std::pair<unsigned long, unsigned long>> sentFrameSpans(int pin) {
+    std::vector<std::pair<unsigned long, unsigned long>> spans;
+    for (const WireFrame& f : wireFrames(pin)) spans.emplace_back(f.startUs, f.endUs);
+    return spans;
+}
+
+static SlinkTxCompletion stopDone;
+static void onStopDone(void* ctx, const SlinkTxCompletion& c) {
+    (void)ctx;
+    stopDone = c;
+}
+
+// UI clicks, one every 10 ms (a frame takes 35-60 ms), with player 1 on
+// disc 5 track 3: five next; three play-disc picks then two next; then
+// player 2 browsing with three next while player 1 is stopped. tracks is
+// disc 5's track count as the play queue has it (0 = not queued).
+struct TxQueueResult {
+    uint32_t frames;
+    uint32_t busMs;
+    uint32_t skipsResolved;
+    unsigned long drainMs[3];   // click burst start until its last frame is out
+    unsigned long stopWaitUs;
+    std::vector<std::vector<uint8_t>> sent;
+};
+
+static TxQueueResult benchTxQueueRun(bool coalescing, uint8_t tracks) {
+    SlinkBus bus(0, {34, 25, RMT_CHANNEL_0, RMT_CHANNEL_2});
+    bus.begin();
+    SlinkTx& tx = bus.tx;
+    tx.setBlocking(false);
+    tx.setCoalescing(coalescing);
+    const SlinkPlaylistEntry queued = {1, 5, 0, tracks};
+    if (tracks) bus.playlist.load(&queued, 1, false);
+
+    uint8_t bytes[12];
+    int len = buildTrackStatus(bytes, 1, 5, 3);
+    for (int i = 0; i < 5; ++i) {
+        injectFrame(bytes, len);
+        bus.loop();
+    }
+    SlinkHal::Host::advanceMicros(5000UL * 1000UL);
+    SlinkHal::Host::clearPinEvents();
+
+    const uint8_t stopCmd[] = {SLINK_DEV_CDP1_LO, SLINK_CMD_STOP};
+    const unsigned long burstMs[3] = {0, 1000, 2000};
+    TxQueueResult r = {};
+    unsigned long t0 = SlinkHal::nowMillis();
+    for (unsigned long t = 0; t < 4000; ++t) {
+        switch (t) {
+            case 0: case 10: case 20: case 30: case 40:
+                tx.nextTrack();
+                break;
+            case 1000: tx.playDisc(1, 20, 1); break;
+            case 1010: tx.playDisc(1, 21, 1); break;
+            case 1020: tx.playDisc(1, 22, 1); break;
+            case 1030: case 1040:
+                tx.nextTrack();
+                break;
+            case 2000: case 2010: case 2020:
+                tx.sendCommand(SLINK_DEV_CDP2_LO, SLINK_CMD_NEXT_TRACK);
+                break;
+            case 2015:
+                tx.sendAsync(stopCmd, sizeof(stopCmd), onStopDone, nullptr);
+                break;
+        }
+        SlinkHal::Host::advanceMicros(1000);
+        bus.loop();
+        for (int b = 0; b < 3; ++b) {
+            if (t >= burstMs[b] && t < burstMs[b] + 900 && tx.pending() == 0 && !r.drainMs[b]) {
+                r.drainMs[b] = SlinkHal::nowMillis() - t0 - burstMs[b];
+            }
+        }
+    }
+    r.frames = tx.stats().sent;
+    r.busMs = (uint32_t)(tx.stats().busUs / 1000);
+    r.skipsResolved = tx.stats().skipsResolved;
+    r.stopWaitUs = stopDone.startUs - stopDone.queuedUs;
+    r.sent = sentFrames(25);
+    return r;
+}
+
+static void printTxQueueResult(const char* name, const TxQueueResult& r) {
+    Log.print(name);
+    Log.print(r.frames);
+    Log.print(F(" frames "));
+    Log.print(r.busMs);
+    Log.print(F(" ms bus, bursts done +"));
+    Log.print(r.drainMs[0]);
+    Log.print(F("/+"));
+    Log.print(r.drainMs[1]);
+    Log.print(F("/+"));
+    Log.print(r.drainMs[2]);
+    Log.print(F(" ms, stop waited "));
+    Log.print(r.stopWaitUs);
+    Log.print(F(" us, skips as play disc "));
+    Log.print(r.skipsResolved);
+}
+
+// Player 1's disc/track as its frames move it, up to the first play disc of
+// discByte (0 = all)
+struct TxPlayerState {
+    int  disc;
+    int  track;
+    bool stopped;
+};
+
+static TxPlayerState player1State(const std::vector<std::vector<uint8_t>>& sent, uint8_t discByte) {
+    TxPlayerState st = {5, 3, false};
+    for (const std::vector<uint8_t>& f : sent) {
+        if (f[0] != SLINK_DEV_CDP1_LO) continue;
+        if (f[1] == SLINK_CMD_PLAY_DISC) {
+            if (discByte && f[2] == discByte) break;
+            st = {SlinkCodec::decodeDiscByte(f[2], false), SlinkCodec::decodeTrackByte(f[3]), false};
+        }
+        if (f[1] == SLINK_CMD_NEXT_TRACK) st.track++;
+        if (f[1] == SLINK_CMD_STOP) st.stopped = true;
+    }
+    return st;
+}
+
+static int benchTxQueue() {
+    TxQueueResult plain = benchTxQueueRun(false, 12);
+    TxQueueResult merged = benchTxQueueRun(true, 12);
+    TxQueueResult unknown = benchTxQueueRun(true, 0);
+    TxQueueResult shortDisc = benchTxQueueRun(true, 6);
+
+    // Coalesced, player 1 goes through the same disc/track changes as with
+    // the plain queue in fewer frames: disc 5 track 8 after the first burst,
+    // disc 22 track 3 and stopped after the rest. The stop goes ahead of
+    // player 2's remaining steps. Next clicks only become a play disc to a
+    // track the disc is known to have; past that, or with the track count
+    // unknown, they step.
+    int result = 0;
+    for (const TxQueueResult* r : {&plain, &merged, &unknown, &shortDisc}) {
+        TxPlayerState first = player1State(r->sent, 0x20);
+        TxPlayerState last = player1State(r->sent, 0);
+        if (first.disc != 5 || first.track != 8) result = 1;
+        if (last.disc != 22 || last.track != 3 || !last.stopped) result = 1;
+        if (r->sent.size() != r->frames) result = 1;
+    }
+    if (merged.frames >= plain.frames || unknown.frames >= plain.frames) result = 1;
+    if (!merged.skipsResolved || unknown.skipsResolved) result = 1;
+    for (const std::vector<uint8_t>& f : shortDisc.sent) {
+        if (f[0] == SLINK_DEV_CDP1_LO && f[1] == SLINK_CMD_PLAY_DISC && f[2] == 0x05 &&
+            SlinkCodec::decodeTrackByte(f[3]) > 6) result = 1;
+    }
+    size_t stopAt = 0;
+    size_t lastStep = 0;
+    for (size_t i = 0; i < merged.sent.size(); ++i) {
+        if (merged.sent[i][0] == SLINK_DEV_CDP1_LO && merged.sent[i][1] == SLINK_CMD_STOP) stopAt = i;
+        if (merged.sent[i][0] == SLINK_DEV_CDP2_LO) lastStep = i;
+    }
+    if (stopAt > lastStep) result = 1;
+
+    SlinkHal::Host::setLogFile(stdout);
+    printTxQueueResult("[BENCH] tx queue: plain ", plain);
+    Log.println();
+    printTxQueueResult("[BENCH] tx queue: coalescing ", merged);
+    Log.println();
+    printTxQueueResult("[BENCH] tx queue: coalescing, track count unknown ", unknown);
+    Log.println();
+    printTxQueueResult("[BENCH] tx queue: coalescing, 6-track disc ", shortDisc);
+    Log.println(result ? F(", WRONG FRAMES") : F(""));
+    SlinkHal::Host::setLogFile(nullptr);
+    return result;
+}
+
+// Heavy status traffic from a changer that only waits for 1 ms of idle
+// line before each frame (4-14 bytes, 2-25 ms apart), a device that sends a
+// 4-byte frame every second without listening at all, and 100 commands at
+// random times. Blind 5 ms lead-in vs carrier sense: our frames that
+// overlapped a changer frame (from the wire), commands that got through
+// clean, collisions seen and retries.
+struct CarrierSenseResult {
+    int      frames;
+    int      collided;
+    int      clean;          // commands with at least one clean frame
+    uint32_t detected;
+    uint32_t retries;
+    uint32_t lineWaits;
+    uint32_t maxLineWaitUs;
+};
+
+static CarrierSenseResult benchCarrierSenseRun(bool sense) {
+    const int txPin = 25;
+    const int rxPin = 34;
+    const int commands = 100;
+    SlinkHal::Host::clearLines();
+    SlinkHal::Host::clearPinEvents();
+    SlinkHal::Host::wire(txPin, rxPin);
+
+    SlinkTx tx(txPin, RMT_CHANNEL_3);
+    if (sense) tx.setCarrierSense(rxPin);
+    tx.begin();
+    tx.setBlocking(false);
+    tx.setCoalescing(false);
+
+    SlinkHal::LineMonitor line;
+    line.begin(rxPin);
+
+    uint32_t seed = 12345;
+    auto rnd = [&seed](uint32_t n) {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 8) % n;
+    };
+
+    std::vector<std::pair<unsigned long, unsigned long>> changer;
+    auto transmit = [&](unsigned long at, int bytes) {
+        std::vector<uint16_t> durs;
+        durs.push_back(2400);
+        for (int b = 0; b < 8 * bytes; ++b) {
+            durs.push_back(600);
+            durs.push_back(rnd(2) ? 1200 : 600);
+        }
+        durs.push_back(600);
+        unsigned long len = 0;
+        for (uint16_t d : durs) len += d;
+        SlinkHal::Host::lineMarks(rxPin, at, durs.data(), durs.size());
+        changer.emplace_back(at, at + len);
+        return len;
+    };
+    unsigned long changerAt = SlinkHal::nowMicros();
+    unsigned long deafAt = changerAt + 500000;
+    unsigned long commandAt = changerAt + 100000;
+    int sent = 0;
+    while (sent < commands || tx.pending()) {
+        unsigned long now = SlinkHal::nowMicros();
+        if ((long)(now - changerAt) >= 0) {
+            if (!line.mark() && now - line.lastEdgeUs() >= 1000) {
+                changerAt = now + transmit(now, 4 + (int)rnd(11)) + 2000 + rnd(23000);
+            } else {
+                changerAt = now + 100;
+            }
+        }
+        if ((long)(now - deafAt) >= 0) {
+            transmit(now, 4);
+            deafAt = now + 1000000 + rnd(20000);
+        }
+        if (sent < commands && (long)(now - commandAt) >= 0) {
+            const uint8_t cmd[] = {SLINK_DEV_CDP1_LO, SLINK_CMD_PLAY_DISC,
+                                   SlinkCodec::encodeDiscByte(sent + 1), 0x01};
+            tx.sendAsync(cmd, sizeof(cmd));
+            sent++;
+            commandAt = now + 150000 + rnd(250000);
+        }
+        SlinkHal::Host::advanceMicros(100);
+        tx.loop();
+    }
+
+    CarrierSenseResult r = {};
+    std::vector<std::vector<uint8_t>> frames = sentFrames(txPin);
+    std::vector<std::pair<unsigned long, unsigned long>> spans = sentFrameSpans(txPin);
+    std::vector<bool> through(commands + 1, false);
+    for (size_t i = 0; i < spans.size() && i < frames.size(); ++i) {
+        bool overlap = false;
+        for (const auto& c : changer) {
+            if (c.first < spans[i].second && spans[i].first < c.second) overlap = true;
+        }
+        r.frames++;
+        if (overlap) r.collided++;
+        int disc = frames[i].size() == 4 ? SlinkCodec::decodeDiscByte(frames[i][2], false) : 0;
+        if (!overlap && disc >= 1 && disc <= commands) through[disc] = true;
+    }
+    for (int i = 1; i <= commands; ++i) {
+        if (through[i]) r.clean++;
+    }
+    r.detected = tx.stats().collisions;
+    r.retries = tx.stats().retries;
+    r.lineWaits = tx.stats().lineWaits;
+    r.maxLineWaitUs = tx.stats().maxLineWaitUs;
+    SlinkHal::Host::clearLines();
+    return r;
+}
+
+static void printCarrierSenseResult(const char* name, const CarrierSenseResult& r) {
+    Log.print(name);
+    Log.print(r.clean);
+    Log.print(F("/100 commands clean, "));
+    Log.print(r.collided);
+    Log.print(F("/"));
+    Log.print(r.frames);
+    Log.print(F(" frames talked over, collisions seen "));
+    Log.print(r.detected);
+    Log.print(F(", retries "));
+    Log.print(r.retries);
+    Log.print(F(", line waits "));
+    Log.print(r.lineWaits);
+    Log.print(F(" (max "));
+    Log.print(r.maxLineWaitUs);
+    Log.print(F(" us)"));
+}
+
+static int benchCarrierSense() {
+    CarrierSenseResult blind = benchCarrierSenseRun(false);
+    CarrierSenseResult sense = benchCarrierSenseRun(true);
+    int result = (sense.clean > blind.clean && sense.collided < blind.collided) ? 0 : 1;
+
+    SlinkHal::Host::setLogFile(stdout);
+    printCarrierSenseResult("[BENCH] tx blind lead-in: ", blind);
+    Log.println();
+    printCarrierSenseResult("[BENCH] tx carrier sense: ", sense);
+    Log.println(result ? F(", NO BETTER") : F(""));
+    SlinkHal::Host::setLogFile(nullptr);
+    return result;
+}
+
+// 100 play-disc commands to player 1 over a link that stretches every
+// mark by 80 us on the way back, mangles one bit of 8% of frames (the
+// changer sees the same damage) and loses 3% of the echoes. Each frame is
+// heard back 20 ms after it ends, as the RX idle threshold would.
+struct EchoResult {
+    int      frames;
+    int      delivered;     // commands the changer got intact at least once
+    uint32_t echoes;
+    uint32_t mangled;
+    uint32_t lost;
+    uint32_t resent;
+    uint32_t bitErrors;
+    uint32_t avgEchoUs;
+    int      oneErrorStartUs;   // echoed one mark vs nominal, first/last 10 frames
+    int      oneErrorEndUs;
+};
+
+static EchoResult benchEchoRun(bool verify) {
+    const int txPin = 25;
+    const int commands = 100;
+    const uint16_t skewUs = 80;
+    SlinkHal::Host::clearLines();
+    SlinkHal::Host::clearPinEvents();
+
+    SlinkDecoder decoder(34, RMT_CHANNEL_0);
+    SlinkTx tx(txPin, RMT_CHANNEL_2);
+    if (verify) decoder.events().echo.subscribe<SlinkTx, &SlinkTx::onEcho>(&tx);
+    decoder.begin();
+    tx.begin();
+    tx.setBlocking(false);
+    tx.setCoalescing(false);
+
+    uint32_t seed = 4242;
+    auto rnd = [&seed](uint32_t n) {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 8) % n;
+    };
+
+    std::vector<int> oneError;
+    std::vector<bool> delivered(commands + 1, false);
+    size_t echoed = 0;
+    unsigned long commandAt = SlinkHal::nowMicros() + 100000;
+    int sent = 0;
+    int tick = 0;
+    while (sent < commands || tx.pending() || echoed < wireFrames(txPin).size()) {
+        unsigned long now = SlinkHal::nowMicros();
+        if (sent < commands && (long)(now - commandAt) >= 0) {
+            const uint8_t cmd[] = {SLINK_DEV_CDP1_LO, SLINK_CMD_PLAY_DISC,
+                                   SlinkCodec::encodeDiscByte(sent + 1), 0x01};
+            tx.sendAsync(cmd, sizeof(cmd));
+            sent++;
+            commandAt = now + 150000 + rnd(250000);
+        }
+
+        if (++tick % 10 == 0) {
+            std::vector<WireFrame> frames = wireFrames(txPin);
+            for (; echoed < frames.size() && (long)(now - frames[echoed].endUs) >= 20000; ++echoed) {
+                WireFrame& f = frames[echoed];
+                std::vector<uint16_t> marks = f.marks;
+                for (uint16_t& m : marks) m += skewUs;
+                bool mangle = rnd(100) < 8;
+                if (mangle) {
+                    uint16_t& m = marks[1 + rnd(marks.size() - 1)];
+                    m = m > 900 + skewUs ? ZERO_US + skewUs : ONE_US + skewUs;
+                } else if (f.bytes.size() == 4) {
+                    int disc = SlinkCodec::decodeDiscByte(f.bytes[2], false);
+                    if (disc >= 1 && disc <= commands) delivered[disc] = true;
+                }
+                int oneSum = 0;
+                int ones = 0;
+                for (size_t k = 1; k < f.marks.size(); ++k) {
+                    if (f.marks[k] > 900) {
+                        oneSum += f.marks[k] + skewUs - ONE_US;
+                        ones++;
+                    }
+                }
+                if (!mangle && ones) oneError.push_back(oneSum / ones);
+                if (rnd(100) < 3) continue;     // echo lost
+                SlinkHal::Host::injectDurations(marks.data(), marks.size());
+            }
+            if (tx.pending() == 0 && echoed == frames.size() && echoed > 0) {
+                // Keep the per-tick parse short
+                SlinkHal::Host::clearPinEvents();
+                echoed = 0;
+            }
+        }
+        SlinkHal::Host::advanceMicros(100);
+        decoder.loop();
+        tx.loop();
+    }
+    for (int k = 0; k < 2000; ++k) {           // let the last echoes settle
+        SlinkHal::Host::advanceMicros(100);
+        decoder.loop();
+        tx.loop();
+    }
+
+    EchoResult r = {};
+    r.frames = (int)tx.stats().sent;
+    for (int i = 1; i <= commands; ++i) {
+        if (delivered[i]) r.delivered++;
+    }
+    r.echoes = tx.stats().echoes;
+    r.mangled = tx.stats().mangled;
+    r.lost = tx.stats().lost;
+    r.resent = tx.stats().echoRetries;
+    r.bitErrors = tx.stats().bitErrors;
+    uint32_t heard = r.echoes + r.mangled;
+    r.avgEchoUs = heard ? (uint32_t)(tx.stats().totalEchoUs / heard) : 0;
+    int n = (int)oneError.size() < 10 ? (int)oneError.size() : 10;
+    for (int i = 0; i < n; ++i) {
+        r.oneErrorStartUs += oneError[i];
+        r.oneErrorEndUs += oneError[oneError.size() - 1 - i];
+    }
+    if (n) {
+        r.oneErrorStartUs /= n;
+        r.oneErrorEndUs /= n;
+    }
+    return r;
+}
+
+static void printEchoResult(const char* name, const EchoResult& r) {
+    Log.print(name);
+    Log.print(r.delivered);
+    Log.print(F("/100 commands delivered in "));
+    Log.print(r.frames);
+    Log.print(F(" frames, echoes intact "));
+    Log.print(r.echoes);
+    Log.print(F(" mangled "));
+    Log.print(r.mangled);
+    Log.print(F(" lost "));
+    Log.print(r.lost);
+    Log.print(F(", resent "));
+    Log.print(r.resent);
+    Log.print(F(", bit errors "));
+    Log.print(r.bitErrors);
+    Log.print(F(", echo latency "));
+    Log.print(r.avgEchoUs);
+    Log.print(F(" us, one mark off by "));
+    Log.print(r.oneErrorStartUs);
+    Log.print(F(" -> "));
+    Log.print(r.oneErrorEndUs);
+    Log.print(F(" us"));
+}
+
+static int benchEcho() {
+    EchoResult off = benchEchoRun(false);
+    EchoResult on = benchEchoRun(true);
+    int result = (on.delivered > off.delivered && on.delivered == 100 &&
+                  abs(on.oneErrorEndUs) < abs(on.oneErrorStartUs)) ? 0 : 1;
+
+    SlinkHal::Host::setLogFile(stdout);
+    printEchoResult("[BENCH] tx echo unverified: ", off);
+    Log.println();
+    printEchoResult("[BENCH] tx echo verified: ", on);
+    Log.println(result ? F(", NO BETTER") : F(""));
+    SlinkHal::Host::setLogFile(nullptr);
+    return result;
+}
+
+// Echoes expected but none coming back, with frames short enough that more
+// than VERIFY_LEN are out within the echo timeout: the oldest is given up on
+// while the next one completes, and its resend can go ahead of it. Rounds of
+// commands at every priority, in a shuffled order: several to player 1 and
+// one to player 2, so that player 2's is free to be resent. Each command
+// must complete once, and go out 1 + retries times.
+struct VerifyCommand {
+    uint8_t bytes[4];
+    int     len;
+    int     completions;
+    uint8_t retries;
+};
+
+static void onVerifyDone(void* ctx, const SlinkTxCompletion& c) {
+    VerifyCommand* cmd = static_cast<VerifyCommand*>(ctx);
+    cmd->completions++;
+    cmd->retries = c.retries;
+}
+
+static int benchVerifyFull() {
+    const int txPin = 25;
+    const int rounds = 20;
+    SlinkHal::Host::clearLines();
+    SlinkHal::Host::clearPinEvents();
+
+    SlinkTx tx(txPin, RMT_CHANNEL_2);
+    tx.begin();
+    tx.setBlocking(false);
+    tx.setCoalescing(false);
+    SlinkTxTiming timing;
+    timing.syncUs = 2000;
+    timing.oneUs = 1000;
+    timing.zeroUs = 300;
+    timing.delimiterUs = 100;
+    timing.leadInUs = 200;
+    timing.trailUs = 200;
+    tx.setTiming(timing);
+    tx.setCalibration(false);
+
+    uint32_t seed = 777;
+    auto rnd = [&seed](uint32_t n) {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 8) % n;
+    };
+
+    int wrong = 0;
+    int frames = 0;
+    uint32_t resent = 0;
+    for (int round = 0; round < rounds; ++round) {
+        const uint8_t disc = SlinkCodec::encodeDiscByte(2 * round + 1);
+        const uint8_t player2[] = {SLINK_CMD_STOP, SLINK_CMD_POWER_OFF, SLINK_CMD_PLAY};
+        VerifyCommand cmds[] = {
+            {{SLINK_DEV_CDP2_LO, player2[round % 3]}, 2, 0, 0},
+            {{SLINK_DEV_CDP1_LO, SLINK_CMD_PLAY_DISC, disc, 0x01}, 4, 0, 0},
+            {{SLINK_DEV_CDP1_LO, SLINK_CMD_PLAY}, 2, 0, 0},
+            {{SLINK_DEV_CDP1_LO, SLINK_CMD_POWER_ON}, 2, 0, 0},
+            {{SLINK_DEV_CDP1_LO, SLINK_CMD_PAUSE}, 2, 0, 0},
+            {{SLINK_DEV_CDP1_LO, SLINK_CMD_PLAY_DISC, (uint8_t)(disc + 1), 0x01}, 4, 0, 0},
+        };
+        const int n = sizeof(cmds) / sizeof(cmds[0]);
+        int order[n];
+        for (int i = 0; i < n; ++i) order[i] = i;
+        for (int i = n - 1; i > 0; --i) std::swap(order[i], order[rnd(i + 1)]);
+
+        // Verification gives up after a few lost echoes; hear one per round
+        const SlinkEchoEvent heard = {};
+        tx.onEcho(heard);
+        SlinkHal::Host::clearPinEvents();
+        for (int i = 0; i < n; ++i) {
+            tx.sendAsync(cmds[order[i]].bytes, cmds[order[i]].len, onVerifyDone, &cmds[order[i]]);
+        }
+        for (int k = 0; k < 5000 && (tx.pending() || k < 3000); ++k) {
+            SlinkHal::Host::advanceMicros(100);
+            tx.loop();
+        }
+
+        std::vector<std::vector<uint8_t>> sent = sentFrames(txPin);
+        frames += (int)sent.size();
+        for (VerifyCommand& c : cmds) {
+            int out = 0;
+            for (const std::vector<uint8_t>& f : sent) {
+                out += (int)f.size() == c.len && memcmp(f.data(), c.bytes, c.len) == 0;
+            }
+            resent += c.retries;
+            if (c.completions != 1 || out != 1 + c.retries) wrong++;
+        }
+    }
+
+    SlinkHal::Host::setLogFile(stdout);
+    Log.print(F("[BENCH] tx verify ring full: "));
+    Log.print(rounds * 6);
+    Log.print(F(" commands, "));
+    Log.print(frames);
+    Log.print(F(" frames, "));
+    Log.print(tx.stats().lost);
+    Log.print(F(" echoes lost, resent "));
+    Log.print(resent);
+    Log.print(F(", "));
+    Log.print(wrong);
+    Log.println(F(" wrong"));
+    SlinkHal::Host::setLogFile(nullptr);
+    return wrong ? 1 : 0;
+}
+
+// The main loop stalls (an HTTP call) from just after a play disc goes out
+// until well after its echo came back, so the decoder hands over the echo
+// before the transmitter has seen its frame end. It must still count as
+// verified, and the command go out once.
+static SlinkTxCompletion stallDone;
+static void onStallDone(void*, const SlinkTxCompletion& c) {
+    stallDone = c;
+}
+
+static int benchEchoStall() {
+    SlinkHal::Host::clearLines();
+    SlinkHal::Host::clearPinEvents();
+    SlinkBus bus(0, {34, 25, RMT_CHANNEL_0, RMT_CHANNEL_2});
+    bus.begin();
+    SlinkTx& tx = bus.tx;
+    tx.setBlocking(false);
+    const SlinkEchoEvent heard = {};
+    tx.onEcho(heard);                           // verifying from here on
+
+    stallDone = SlinkTxCompletion{};
+    const uint8_t cmd[] = {SLINK_DEV_CDP1_LO, SLINK_CMD_PLAY_DISC, SlinkCodec::encodeDiscByte(12), 0x01};
+    tx.sendAsync(cmd, sizeof(cmd), onStallDone, nullptr);
+    for (int k = 0; k < 100 && SlinkHal::Host::pinEventCount() == 0; ++k) {
+        SlinkHal::Host::advanceMicros(100);
+        bus.loop();
+    }
+    SlinkHal::Host::advanceMicros(3000UL * 1000UL);
+    injectFrame(cmd, sizeof(cmd));
+    for (int k = 0; k < 2000; ++k) {
+        SlinkHal::Host::advanceMicros(1000);
+        bus.loop();
+    }
+
+    const SlinkTxStats& st = tx.stats();
+    size_t frames = sentFrames(25).size();
+    int result = (frames == 1 && st.echoes == 1 && st.lost == 0 && st.echoRetries == 0 &&
+                  stallDone.verified) ? 0 : 1;
+
+    SlinkHal::Host::setLogFile(stdout);
+    Log.print(F("[BENCH] tx echo after a 3 s loop stall: "));
+    Log.print((uint32_t)frames);
+    Log.print(F(" frames, intact "));
+    Log.print(st.echoes);
+    Log.print(F(" lost "));
+    Log.print(st.lost);
+    Log.print(F(" resent "));
+    Log.print(st.echoRetries);
+    Log.println(result ? F(", WRONG") : F(""));
+    SlinkHal::Host::setLogFile(nullptr);
+    return result;
+}
+
+// A Command Mode 3 changer that talks without listening first: a heartbeat
+// every second and an extended status frame every 3 s, a few ms of jitter.
+// The other changer sends status frames at random once the line has been
+// idle 1 ms. Changer frames reach the decoder 20 ms after they end, unless
+// one of ours garbled them. 10 s to learn the cadences, then 200 play-disc
+// commands; carrier sense alone against carrier sense plus the bus-load
+// slot check.
+struct ScheduleResult {
+    int      frames;
+    int      collided;
+    int      clean;             // commands with at least one clean frame
+    uint32_t collisions;        // seen by the transmitter
+    uint32_t deferred;
+    uint32_t avgLatencyUs;      // queued until done (retries included)
+    uint32_t maxLatencyUs;
+    int      garbled;           // changer frames we talked over
+    int      periodic;
+    uint16_t utilization;       // per mille
+};
+
+static uint64_t scheduleLatencySum;
+static uint32_t scheduleLatencyMax;
+static int      scheduleDone;
+static void onScheduleDone(void*, const SlinkTxCompletion& c) {
+    uint32_t us = c.doneUs - c.queuedUs;
+    scheduleLatencySum += us;
+    if (us > scheduleLatencyMax) scheduleLatencyMax = us;
+    scheduleDone++;
+}
+
+static ScheduleResult benchScheduleRun(bool predict) {
+    const int txPin = 25;
+    const int rxPin = 34;
+    const int commands = 200;
+    SlinkHal::Host::clearLines();
+    SlinkHal::Host::clearPinEvents();
+    SlinkHal::Host::wire(txPin, rxPin);
+    scheduleLatencySum = 0;
+    scheduleLatencyMax = 0;
+    scheduleDone = 0;
+
+    SlinkDecoder decoder(rxPin, RMT_CHANNEL_0);
+    SlinkBusLoad load(0);
+    decoder.events().traffic.subscribe<SlinkBusLoad, &SlinkBusLoad::onTraffic>(&load);
+    decoder.begin();
+    SlinkTx tx(txPin, RMT_CHANNEL_3);
+    tx.setCarrierSense(rxPin);
+    if (predict) tx.setSlotCheck(SlinkBusLoad::txSlot, &load);
+    tx.begin();
+    tx.setBlocking(false);
+    tx.setCoalescing(false);
+
+    SlinkHal::LineMonitor line;
+    line.begin(rxPin);
+
+    uint32_t seed = 777;
+    auto rnd = [&seed](uint32_t n) {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 8) % n;
+    };
+
+    struct Heard {
+        std::vector<uint16_t> durs;
+        unsigned long         startUs;
+        unsigned long         endUs;
+    };
+    std::vector<Heard> changer;
+    size_t injected = 0;
+    auto transmit = [&](unsigned long at, const uint8_t* bytes, int len) {
+        Heard h;
+        appendFrame(h.durs, bytes, len);
+        unsigned long total = 0;
+        for (uint16_t d : h.durs) total += d;
+        h.startUs = at;
+        h.endUs = at + total;
+        SlinkHal::Host::lineMarks(rxPin, at, h.durs.data(), h.durs.size());
+        changer.push_back(h);
+        return total;
+    };
+
+    const uint8_t heartbeat[] = {0x41, 0x04, 0x00, 0x55};
+    const uint8_t ext14[] = {0x41, 0x51, 0x15, 0x00, 0x00, 0x00, 0x50, 0x00,
+                             0x00, 0x00, 0x00, 0x01, 0x00, 0x00};
+    unsigned long t0 = SlinkHal::nowMicros();
+    unsigned long heartbeatAt = t0 + 300000;
+    unsigned long ext14At = t0 + 700000;
+    unsigned long statusAt = t0 + 1000000;
+    unsigned long commandAt = t0 + 10000000;
+    int sent = 0;
+    while (sent < commands || tx.pending()) {
+        unsigned long now = SlinkHal::nowMicros();
+        if ((long)(now - heartbeatAt) >= 0) {
+            transmit(now, heartbeat, sizeof(heartbeat));
+            heartbeatAt += 1000000 + rnd(6000) - 3000;
+        }
+        if ((long)(now - ext14At) >= 0) {
+            transmit(now, ext14, sizeof(ext14));
+            ext14At += 3000000 + rnd(6000) - 3000;
+        }
+        if ((long)(now - statusAt) >= 0) {
+            if (!line.mark() && now - line.lastEdgeUs() >= 1000) {
+                uint8_t bytes[12];
+                int len = buildTrackStatus(bytes, 1, 1 + (int)rnd(300), 1 + (int)rnd(20));
+                transmit(now, bytes, len);
+                statusAt = now + 500000 + rnd(2500000);
+            } else {
+                statusAt = now + 100;
+            }
+        }
+        if (sent < commands && (long)(now - commandAt) >= 0) {
+            const uint8_t cmd[] = {SLINK_DEV_CDP1_LO, SLINK_CMD_PLAY_DISC,
+                                   SlinkCodec::encodeDiscByte(sent + 1), 0x01};
+            tx.sendAsync(cmd, sizeof(cmd), onScheduleDone);
+            sent++;
+            commandAt = now + 150000 + rnd(250000);
+        }
+
+        // Heard 20 ms after it ends (the RX idle threshold), if intact
+        for (; injected < changer.size() &&
+               (long)(now - changer[injected].endUs) >= SlinkCapture::IDLE_THRESHOLD_US; ++injected) {
+            const Heard& h = changer[injected];
+            bool garbled = false;
+            for (const auto& span : sentFrameSpans(txPin)) {
+                if (span.first < h.endUs && h.startUs < span.second) garbled = true;
+            }
+            if (!garbled) SlinkHal::Host::injectDurations(h.durs.data(), h.durs.size());
+        }
+
+        SlinkHal::Host::advanceMicros(100);
+        decoder.loop();
+        tx.loop();
+    }
+
+    ScheduleResult r = {};
+    std::vector<std::vector<uint8_t>> frames = sentFrames(txPin);
+    std::vector<std::pair<unsigned long, unsigned long>> spans = sentFrameSpans(txPin);
+    std::vector<bool> through(commands + 1, false);
+    for (size_t i = 0; i < spans.size() && i < frames.size(); ++i) {
+        bool overlap = false;
+        for (const Heard& h : changer) {
+            if (h.startUs < spans[i].second && spans[i].first < h.endUs) overlap = true;
+        }
+        r.frames++;
+        if (overlap) r.collided++;
+        int disc = frames[i].size() == 4 ? SlinkCodec::decodeDiscByte(frames[i][2], false) : 0;
+        if (!overlap && disc >= 1 && disc <= commands) through[disc] = true;
+    }
+    for (int i = 1; i <= commands; ++i) {
+        if (through[i]) r.clean++;
+    }
+    for (const Heard& h : changer) {
+        for (const auto& span : spans) {
+            if (h.startUs < span.second && span.first < h.endUs) {
+                r.garbled++;
+                break;
+            }
+        }
+    }
+    r.collisions = tx.stats().collisions;
+    r.deferred = tx.stats().deferred;
+    r.avgLatencyUs = scheduleDone ? (uint32_t)(scheduleLatencySum / scheduleDone) : 0;
+    r.maxLatencyUs = scheduleLatencyMax;
+    r.periodic = load.periodicSources();
+    r.utilization = load.utilizationTotal();
+    SlinkHal::Host::clearLines();
+    return r;
+}
+
+static void printScheduleResult(const char* name, const ScheduleResult& r) {
+    Log.print(name);
+    Log.print(r.clean);
+    Log.print(F("/200 commands clean, "));
+    Log.print(r.collided);
+    Log.print(F("/"));
+    Log.print(r.frames);
+    Log.print(F(" frames talked over, "));
+    Log.print(r.garbled);
+    Log.print(F(" changer frames garbled, collisions seen "));
+    Log.print(r.collisions);
+    Log.print(F(", deferred "));
+    Log.print(r.deferred);
+    Log.print(F(", latency avg "));
+    Log.print(r.avgLatencyUs / 1000);
+    Log.print(F(" ms max "));
+    Log.print(r.maxLatencyUs / 1000);
+    Log.print(F(" ms ("));
+    Log.print(r.periodic);
+    Log.print(F(" periodic sources, changer load "));
+    Log.print(r.utilization / 10);
+    Log.print('.');
+    Log.print(r.utilization % 10);
+    Log.print(F("%)"));
+}
+
+static int benchSchedule() {
+    ScheduleResult plain = benchScheduleRun(false);
+    ScheduleResult predicted = benchScheduleRun(true);
+    // Waiting out a predicted frame costs about what a detected collision
+    // and resend would, so latency should hold, not drop
+    int result = (predicted.collided < plain.collided && predicted.garbled < plain.garbled &&
+                  predicted.avgLatencyUs <= plain.avgLatencyUs + plain.avgLatencyUs / 10) ? 0 : 1;
+
+    SlinkHal::Host::setLogFile(stdout);
+    printScheduleResult("[BENCH] tx carrier sense only: ", plain);
+    Log.println();
+    printScheduleResult("[BENCH] tx predicted slots: ", predicted);
+    Log.println(result ? F(", NO BETTER") : F(""));
+    SlinkHal::Host::setLogFile(nullptr);
+    return result;
+}
+
+// Backend commands against a scripted player 1 that reacts to what it
+// hears on the TX pin: a play disc is answered with 0x40 (loading), then
+// three status frames for the disc and a play once it is in. Old behaviour
+// acked every command as done the moment it was sent.
+struct ConfirmScenario {
+    const char*        name;
+    SlinkConfirmAction action;
+    int                disc;
+    int                track;
+    int                deafFrames;  // frames the changer doesn't hear
+    bool               emptySlot;   // loads, finds nothing, stops
+    bool               expect;
+};
+
+// A changer as the benches script it: frames to inject once the clock
+// reaches them, reacting to the commands it hears on the TX pin
+struct ChangerEvent {
+    unsigned long      atUs;
+    std::vector<uint8_t> bytes;
+};
+
+struct ScriptedChanger {
+    int    player = 1;
+    int    disc = 5;
+    int    track = 3;
+    size_t heard = 0;
+    size_t pinEvents = 0;
+    std::vector<ChangerEvent> script;
+
+    void at(unsigned long delayMs, std::vector<uint8_t> bytes) {
+        script.push_back(ChangerEvent{SlinkHal::nowMicros() + delayMs * 1000, bytes});
+    }
+    void transport(unsigned long delayMs, uint8_t code) {
+        at(delayMs, {0x41, SlinkDevices::PLAYERS[player - 1].rxLo, 0x00, code});
+    }
+    // Three of them, for the decoder's 2-of-3
+    void status(unsigned long delayMs) {
+        uint8_t bytes[12];
+        int len = buildTrackStatus(bytes, player, disc, track);
+        for (int i = 0; i < 3; ++i) at(delayMs + 100 * i, std::vector<uint8_t>(bytes, bytes + len));
+    }
+
+    // Commands to this player that went out since the last call
+    std::vector<WireFrame> commands(int txPin) {
+        std::vector<WireFrame> out;
+        if (SlinkHal::Host::pinEventCount() == pinEvents) return out;
+        pinEvents = SlinkHal::Host::pinEventCount();
+        std::vector<WireFrame> frames = wireFrames(txPin);
+        for (; heard < frames.size(); ++heard) {
+            const WireFrame& f = frames[heard];
+            if (f.bytes.size() >= 2 && SlinkDevices::playerForTxDevice(f.bytes[0]) == player) out.push_back(f);
+        }
+        return out;
+    }
+
+    // Our own frame back off the wire, once the RX capture has gone idle
+    void echo(const WireFrame& f) {
+        script.push_back(ChangerEvent{f.endUs + SlinkCapture::IDLE_THRESHOLD_US, f.bytes});
+    }
+
+    void inject() {
+        unsigned long now = SlinkHal::nowMicros();
+        for (size_t i = 0; i < script.size();) {
+            if ((long)(now - script[i].atUs) >= 0) {
+                injectFrame(script[i].bytes.data(), (int)script[i].bytes.size());
+                script.erase(script.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+    }
+};
+
+static SlinkConfirmResult confirmResult;
+static bool               confirmDone;
+static void onConfirmResult(void*, const SlinkConfirmResult& r) {
+    confirmResult = r;
+    confirmDone = true;
+}
+
+static int burstConfirmed;
+static int burstFailed;
+static void onBurstResult(void*, const SlinkConfirmResult& r) {
+    if (r.action != SLINK_CONFIRM_NEXT) return;
+    if (r.success) {
+        burstConfirmed++;
+    } else {
+        burstFailed++;
+    }
+}
+
+static int benchConfirmCommands() {
+    const ConfirmScenario scenarios[] = {
+        {"play disc",          SLINK_CONFIRM_PLAY_DISC, 12, 1, 0,   false, true},
+        {"play disc, 1 lost",  SLINK_CONFIRM_PLAY_DISC, 30, 2, 1,   false, true},
+        {"play disc, empty",   SLINK_CONFIRM_PLAY_DISC, 77, 1, 0,   true,  false},
+        {"next",               SLINK_CONFIRM_NEXT,      0,  0, 0,   false, true},
+        {"pause",              SLINK_CONFIRM_PAUSE,     0,  0, 0,   false, true},
+        {"stop, changer deaf", SLINK_CONFIRM_STOP,      0,  0, 100, false, false},
+    };
+    const int txPin = 25;
+    SlinkBus bus(0, {34, txPin, RMT_CHANNEL_0, RMT_CHANNEL_2});
+    bus.begin();
+    bus.tx.setBlocking(false);
+    bus.confirm.results().subscribe(onConfirmResult);
+    SlinkHal::Host::clearPinEvents();
+
+    ScriptedChanger changer;
+    changer.status(0);
+    changer.transport(400, 0x00);
+
+    int result = 0;
+    int optimisticWrong = 0;
+    std::vector<SlinkConfirmResult> results;
+    for (const ConfirmScenario& sc : scenarios) {
+        int deaf = sc.deafFrames;
+        confirmDone = false;
+        bool issued = false;
+        unsigned long startUs = SlinkHal::nowMicros();
+        while (!confirmDone && SlinkHal::nowMicros() - startUs < 30000000UL) {
+            unsigned long now = SlinkHal::nowMicros();
+            if (!issued && now - startUs >= 1000000) {
+                bus.confirm.issue(sc.name, sc.action, 1, sc.disc, sc.track);
+                issued = true;
+            }
+
+            // The changer acts on each frame it hears
+            for (const WireFrame& w : changer.commands(txPin)) {
+                const std::vector<uint8_t>& f = w.bytes;
+                if (deaf-- > 0) continue;
+                if (f[1] == SLINK_CMD_PLAY_DISC && f.size() == 4) {
+                    changer.transport(300, 0x40);
+                    if (sc.emptySlot) {
+                        changer.transport(6000, 0x01);
+                    } else {
+                        changer.disc = SlinkCodec::decodeDiscByte(f[2], f[0] == SLINK_DEV_CDP1_HI);
+                        changer.track = SlinkCodec::decodeTrackByte(f[3]);
+                        changer.status(4000);
+                        changer.transport(4400, 0x00);
+                    }
+                } else if (f[1] == SLINK_CMD_NEXT_TRACK) {
+                    changer.track++;
+                    changer.status(500);
+                } else if (f[1] == SLINK_CMD_PAUSE) {
+                    changer.transport(200, 0x04);
+                } else if (f[1] == SLINK_CMD_STOP) {
+                    changer.transport(200, 0x01);
+                }
+            }
+            changer.inject();
+
+            SlinkHal::Host::advanceMicros(1000);
+            bus.loop();
+        }
+        if (!confirmDone || confirmResult.success != sc.expect) result = 1;
+        if (!sc.expect) optimisticWrong++;
+        results.push_back(confirmResult);
+    }
+
+    // Three quick next from the UI, 10 ms apart: the first is on the wire
+    // when the others come and they fold into its skip. The changer reports
+    // once it has settled. All three are confirmed, none superseded.
+    const uint32_t scenariosConfirmed = bus.confirm.stats().confirmed;
+    bus.confirm.results().subscribe(onBurstResult);
+    const int burstFrom = changer.track;
+    const uint32_t coalescedBefore = bus.tx.stats().coalesced;
+    unsigned long burstUs = SlinkHal::nowMicros();
+    unsigned long statusAtUs = 0;
+    for (int issued = 0; burstConfirmed + burstFailed < 3 && SlinkHal::nowMicros() - burstUs < 10000000UL;) {
+        unsigned long now = SlinkHal::nowMicros();
+        if (issued < 3 && now - burstUs >= 1000000UL + 10000UL * issued) {
+            bus.confirm.issue("burst next", SLINK_CONFIRM_NEXT, 1);
+            issued++;
+        }
+        for (const WireFrame& w : changer.commands(txPin)) {
+            if (w.bytes[1] != SLINK_CMD_NEXT_TRACK) continue;
+            changer.track++;
+            statusAtUs = now + 500000;
+        }
+        if (statusAtUs && (long)(now - statusAtUs) >= 0) {
+            changer.status(0);
+            statusAtUs = 0;
+        }
+        changer.inject();
+
+        SlinkHal::Host::advanceMicros(1000);
+        bus.loop();
+    }
+    const uint32_t burstCoalesced = bus.tx.stats().coalesced - coalescedBefore;
+    if (burstConfirmed != 3 || changer.track != burstFrom + 3 || !burstCoalesced) result = 1;
+
+    SlinkHal::Host::setLogFile(stdout);
+    Log.print(F("[BENCH] confirm commands: "));
+    Log.print(scenariosConfirmed);
+    Log.print(F("/"));
+    Log.print((int)(sizeof(scenarios) / sizeof(scenarios[0])));
+    Log.print(F(" confirmed, "));
+    Log.print(bus.confirm.stats().resent);
+    Log.print(F(" resent, "));
+    Log.print(optimisticWrong);
+    Log.println(F(" that an immediate ack would have reported as done"));
+    Log.print(F("  3 quick next: "));
+    Log.print(burstConfirmed);
+    Log.print(F(" confirmed, "));
+    Log.print(burstFailed);
+    Log.print(F(" failed, "));
+    Log.print(burstCoalesced);
+    Log.print(F(" coalesced, changer moved "));
+    Log.print(changer.track - burstFrom);
+    Log.println(F(" tracks"));
+    for (size_t i = 0; i < results.size(); ++i) {
+        Log.print(F("  "));
+        Log.print(scenarios[i].name);
+        Log.print(F(": "));
+        Log.print(results[i].reason);
+        Log.print(F(" after "));
+        Log.print(results[i].latencyMs);
+        Log.print(F(" ms, "));
+        Log.print(results[i].attempts);
+        Log.print(F(" sent"));
+        Log.println(results[i].success == scenarios[i].expect ? F("") : F(", UNEXPECTED"));
+    }
+    SlinkHal::Host::setLogFile(nullptr);
+    return result;
+}
+
+// Load time model from a sweep against a scripted changer whose carousel
+// takes SEEK_BASE_MS + SEEK_PER_SLOT_MS per slot of distance (plus some
+// jitter), then predictions for (from, to) pairs the sweep never played,
+// against the one number we'd have without a model: the mean load time.
+// Also reloads the model from the store into a fresh bus.
+static const uint32_t SEEK_BASE_MS = 1200;
+static const uint32_t SEEK_PER_SLOT_MS = 45;
+static const uint32_t SEEK_SAME_DISC_MS = 800;
+
+static uint32_t seekMs(int from, int to) {
+    int d = SlinkSeekProfile::distance(from, to);
+    return d ? SEEK_BASE_MS + SEEK_PER_SLOT_MS * d : SEEK_SAME_DISC_MS;
+}
+
+static int benchSeekProfile() {
+    const int txPin = 25;
+    const int sweep = 24;
+    SlinkHal::Host::clearStore();
+    SlinkBus bus(0, {34, txPin, RMT_CHANNEL_0, RMT_CHANNEL_2});
+    bus.begin();
+    bus.tx.setBlocking(false);
+    SlinkHal::Host::clearPinEvents();
+
+    ScriptedChanger changer;
+    changer.status(0);
+    for (int i = 0; i < 100; ++i) {
+        SlinkHal::Host::advanceMicros(10000);
+        changer.inject();
+        bus.loop();
+    }
+
+    uint32_t noise = 12345;
+    uint64_t totalMs = 0;
+    int loads = 0;
+    bus.seek.startSweep(bus.tx, &bus.inventory, 1, sweep);
+    unsigned long startUs = SlinkHal::nowMicros();
+    while ((bus.seek.sweeping() || bus.tx.pending() || !changer.script.empty()) &&
+           SlinkHal::nowMicros() - startUs < (unsigned long)sweep * 40000000UL) {
+        for (const WireFrame& w : changer.commands(txPin)) {
+            const std::vector<uint8_t>& f = w.bytes;
+            changer.echo(w);
+            if (f[1] != SLINK_CMD_PLAY_DISC || f.size() != 4) continue;
+            int to = SlinkCodec::decodeDiscByte(f[2], f[0] == SLINK_DEV_CDP1_HI);
+            if (to == changer.disc) continue;
+            noise = noise * 1103515245 + 12345;
+            uint32_t ms = seekMs(changer.disc, to) + (noise >> 16) % 301 - 150;
+            totalMs += ms;
+            loads++;
+            changer.transport(300, 0x40);
+            changer.disc = to;
+            changer.track = 1;
+            changer.status(ms);
+            changer.transport(ms + 400, 0x00);
+        }
+        changer.inject();
+        SlinkHal::Host::advanceMicros(1000);
+        bus.loop();
+    }
+    uint32_t samples = bus.seek.sampleCount(1);
+    bus.seek.save();
+
+    // Pairs the sweep never played
+    uint32_t meanMs = loads ? (uint32_t)(totalMs / loads) : 0;
+    uint64_t modelErr = 0, flatErr = 0;
+    int pairs = 0, unknown = 0, reloaded = 0;
+    SlinkBus fresh(0, {34, txPin, RMT_CHANNEL_0, RMT_CHANNEL_2});
+    fresh.begin();
+    for (int i = 0; i < 40; ++i) {
+        int from = (i * 37) % 300 + 1;
+        int to = (i * 113 + 50) % 300 + 1;
+        uint32_t actual = seekMs(from, to);
+        uint32_t predicted = bus.seek.predictMs(1, from, to);
+        if (!predicted) unknown++;
+        if (fresh.seek.predictMs(1, from, to) == predicted) reloaded++;
+        modelErr += predicted > actual ? predicted - actual : actual - predicted;
+        flatErr += meanMs > actual ? meanMs - actual : actual - meanMs;
+        pairs++;
+    }
+
+    SlinkHal::Host::setLogFile(stdout);
+    float base = 0, perSlot = 0;
+    bus.seek.fit(1, &base, &perSlot);
+    Log.print(F("[BENCH] seek profile: "));
+    Log.print(samples);
+    Log.print(F("/"));
+    Log.print(loads);
+    Log.print(F(" loads timed, fit "));
+    Log.print((int)base);
+    Log.print(F(" ms + "));
+    Log.print(perSlot, 1);
+    Log.print(F(" ms/slot (changer "));
+    Log.print(SEEK_BASE_MS);
+    Log.print(F(" + "));
+    Log.print(SEEK_PER_SLOT_MS);
+    Log.println(F(")"));
+    Log.print(F("  unseen pairs: model off by "));
+    Log.print((uint32_t)(modelErr / pairs));
+    Log.print(F(" ms on average, a flat "));
+    Log.print(meanMs);
+    Log.print(F(" ms guess by "));
+    Log.print((uint32_t)(flatErr / pairs));
+    Log.print(F(" ms; "));
+    Log.print(reloaded);
+    Log.print(F("/"));
+    Log.print(pairs);
+    Log.print(F(" predictions identical after reload, "));
+    Log.print(SlinkHal::Host::storeWrites());
+    Log.println(F(" saves"));
+    SlinkHal::Host::setLogFile(nullptr);
+
+    return (samples < (uint32_t)sweep * 3 / 4 || unknown || reloaded != pairs ||
+            modelErr * 2 > flatErr) ? 1 : 0;
+}
+
+// Both changers playing through a queue of discs (3 tracks of 20 s each),
+// their carousels as in benchSeekProfile. Measured between one disc's
+// audio ending and the next one's starting, and any time both play at once:
+//   backend    the disc end reaches the backend, which queues "play" for
+//              the next disc; the ESP32 polls it BACKEND_ROUND_TRIP_MS
+//              later and starts it cold
+//   playlist   the queue on the ESP32, next disc pre-positioned
+static const unsigned long BACKEND_ROUND_TRIP_MS = 1000;
+
+struct SimPlayer {
+    enum Mode { STOPPED, LOADING, PLAYING, PAUSED };
+    ScriptedChanger out;
+    Mode          mode = STOPPED;
+    int           tracks = 3;
+    uint32_t      trackMs = 20000;
+    uint32_t      elapsedMs = 0;
+    unsigned long loadDoneUs = 0;
+    unsigned long lastUs = 0;
+    unsigned long heartbeatUs = 0;
+    bool          pauseAfterLoad = false;
+    int           loads = 0;
+    // Slots holding a disc (all if null); on an empty one it stops, or
+    // says nothing more after 0x40 if silentWhenEmpty
+    const std::vector<bool>* slots = nullptr;
+    bool          silentWhenEmpty = false;
+    std::vector<std::pair<unsigned long, bool>>* audio = nullptr;   // (us, started)
+
+    void sound(unsigned long delayMs, bool on) {
+        audio->push_back({SlinkHal::nowMicros() + delayMs * 1000, on});
+    }
+
+    void command(const WireFrame& f) {
+        const std::vector<uint8_t>& b = f.bytes;
+        out.echo(f);
+        if (b[1] == SLINK_CMD_PLAY_DISC && b.size() == 4) {
+            if (mode == PLAYING) sound(0, false);
+            int to = SlinkCodec::decodeDiscByte(b[2], SlinkDevices::PLAYERS[out.player - 1].txHi == b[0]);
+            loadDoneUs = SlinkHal::nowMicros() + seekMs(out.disc, to) * 1000;
+            out.disc = to;
+            out.track = 1;
+            elapsedMs = 0;
+            pauseAfterLoad = false;
+            mode = LOADING;
+            loads++;
+            out.transport(300, 0x40);
+        } else if (b[1] == SLINK_CMD_PAUSE) {
+            if (mode == LOADING) {
+                pauseAfterLoad = !pauseAfterLoad;
+            } else if (mode == PLAYING) {
+                mode = PAUSED;
+                out.transport(200, 0x04);
+                sound(200, false);
+            } else if (mode == PAUSED) {
+                mode = PLAYING;
+                out.transport(200, 0x00);
+                sound(200, true);
+            }
+        } else if (b[1] == SLINK_CMD_STOP && mode != STOPPED) {
+            if (mode == PLAYING) sound(200, false);
+            mode = STOPPED;
+            out.transport(200, 0x01);
+        }
+    }
+
+    void tick() {
+        unsigned long now = SlinkHal::nowMicros();
+        if (out.player == SlinkDevices::heartbeatPlayer() && (long)(now - heartbeatUs) >= 0) {
+            out.at(0, {0x41, SlinkDevices::HEARTBEAT_DEVICE, 0x00, 0x55});
+            heartbeatUs = now + 5000000UL;
+        }
+        if (mode == LOADING && (long)(now - loadDoneUs) >= 0 && slots && !(*slots)[out.disc - 1]) {
+            mode = STOPPED;
+            if (!silentWhenEmpty) out.transport(0, 0x01);
+        } else if (mode == LOADING && (long)(now - loadDoneUs) >= 0) {
+            out.status(0);
+            mode = pauseAfterLoad ? PAUSED : PLAYING;
+            out.transport(400, pauseAfterLoad ? 0x04 : 0x00);
+            if (!pauseAfterLoad) sound(400, true);
+        } else if (mode == PLAYING) {
+            elapsedMs += (now - lastUs) / 1000;
+            int track = elapsedMs / trackMs + 1;
+            if (track > tracks) {
+                mode = STOPPED;
+                out.transport(0, 0x01);
+                sound(0, false);
+            } else if (track != out.track) {
+                out.track = track;
+                out.status(0);
+            }
+        }
+        lastUs = now;
+    }
+};
+
+struct QueueResult {
+    std::vector<uint32_t> gapsMs;
+    uint32_t overlapMs = 0;
+    int      played = 0;
+};
+
+static QueueResult benchQueueRun(bool engine, const SlinkPlaylistEntry* queue, int count) {
+    const int txPin = 25;
+    SlinkHal::Host::clearPinEvents();
+    SlinkBus bus(0, {34, txPin, RMT_CHANNEL_0, RMT_CHANNEL_2});
+    bus.begin();
+    bus.tx.setBlocking(false);
+
+    std::vector<std::pair<unsigned long, bool>> audio;
+    SimPlayer players[2];
+    for (int p = 0; p < 2; ++p) {
+        players[p].out.player = p + 1;
+        players[p].out.disc = 1;
+        players[p].audio = &audio;
+        players[p].lastUs = SlinkHal::nowMicros();
+    }
+
+    if (engine) {
+        bus.playlist.load(queue, count);
+    } else {
+        bus.tx.playDisc(queue[0].player, queue[0].disc, 1);
+    }
+
+    int current = 0;
+    unsigned long coldAtUs = 0;
+    bool coldPending = false;
+    size_t seen = 0;
+    unsigned long startUs = SlinkHal::nowMicros();
+    while (SlinkHal::nowMicros() - startUs < (unsigned long)count * 90000000UL) {
+        for (SimPlayer& p : players) {
+            for (const WireFrame& f : p.out.commands(txPin)) p.command(f);
+            p.tick();
+            p.out.inject();
+        }
+
+        // Backend-driven: the end of a disc turns into a cold start later
+        for (; seen < audio.size(); ++seen) {
+            if (!engine && !audio[seen].second && current + 1 < count &&
+                players[queue[current].player - 1].mode == SimPlayer::STOPPED) {
+                coldAtUs = audio[seen].first + BACKEND_ROUND_TRIP_MS * 1000;
+                coldPending = true;
+            }
+        }
+        if (coldPending && (long)(SlinkHal::nowMicros() - coldAtUs) >= 0) {
+            coldPending = false;
+            current++;
+            bus.tx.playDisc(queue[current].player, queue[current].disc, 1);
+        }
+
+        SlinkHal::Host::advanceMicros(1000);
+        bus.loop();
+        int ended = 0;
+        for (const auto& a : audio) ended += !a.second;
+        if (engine ? !bus.playlist.active() : ended >= count) break;
+    }
+
+    std::sort(audio.begin(), audio.end());
+    QueueResult r;
+    int playing = 0;
+    unsigned long lastEnd = 0, overlapFrom = 0;
+    for (const auto& a : audio) {
+        if (a.second) {
+            if (playing == 0 && lastEnd) r.gapsMs.push_back((a.first - lastEnd) / 1000);
+            if (++playing == 2) overlapFrom = a.first;
+            r.played++;
+        } else if (playing > 0) {
+            if (playing-- == 2) r.overlapMs += (a.first - overlapFrom) / 1000;
+            if (playing == 0) lastEnd = a.first;
+        }
+    }
+    return r;
+}
+
+static void printQueueResult(const char* label, const QueueResult& r) {
+    uint32_t total = 0, worst = 0;
+    for (uint32_t g : r.gapsMs) {
+        total += g;
+        if (g > worst) worst = g;
+    }
+    Log.print(label);
+    Log.print(r.gapsMs.size());
+    Log.print(F(" gaps, avg "));
+    Log.print(r.gapsMs.empty() ? 0 : total / (uint32_t)r.gapsMs.size());
+    Log.print(F(" ms, max "));
+    Log.print(worst);
+    Log.print(F(" ms ("));
+    for (size_t i = 0; i < r.gapsMs.size(); ++i) {
+        if (i) Log.print('/');
+        Log.print(r.gapsMs[i]);
+    }
+    Log.print(F("), both playing "));
+    Log.print(r.overlapMs);
+    Log.println(F(" ms"));
+}
+
+static int benchPlaylist() {
+    // Alternating players, then two in a row on player 2 (no pre-positioning)
+    const SlinkPlaylistEntry queue[] = {
+        {1, 12, 0, 3}, {2, 150, 0, 3}, {1, 200, 0, 3}, {2, 30, 0, 3}, {2, 90, 0, 3}, {1, 250, 0, 3},
+    };
+    const int count = sizeof(queue) / sizeof(queue[0]);
+    QueueResult backend = benchQueueRun(false, queue, count);
+    QueueResult engine = benchQueueRun(true, queue, count);
+
+    SlinkHal::Host::setLogFile(stdout);
+    printQueueResult("[BENCH] queue via backend: ", backend);
+    printQueueResult("[BENCH] queue on device:   ", engine);
+    SlinkHal::Host::setLogFile(nullptr);
+
+    // Every handover but the same-player one within a few hundred ms
+    int slow = 0;
+    for (uint32_t g : engine.gapsMs) {
+        if (g > 1000) slow++;
+    }
+    return (engine.gapsMs.size() != (size_t)count - 1 || slow > 1 || engine.overlapMs > 0) ? 1 : 0;
+}
+
+// Full inventory scan of two changers with some empty slots, the carousels
+// as in benchSeekProfile. On an empty slot player 1 reports stop; player 2
+// says nothing, so only the deadline tells. Measured against the mechanical
+// minimum (the carousel moves alone, both changers at once):
+//   one at a time  player 1's slots, then player 2's
+//   pipelined      both players at once
+//   interrupted    pipelined, rebooted halfway and resumed from flash
+struct ScanRun {
+    unsigned long ms = 0;
+    int           loads = 0;
+    int           wrong = 0;    // slots not as loaded, or loaded without track 1
+    int           batches = 0;  // uploads the results went out in
+    bool          done = false;
+};
+
+static ScanRun benchScanRun(const std::vector<bool>* slots, int* discs, std::vector<uint8_t> phases,
+                            bool resume, unsigned long stopAfterMs) {
+    const int txPin = 25;
+    SlinkHal::Host::clearPinEvents();
+    SlinkBus bus(0, {34, txPin, RMT_CHANNEL_0, RMT_CHANNEL_2});
+    bus.begin();
+    bus.tx.setBlocking(false);
+
+    std::vector<std::pair<unsigned long, bool>> audio;
+    SimPlayer players[2];
+    for (int p = 0; p < 2; ++p) {
+        players[p].out.player = p + 1;
+        players[p].out.disc = discs[p];
+        players[p].audio = &audio;
+        players[p].slots = &slots[p];
+        players[p].silentWhenEmpty = p == 1;
+        players[p].lastUs = SlinkHal::nowMicros();
+    }
+
+    ScanRun r;
+    if (resume && !bus.scan.resumable()) return r;
+    unsigned long startUs = SlinkHal::nowMicros();
+    size_t phase = 0;
+    bus.scan.start(phases[0], resume);
+    while (SlinkHal::nowMicros() - startUs < stopAfterMs * 1000UL) {
+        for (SimPlayer& p : players) {
+            for (const WireFrame& f : p.out.commands(txPin)) p.command(f);
+            p.tick();
+            p.out.inject();
+        }
+        SlinkHal::Host::advanceMicros(1000);
+        bus.loop();
+        if (!bus.scan.active()) {
+            if (++phase == phases.size()) {
+                r.done = true;
+                break;
+            }
+            bus.scan.start(phases[phase], false);
+        }
+    }
+    r.ms = (SlinkHal::nowMicros() - startUs) / 1000;
+
+    for (int p = 0; p < 2; ++p) {
+        discs[p] = players[p].out.disc;
+        r.loads += players[p].loads;
+        for (int disc = 1; disc < bus.scan.next(p + 1); ++disc) {
+            const SlinkInventoryScan::Result& res = bus.scan.result(p + 1, disc);
+            bool loaded = res.state == SlinkInventory::LOADED;
+            if (loaded != slots[p][disc - 1] || (loaded && res.firstTrack != 1)) r.wrong++;
+        }
+        int from, count;
+        while (r.done && bus.scan.uploadDue(p + 1, &from, &count)) {
+            bus.scan.markSent(p + 1, count);
+            r.batches++;
+        }
+    }
+    return r;
+}
+
+static int benchInventoryScan() {
+    const int slotsPerPlayer = SlinkInventoryScan::SLOTS;
+    std::vector<bool> slots[2];
+    int empty[2] = {};
+    for (int p = 0; p < 2; ++p) {
+        for (int disc = 1; disc <= slotsPerPlayer; ++disc) {
+            // A scattered tenth, and a gap on player 1
+            bool loaded = (disc * 7 + p * 3) % 10 != 0 && !(p == 0 && disc >= 200 && disc < 215);
+            slots[p].push_back(loaded);
+            empty[p] += !loaded;
+        }
+    }
+
+    // The carousels moving from slot to slot and nothing else
+    const int startDisc[2] = {120, 40};
+    uint32_t minimumMs[2] = {};
+    for (int p = 0; p < 2; ++p) {
+        int from = startDisc[p];
+        for (int disc = 1; disc <= slotsPerPlayer; ++disc) {
+            minimumMs[p] += seekMs(from, disc);
+            from = disc;
+        }
+    }
+    uint32_t minimum = minimumMs[0] > minimumMs[1] ? minimumMs[0] : minimumMs[1];
+
+    int discs[2];
+    SlinkHal::Host::clearStore();
+    discs[0] = startDisc[0]; discs[1] = startDisc[1];
+    ScanRun serial = benchScanRun(slots, discs, {1, 2}, false, 1800000);
+
+    SlinkHal::Host::clearStore();
+    discs[0] = startDisc[0]; discs[1] = startDisc[1];
+    ScanRun pipelined = benchScanRun(slots, discs, {3}, false, 1800000);
+
+    SlinkHal::Host::clearStore();
+    discs[0] = startDisc[0]; discs[1] = startDisc[1];
+    ScanRun first = benchScanRun(slots, discs, {3}, false, pipelined.ms / 2);
+    ScanRun resumed = benchScanRun(slots, discs, {3}, true, 1800000);
+    unsigned long interruptedMs = first.ms + resumed.ms;
+    int rescanned = first.loads + resumed.loads - pipelined.loads;
+
+    SlinkHal::Host::setLogFile(stdout);
+    Log.print(F("[BENCH] inventory scan: 2 x "));
+    Log.print(slotsPerPlayer);
+    Log.print(F(" slots ("));
+    Log.print(empty[0]);
+    Log.print('/');
+    Log.print(empty[1]);
+    Log.print(F(" empty), carousel minimum "));
+    Log.print(minimum / 1000);
+    Log.println(F(" s"));
+    const ScanRun* runs[] = {&serial, &pipelined};
+    const char* labels[] = {"[BENCH] inventory scan: one at a time ", "[BENCH] inventory scan: pipelined    "};
+    for (int i = 0; i < 2; ++i) {
+        Log.print(labels[i]);
+        Log.print(runs[i]->ms / 1000);
+        Log.print(F(" s ("));
+        Log.print(runs[i]->ms * 100 / minimum);
+        Log.print(F("% of minimum), "));
+        Log.print(runs[i]->wrong);
+        Log.println(F(" slots wrong"));
+    }
+    Log.print(F("[BENCH] inventory scan: interrupted at "));
+    Log.print(first.ms / 1000);
+    Log.print(F(" s and resumed, "));
+    Log.print(interruptedMs / 1000);
+    Log.print(F(" s in all, "));
+    Log.print(rescanned);
+    Log.print(F(" slots played again, "));
+    Log.print(resumed.wrong);
+    Log.print(F(" slots wrong, uploaded in "));
+    Log.print(resumed.batches);
+    Log.println(F(" batches"));
+    SlinkHal::Host::setLogFile(nullptr);
+
+    bool ok = serial.done && pipelined.done && resumed.done &&
+              !serial.wrong && !pipelined.wrong && !resumed.wrong &&
+              pipelined.ms < serial.ms * 6 / 10 && pipelined.ms < minimum * 13 / 10 &&
+              rescanned <= 2 * 10 && resumed.batches == 2 * (slotsPerPlayer / SlinkInventoryScan::UPLOAD_BATCH);
+    return ok ? 0 : 1;
+}
+
+// Command code discovery against player 2 (cmdscan92,00-0F) on a bus that
+// also carries heartbeats and extended status frames the whole time. The
+// changer answers play, stop and pause as a CX355 does and two codes with
+// frames no decoder rule knows. Halfway through, player 1 changes track on
+// its own: the decoder must pick that up while the job runs (the old
+// blocking loop sat in delay() for 2 s per code).
+struct DiscoveryAnswer {
+    uint8_t              cmd;
+    unsigned long        afterMs;
+    std::vector<uint8_t> bytes;
+    bool                 unknown;
+};
+
+static int benchDiscovery() {
+    const int txPin = 25;
+    SlinkHal::Host::clearPinEvents();
+    SlinkBus bus(0, {34, txPin, RMT_CHANNEL_0, RMT_CHANNEL_2});
+    bus.begin();
+    bus.tx.setBlocking(false);
+
+    uint8_t status[12];
+    int statusLen = buildTrackStatus(status, 2, 5, 1);
+    const std::vector<DiscoveryAnswer> answers = {
+        {SLINK_CMD_PLAY,  300, {0x41, 0x44, 0x00, 0x00}, false},
+        {SLINK_CMD_PLAY,  800, std::vector<uint8_t>(status, status + statusLen), false},
+        {SLINK_CMD_STOP,  200, {0x41, 0x44, 0x00, 0x01}, false},
+        {SLINK_CMD_PAUSE, 250, {0x41, 0x44, 0x00, 0x04}, false},
+        {0x0C,            150, {0x41, 0x44, 0x77, 0x01}, true},
+        {0x0E,           1200, {0x41, 0x44, 0x0E, 0x0E, 0x0E}, true},
+    };
+    const std::vector<uint8_t> heartbeat = {0x41, 0x04, 0x00, 0x55};
+    const std::vector<uint8_t> ext14 = {0x41, 0x51, 0x15, 0x00, 0x00, 0x00, 0x50, 0x00,
+                                        0x00, 0x00, 0x00, 0x01, 0x00, 0x00};
+
+    ScriptedChanger changer;
+    changer.player = 2;
+    ScriptedChanger other;
+    other.player = 1;
+    other.disc = 30;
+    other.track = 4;
+
+    bus.discovery.startCommands(0x92, 0x00, 0x0F);
+    unsigned long startUs = SlinkHal::nowMicros();
+    unsigned long ambientUs = startUs, extUs = startUs + 700000;
+    unsigned long trackChangeUs = 0, trackSeenUs = 0;
+    while (bus.discovery.active() && SlinkHal::nowMicros() - startUs < 60000000UL) {
+        unsigned long now = SlinkHal::nowMicros();
+        if ((long)(now - ambientUs) >= 0) {
+            changer.at(0, heartbeat);
+            ambientUs += 2000000;
+        }
+        if ((long)(now - extUs) >= 0) {
+            changer.at(0, ext14);
+            extUs += 3000000;
+        }
+        if (!trackChangeUs && now - startUs > 18000000UL) {
+            trackChangeUs = now;
+            other.status(0);
+        }
+        if (trackChangeUs && !trackSeenUs && bus.decoder.state(1).trackNumber == 4) trackSeenUs = now;
+
+        for (const WireFrame& f : changer.commands(txPin)) {
+            changer.echo(f);
+            for (const DiscoveryAnswer& a : answers) {
+                if (f.bytes.size() == 2 && f.bytes[1] == a.cmd) changer.at(a.afterMs, a.bytes);
+            }
+        }
+        changer.inject();
+        other.inject();
+
+        bus.loop();
+        SlinkHal::Host::advanceMicros(1000);
+    }
+    unsigned long runMs = (SlinkHal::nowMicros() - startUs) / 1000;
+
+    // Every answer under its own code, with about its delay (the decoder
+    // dates a frame from its start on the wire), and nothing else but
+    // player 1's own status frames
+    int found = 0, misplaced = 0, flagged = 0, unsolicited = 0;
+    for (int i = 0; i < bus.discovery.responses(); ++i) {
+        const SlinkDiscovery::Response& r = bus.discovery.response(i);
+        std::vector<uint8_t> bytes(r.bytes, r.bytes + r.len);
+        if (bytes[1] == SlinkDevices::PLAYERS[0].rxLo) {
+            unsolicited++;
+            continue;
+        }
+        bool ok = false;
+        for (const DiscoveryAnswer& a : answers) {
+            long offMs = (long)r.afterMs - (long)a.afterMs;
+            if (a.bytes == bytes && bus.discovery.command(r.probe) == a.cmd &&
+                offMs > -100 && offMs < 100 && r.unknown == a.unknown) {
+                ok = true;
+            }
+        }
+        found += ok;
+        misplaced += !ok;
+        flagged += r.unknown;
+    }
+
+    SlinkHal::Host::setLogFile(stdout);
+    Log.print(F("[BENCH] discovery: 16 codes in "));
+    Log.print(runMs / 1000);
+    Log.print(F(" s, "));
+    Log.print(found);
+    Log.print('/');
+    Log.print(answers.size());
+    Log.print(F(" answers attributed ("));
+    Log.print(flagged);
+    Log.print(F(" unknown), "));
+    Log.print(misplaced);
+    Log.print(F(" misattributed, "));
+    Log.print(unsolicited);
+    Log.print(F(" from player 1 on its own; its status change decoded after "));
+    Log.print((trackSeenUs - trackChangeUs) / 1000);
+    Log.println(F(" ms (blocking loop: up to 2000 ms)"));
+    SlinkHal::Host::setLogFile(nullptr);
+
+    return (found == (int)answers.size() && misplaced == 0 && trackSeenUs &&
+            trackSeenUs - trackChangeUs < 500000) ? 0 : 1;
+}
+
+static int runBench(int frames) {
+    int result = benchCodec();
+
+    SlinkHal::Host::setLogFile(nullptr);
+    result |= benchBurst();
+
+    SlinkHal::Host::setLogFile(nullptr);
+    result |= benchDrift(2000);
+
+    SlinkHal::Host::setLogFile(nullptr);
+    result |= benchCapture(2000);
+
+    SlinkHal::Host::setLogFile(nullptr);
+    result |= benchConfirm(5000);
+
+    SlinkHal::Host::setLogFile(nullptr);
+    result |= benchPresence();
+
+    SlinkHal::Host::setLogFile(nullptr);
+    result |= benchTxQueue();
+
+    SlinkHal::Host::setLogFile(nullptr);
+    result |= benchCarrierSense();
+
+    SlinkHal::Host::setLogFile(nullptr);
+    result |= benchEcho();
+
+    SlinkHal::Host::setLogFile(nullptr);
+    result |= benchVerifyFull();
+
+    SlinkHal::Host::setLogFile(nullptr);
+    result |= benchEchoStall();
+
+    SlinkHal::Host::setLogFile(nullptr);
+    result |= benchSchedule();
+
+    SlinkHal::Host::setLogFile(nullptr);
+    result |= benchConfirmCommands();
+    result |= benchSeekProfile();
+    result |= benchPlaylist();
+    result |= benchInventoryScan();
+    result |= benchDiscovery();
+
+    SlinkHal::Host::setLogFile(nullptr);
+
+    // Pre-build one capture per (player, disc) so the timed loop is decode only
+    std::vector<std::vector<uint16_t>> captures;
+    for (int player = 1; player <= 2; ++player) {
+        for (int disc = 1; disc <= 300; ++disc) {
+            uint8_t bytes[12];
+            int len = buildTrackStatus(bytes, player, disc, 1 + disc % 99);
+            std::vector<uint16_t> cap;
+            appendFrame(cap, bytes, len);
+            captures.push_back(cap);
+        }
+    }
+
+    SlinkDecoder decoder(34);
+    decoder.setConfirmation(1, 1);     // every frame is a new disc/track
+    decoder.begin();
+    decoder.events().status.subscribe(countStatus);
+
+    decodedFrames = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i) {
+        const std::vector<uint16_t>& cap = captures[i % captures.size()];
+        SlinkHal::Host::injectDurations(cap.data(), cap.size());
+        decoder.loop();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+    // TX: the virtual clock advances by exactly the time the call blocks.
+    // Blocking (the old behaviour) waits out the whole frame; async only
+    // encodes and queues, and the frame completes while the loop runs on.
+    SlinkTx tx(25);
+    tx.begin();
+    unsigned long t0 = SlinkHal::nowMicros();
+    tx.playDisc(2, 250, 3);
+    unsigned long stallUs = SlinkHal::nowMicros() - t0;
+
+    tx.setBlocking(false);
+    const int asyncCommands = 1000;
+    unsigned long asyncStallUs = 0;
+    auto asyncStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < asyncCommands; ++i) {
+        t0 = SlinkHal::nowMicros();
+        tx.playDisc(2, 250, 3);
+        asyncStallUs += SlinkHal::nowMicros() - t0;
+        tx.flush();                      // the frame goes out "between" loop passes
+    }
+    double asyncNs = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - asyncStart).count();
+
+    SlinkHal::Host::setLogFile(stdout);
+    Log.print(F("[BENCH] decode: "));
+    Log.print(decodedFrames);
+    Log.print(F("/"));
+    Log.print(frames);
+    Log.print(F(" frames, "));
+    Log.print(ns / frames, 1);
+    Log.println(F(" ns/frame"));
+    Log.print(F("[BENCH] tx playDisc main-loop stall: blocking "));
+    Log.print(stallUs);
+    Log.print(F(" us, async "));
+    Log.print(asyncStallUs / asyncCommands);
+    Log.print(F(" us ("));
+    Log.print(asyncNs / asyncCommands / 1000.0, 1);
+    Log.println(F(" us host CPU per command incl. flush)"));
+
+    SlinkHal::Host::setLogFile(nullptr);
+    result |= benchBuses(frames < 20000 ? frames : 20000);
+
+    return (decodedFrames == frames && result == 0) ? 0 : 1;
+}
+
+static int fakeServer(const char* method, const char* url, const char* body,
+                      char* response, size_t maxLen) {
+    static int polls = 0;
+    printf("  %s %s %s\n", method, url, body ? body : "");
+    if (strcmp(method, "GET") == 0 && maxLen > 0) {
+        const char* json = (++polls == 2)
+            ? "{\"id\":\"cmd-1\",\"action\":\"play\",\"player\":1,\"disc\":42,\"track\":1}"
+            : "{}";
+        strncpy(response, json, maxLen - 1);
+        response[maxLen - 1] = '\0';
+    }
+    return 200;
+}
+
+static int runBackend() {
+    SlinkHal::Host::setHttpHandler(fakeServer);
+
+    BackendClient backend;
+    backend.begin();
+
+    for (int step = 0; step < 5; ++step) {
+        SlinkHal::Host::advanceMicros(1100UL * 1000UL);
+        backend.loop();
+        if (backend.hasCommand()) {
+            BackendCommand cmd = backend.getCommand();
+            PlayerState ps = {cmd.player, cmd.disc, cmd.track, "play"};
+            backend.sendState(ps);
+            backend.acknowledgeCommand(cmd.id);
+        }
+    }
+
+    // 90 s of one time frame per second, with a seek forward at 40 s:
+    // expect a POST at track start, one for the seek and 30 s keep-alives
+    printf("  -- position updates\n");
+    PlayerPosition pos = {0, 1, 42, 1, 0};
+    for (int t = 0; t < 90; ++t) {
+        pos.position = (t < 40) ? t : t + 60;
+        backend.sendPosition(pos);
+        SlinkHal::Host::advanceMicros(1000UL * 1000UL);
+    }
+
+    // Extended status frames repeating the loaded disc (201, then 250) mark
+    // two slots; the player's bitsets go out as one POST, only if changed
+    printf("  -- inventory\n");
+    SlinkBus bus(0, {34, 25, RMT_CHANNEL_0, RMT_CHANNEL_2});
+    bus.begin();
+    uint8_t ext[14] = {0x41, 0x51, 0x15, 0x00, 0x00, 0x00, 0x50, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00};
+    SlinkInventory& inv = bus.inventory;
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 10; ++i) {
+            ext[11] = (i < 5) ? 0x01 : 0x32;
+            injectFrame(ext, sizeof(ext));
+            bus.loop();
+        }
+        if (inv.dirty(2) && backend.sendInventory(0, 2, inv.loadedBits(2), inv.knownBits(2),
+                                                  SlinkInventory::BITSET_BYTES)) {
+            inv.clearDirty(2);
+        }
+    }
+    return inv.slot(2, 201) == SlinkInventory::LOADED &&
+           inv.slot(2, 250) == SlinkInventory::LOADED &&
+           inv.count(2, SlinkInventory::UNKNOWN) == 298 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && strcmp(argv[1], "replay") == 0) {
+        return runReplay(argv[2]);
+    }
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+        return runBench(argc >= 3 ? atoi(argv[2]) : 100000);
+    }
+    if (argc >= 2 && strcmp(argv[1], "backend") == 0) {
+        return runBackend();
+    }
+
+    fprintf(stderr, "usage: %s replay <file> | bench [frames] | backend\n", argv[0]);
+    return 2;
+}
+
+#endif  // !ARDUINO
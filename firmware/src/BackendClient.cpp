@@ -1,11 +1,29 @@
 #include "BackendClient.h"
 #include "secrets.h"
 
-#include <WiFi.h>
-#include <HTTPClient.h>
-#include <ESPmDNS.h>
 #include <ArduinoJson.h>
 
+static Print& Log = SlinkHal::log();
+
+static const int HTTP_OK = 200;
+static const unsigned long HTTP_TIMEOUT_MS = 3000;  // 3 second timeout (reduced from 10)
+
+static void _printIp(uint32_t ip) {
+    Log.print((unsigned)((ip >> 24) & 0xFF));
+    Log.print('.');
+    Log.print((unsigned)((ip >> 16) & 0xFF));
+    Log.print('.');
+    Log.print((unsigned)((ip >> 8) & 0xFF));
+    Log.print('.');
+    Log.print((unsigned)(ip & 0xFF));
+}
+
+// Same /24 as us, and not the network or broadcast address
+static bool _isPlausiblePeer(uint32_t ip, uint32_t myIP) {
+    uint8_t last = ip & 0xFF;
+    return (ip >> 8) == (myIP >> 8) && last != 0 && last != 255;
+}
+
 BackendClient::BackendClient()
     : _wifiConnected(false)
     , _lastWifiCheck(0)
@@ -13,76 +31,69 @@ BackendClient::BackendClient()
     , _backendPort(BACKEND_PORT)
     , _lastPoll(0)
     , _hasPendingCommand(false)
-    , _lastPlayer(-1)
-    , _lastDisc(-1)
-    , _lastTrack(-1)
-    , _lastState(nullptr)
     , _consecutiveFailures(0)
     , _lastFailureTime(0)
 {
     _backendHost[0] = '\0';
     memset(&_pendingCommand, 0, sizeof(_pendingCommand));
+    for (int b = 0; b < SLINK_MAX_BUSES; ++b) {
+        for (int p = 0; p < SLINK_MAX_PLAYERS; ++p) {
+            _lastSent[b][p] = SentState{-1, -1, nullptr};
+            _lastPosition[b][p] = SentPosition{-1, -1, 0, 0};
+        }
+    }
 }
 
 bool BackendClient::begin() {
-    Serial.println(F("[WiFi] Connecting..."));
-    Serial.print(F("[WiFi] SSID: "));
-    Serial.println(WIFI_SSID);
-
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    Log.println(F("[WiFi] Connecting..."));
+    Log.print(F("[WiFi] SSID: "));
+    Log.println(WIFI_SSID);
 
     // Wait for connection (with timeout)
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 30) {
-        delay(500);
-        Serial.print(".");
-        attempts++;
-    }
-    Serial.println();
-
-    if (WiFi.status() == WL_CONNECTED) {
+    if (SlinkHal::netBegin(WIFI_SSID, WIFI_PASSWORD, 15000)) {
         _wifiConnected = true;
-        Serial.print(F("[WiFi] Connected! IP: "));
-        Serial.println(WiFi.localIP());
+        Log.print(F("[WiFi] Connected! IP: "));
+        _printIp(SlinkHal::netLocalIp());
+        Log.println();
 
         // Initialize mDNS for discovery
-        if (!MDNS.begin("esp32-slink")) {
-            Serial.println(F("[mDNS] Failed to start mDNS"));
+        if (!SlinkHal::mdnsBegin("esp32-slink")) {
+            Log.println(F("[mDNS] Failed to start mDNS"));
         } else {
-            Serial.println(F("[mDNS] Started as esp32-slink.local"));
+            Log.println(F("[mDNS] Started as esp32-slink.local"));
         }
 
         // Try to find backend
         if (!_discoverBackend()) {
-            Serial.println(F("[Backend] Not found via mDNS, will retry later"));
+            Log.println(F("[Backend] Not found via mDNS, will retry later"));
         }
 
         return true;
     } else {
-        Serial.println(F("[WiFi] Connection failed!"));
+        Log.println(F("[WiFi] Connection failed!"));
         return false;
     }
 }
 
 void BackendClient::loop() {
-    unsigned long now = millis();
+    unsigned long now = SlinkHal::nowMillis();
 
     // Check WiFi connection periodically
     if (now - _lastWifiCheck > WIFI_CHECK_INTERVAL) {
         _lastWifiCheck = now;
 
-        if (WiFi.status() != WL_CONNECTED) {
+        if (!SlinkHal::netConnected()) {
             if (_wifiConnected) {
-                Serial.println(F("[WiFi] Disconnected, reconnecting..."));
+                Log.println(F("[WiFi] Disconnected, reconnecting..."));
                 _wifiConnected = false;
                 _backendFound = false;
             }
-            WiFi.reconnect();
+            SlinkHal::netReconnect();
         } else if (!_wifiConnected) {
             _wifiConnected = true;
-            Serial.print(F("[WiFi] Reconnected! IP: "));
-            Serial.println(WiFi.localIP());
+            Log.print(F("[WiFi] Reconnected! IP: "));
+            _printIp(SlinkHal::netLocalIp());
+            Log.println();
         }
 
         // Try to find backend if not found
@@ -118,24 +129,29 @@ void BackendClient::loop() {
                     _pendingCommand.player = doc["player"] | 0;
                     _pendingCommand.disc = doc["disc"] | 0;
                     _pendingCommand.track = doc["track"] | 0;
+                    _pendingCommand.bus = doc["bus"] | 0;
                     strncpy(_pendingCommand.id, doc["id"] | "", sizeof(_pendingCommand.id) - 1);
                     _pendingCommand.valid = true;
 
-                    Serial.print(F("[Backend] Command received: "));
-                    Serial.print(_pendingCommand.action);
+                    Log.print(F("[Backend] Command received: "));
+                    Log.print(_pendingCommand.action);
+                    if (_pendingCommand.bus > 0) {
+                        Log.print(F(" bus="));
+                        Log.print(_pendingCommand.bus);
+                    }
                     if (_pendingCommand.player > 0) {
-                        Serial.print(F(" player="));
-                        Serial.print(_pendingCommand.player);
+                        Log.print(F(" player="));
+                        Log.print(_pendingCommand.player);
                     }
                     if (_pendingCommand.disc > 0) {
-                        Serial.print(F(" disc="));
-                        Serial.print(_pendingCommand.disc);
+                        Log.print(F(" disc="));
+                        Log.print(_pendingCommand.disc);
                     }
                     if (_pendingCommand.track > 0) {
-                        Serial.print(F(" track="));
-                        Serial.print(_pendingCommand.track);
+                        Log.print(F(" track="));
+                        Log.print(_pendingCommand.track);
                     }
-                    Serial.println();
+                    Log.println();
                 }
             } else {
                 // Failure - increment counter
@@ -152,79 +168,81 @@ bool BackendClient::_discoverBackend() {
         strncpy(_backendHost, BACKEND_HOST, sizeof(_backendHost) - 1);
         _backendPort = BACKEND_PORT;
         _backendFound = true;
-        Serial.print(F("[Backend] Using hardcoded address: "));
-        Serial.print(_backendHost);
-        Serial.print(F(":"));
-        Serial.println(_backendPort);
+        Log.print(F("[Backend] Using hardcoded address: "));
+        Log.print(_backendHost);
+        Log.print(F(":"));
+        Log.println(_backendPort);
         return true;
     }
 
     // Get our own IP to validate discovered IPs are on same subnet
-    IPAddress myIP = WiFi.localIP();
-    Serial.print(F("[mDNS] Our IP: "));
-    Serial.println(myIP);
+    uint32_t myIP = SlinkHal::netLocalIp();
+    Log.print(F("[mDNS] Our IP: "));
+    _printIp(myIP);
+    Log.println();
 
     // Try mDNS discovery
-    Serial.println(F("[mDNS] Searching for _cdjukebox._tcp service..."));
+    Log.println(F("[mDNS] Searching for _cdjukebox._tcp service..."));
 
-    int n = MDNS.queryService("cdjukebox", "tcp");
+    uint32_t ip = 0;
+    int port = 0;
+    int n = SlinkHal::mdnsQueryService("cdjukebox", "tcp", &ip, &port);
 
     if (n > 0) {
         // Use IP address directly (hostname resolution is unreliable)
-        IPAddress ip = MDNS.IP(0);
-
-        Serial.print(F("[mDNS] Raw result: "));
-        Serial.print(ip);
-        Serial.print(F(":"));
-        Serial.println(MDNS.port(0));
+        Log.print(F("[mDNS] Raw result: "));
+        _printIp(ip);
+        Log.print(F(":"));
+        Log.println(port);
 
         // Validate the IP looks reasonable (same first 3 octets as us, not .0 or .255)
-        if (ip[0] == myIP[0] && ip[1] == myIP[1] && ip[2] == myIP[2] &&
-            ip[3] != 0 && ip[3] != 255) {
-            snprintf(_backendHost, sizeof(_backendHost), "%d.%d.%d.%d",
-                     ip[0], ip[1], ip[2], ip[3]);
-            _backendPort = MDNS.port(0);
+        if (_isPlausiblePeer(ip, myIP)) {
+            snprintf(_backendHost, sizeof(_backendHost), "%u.%u.%u.%u",
+                     (unsigned)(ip >> 24) & 0xFF, (unsigned)(ip >> 16) & 0xFF,
+                     (unsigned)(ip >> 8) & 0xFF, (unsigned)ip & 0xFF);
+            _backendPort = port;
             _backendFound = true;
 
-            Serial.print(F("[mDNS] Found backend: "));
-            Serial.print(_backendHost);
-            Serial.print(F(":"));
-            Serial.println(_backendPort);
+            Log.print(F("[mDNS] Found backend: "));
+            Log.print(_backendHost);
+            Log.print(F(":"));
+            Log.println(_backendPort);
 
             return true;
         } else {
-            Serial.println(F("[mDNS] Invalid IP returned (wrong subnet or broadcast), ignoring"));
+            Log.println(F("[mDNS] Invalid IP returned (wrong subnet or broadcast), ignoring"));
         }
     }
 
     // Try fallback hostname
-    Serial.println(F("[mDNS] Service not found, trying cdjukebox.local..."));
+    Log.println(F("[mDNS] Service not found, trying cdjukebox.local..."));
 
-    IPAddress ip = MDNS.queryHost("cdjukebox", 2000);
-    if (ip != INADDR_NONE && ip[0] != 0) {
-        Serial.print(F("[mDNS] Host query result: "));
-        Serial.println(ip);
+    ip = SlinkHal::mdnsQueryHost("cdjukebox", 2000);
+    if (ip != 0 && (ip >> 24) != 0) {
+        Log.print(F("[mDNS] Host query result: "));
+        _printIp(ip);
+        Log.println();
 
         // Validate the IP
-        if (ip[0] == myIP[0] && ip[1] == myIP[1] && ip[2] == myIP[2] &&
-            ip[3] != 0 && ip[3] != 255) {
-            snprintf(_backendHost, sizeof(_backendHost), "%d.%d.%d.%d",
-                     ip[0], ip[1], ip[2], ip[3]);
+        if (_isPlausiblePeer(ip, myIP)) {
+            snprintf(_backendHost, sizeof(_backendHost), "%u.%u.%u.%u",
+                     (unsigned)(ip >> 24) & 0xFF, (unsigned)(ip >> 16) & 0xFF,
+                     (unsigned)(ip >> 8) & 0xFF, (unsigned)ip & 0xFF);
             _backendPort = BACKEND_PORT;
             _backendFound = true;
 
-            Serial.print(F("[mDNS] Found via hostname: "));
-            Serial.print(_backendHost);
-            Serial.print(F(":"));
-            Serial.println(_backendPort);
+            Log.print(F("[mDNS] Found via hostname: "));
+            Log.print(_backendHost);
+            Log.print(F(":"));
+            Log.println(_backendPort);
 
             return true;
         } else {
-            Serial.println(F("[mDNS] Invalid IP returned, ignoring"));
+            Log.println(F("[mDNS] Invalid IP returned, ignoring"));
         }
     }
 
-    Serial.println(F("[mDNS] Backend not found"));
+    Log.println(F("[mDNS] Backend not found"));
     return false;
 }
 
@@ -235,41 +253,228 @@ bool BackendClient::sendState(const PlayerState& state) {
 
     // If we're in backoff mode due to failures, skip sending
     if (_consecutiveFailures >= MAX_BACKOFF_FAILURES) {
-        unsigned long now = millis();
+        unsigned long now = SlinkHal::nowMillis();
         if (now - _lastFailureTime < BACKOFF_DELAY) {
             return false;  // Still in backoff period
         }
     }
 
+    if (!SlinkDevices::isValidBus(state.bus) || !SlinkDevices::isValidPlayer(state.player)) {
+        return false;
+    }
+
     // Avoid sending duplicate states
-    if (state.player == _lastPlayer && state.disc == _lastDisc &&
-        state.track == _lastTrack && state.state == _lastState) {
+    SentState& last = _lastSent[state.bus][state.player - 1];
+    if (state.disc == last.disc && state.track == last.track && state.state == last.state) {
         return true;  // Already sent this state
     }
 
     // Build JSON
     char json[128];
     snprintf(json, sizeof(json),
-             "{\"player\":%d,\"disc\":%d,\"track\":%d,\"state\":\"%s\"}",
-             state.player, state.disc, state.track, state.state);
+             "{\"bus\":%d,\"player\":%d,\"disc\":%d,\"track\":%d,\"state\":\"%s\"}",
+             state.bus, state.player, state.disc, state.track, state.state);
 
-    Serial.print(F("[Backend] Sending state: "));
-    Serial.println(json);
+    Log.print(F("[Backend] Sending state: "));
+    Log.println(json);
 
     if (_httpPost("/api/state", json)) {
-        _lastPlayer = state.player;
-        _lastDisc = state.disc;
-        _lastTrack = state.track;
-        _lastState = state.state;
+        last.disc = state.disc;
+        last.track = state.track;
+        last.state = state.state;
         _consecutiveFailures = 0;  // Reset on success
         return true;
     }
 
     _consecutiveFailures++;
-    _lastFailureTime = millis();
+    _lastFailureTime = SlinkHal::nowMillis();
     return false;
 }
 
+bool BackendClient::sendPosition(const PlayerPosition& pos) {
+    if (!_backendFound) {
+        return false;
+    }
+
+    unsigned long now = SlinkHal::nowMillis();
+    if (_consecutiveFailures >= MAX_BACKOFF_FAILURES && now - _lastFailureTime < BACKOFF_DELAY) {
+        return false;
+    }
+
+    if (!SlinkDevices::isValidBus(pos.bus) || !SlinkDevices::isValidPlayer(pos.player)) {
+        return false;
+    }
+
+    SentPosition& last = _lastPosition[pos.bus][pos.player - 1];
+    unsigned long since = now - last.sentAt;
+
+    // Where the backend thinks the player is now
+    int expected = last.position + (int)(since / 1000);
+    int delta = pos.position - expected;
+
+    bool newTrack = pos.disc != last.disc || pos.track != last.track;
+    if (!newTrack) {
+        bool drifted = delta > POSITION_DRIFT_S || delta < -POSITION_DRIFT_S;
+        if (drifted ? since < POSITION_MIN_INTERVAL_MS : since < POSITION_REFRESH_MS) {
+            return true;
+        }
+    } else {
+        delta = 0;
+    }
+
+    char json[112];
+    snprintf(json, sizeof(json),
+             "{\"bus\":%d,\"player\":%d,\"disc\":%d,\"track\":%d,\"position\":%d,\"delta\":%d}",
+             pos.bus, pos.player, pos.disc, pos.track, pos.position, delta);
+
+    if (_httpPost("/api/position", json)) {
+        last = SentPosition{pos.disc, pos.track, pos.position, now};
+        _consecutiveFailures = 0;
+        return true;
+    }
+
+    _consecutiveFailures++;
+    _lastFailureTime = now;
+    return false;
+}
+
+bool BackendClient::sendPresence(int bus, int player, const char* state) {
+    if (!_backendFound) {
+        return false;
+    }
+
+    char json[80];
+    snprintf(json, sizeof(json), "{\"bus\":%d,\"player\":%d,\"state\":\"%s\"}",
+             bus, player, state);
+
+    Log.print(F("[Backend] Sending presence: "));
+    Log.println(json);
+
+    return _httpPost("/api/presence", json);
+}
+
+static char* _appendHex(char* out, const uint8_t* bytes, int len) {
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < len; ++i) {
+        *out++ = digits[bytes[i] >> 4];
+        *out++ = digits[bytes[i] & 0x0F];
+    }
+    return out;
+}
+
+bool BackendClient::sendInventory(int bus, int player, const uint8_t* loaded,
+                                  const uint8_t* known, int bytes) {
+    if (!_backendFound || bytes > 40) {
+        return false;
+    }
+
+    char json[224];
+    char* p = json + snprintf(json, sizeof(json), "{\"bus\":%d,\"player\":%d,\"loaded\":\"", bus, player);
+    p = _appendHex(p, loaded, bytes);
+    p += sprintf(p, "\",\"known\":\"");
+    p = _appendHex(p, known, bytes);
+    strcpy(p, "\"}");
+
+    Log.print(F("[Backend] Sending inventory for bus "));
+    Log.print(bus);
+    Log.print(F(" player "));
+    Log.println(player);
+
+    return _httpPost("/api/inventory", json);
+}
+
+bool BackendClient::sendSeekModel(const SeekModel& m) {
+    if (!_backendFound || m.buckets > 16) {
+        return false;
+    }
+
+    char json[320];
+    char* end = json + sizeof(json);
+    char* p = json + snprintf(json, sizeof(json), "{\"bus\":%d,\"player\":%d,\"bucketSlots\":%d,\"meanMs\":[",
+                              m.bus, m.player, m.bucketSlots);
+    for (int i = 0; i < m.buckets; ++i) {
+        p += snprintf(p, end - p, i ? ",%u" : "%u", m.meanMs[i]);
+    }
+    p += snprintf(p, end - p, "],\"samples\":[");
+    for (int i = 0; i < m.buckets; ++i) {
+        p += snprintf(p, end - p, i ? ",%u" : "%u", m.samples[i]);
+    }
+    if (m.hasFit) {
+        snprintf(p, end - p, "],\"baseMs\":%.0f,\"msPerSlot\":%.2f}", m.baseMs, m.msPerSlot);
+    } else {
+        snprintf(p, end - p, "]}");
+    }
+
+    Log.print(F("[Backend] Sending load time model for bus "));
+    Log.print(m.bus);
+    Log.print(F(" player "));
+    Log.println(m.player);
+
+    return _httpPost("/api/seek-model", json);
+}
+
+bool BackendClient::sendScanResults(int bus, int player, const ScanSlot* slots, int count) {
+    if (!_backendFound || count <= 0 || count > MAX_SCAN_SLOTS) {
+        return false;
+    }
+
+    // About 55 bytes per slot
+    static char json[64 + 56 * MAX_SCAN_SLOTS];
+    char* end = json + sizeof(json);
+    char* p = json + snprintf(json, sizeof(json), "{\"bus\":%d,\"player\":%d,\"slots\":[", bus, player);
+    for (int i = 0; i < count; ++i) {
+        const ScanSlot& s = slots[i];
+        p += snprintf(p, end - p, "%s{\"disc\":%d,\"loaded\":%s,\"track\":%d,\"loadMs\":%d}",
+                      i ? "," : "", s.disc, s.loaded ? "true" : "false", s.firstTrack, s.loadMs);
+    }
+    snprintf(p, end - p, "]}");
+
+    Log.print(F("[Backend] Sending scan results for bus "));
+    Log.print(bus);
+    Log.print(F(" player "));
+    Log.print(player);
+    Log.print(F(": slots "));
+    Log.print(slots[0].disc);
+    Log.print('-');
+    Log.println(slots[count - 1].disc);
+
+    return _httpPost("/api/inventory/scan", json);
+}
+
+int BackendClient::fetchPlaylist(int bus, PlaylistItem* items, int maxItems) {
+    // About 50 bytes per entry
+    static char response[64 + 50 * MAX_PLAYLIST];
+    char path[48];
+    snprintf(path, sizeof(path), "/api/esp32/playlist?bus=%d", bus);
+    if (!_httpGet(path, response, sizeof(response))) {
+        return -1;
+    }
+
+    JsonDocument doc;
+    if (deserializeJson(doc, response)) {
+        Log.println(F("[Backend] Bad playlist response"));
+        return -1;
+    }
+
+    int n = 0;
+    JsonArray entries = doc["entries"].as<JsonArray>();
+    for (size_t i = 0; i < entries.size() && n < maxItems; ++i) {
+        JsonVariant e = entries[i];
+        items[n].player = e["player"] | 0;
+        items[n].disc = e["disc"] | 0;
+        items[n].track = e["track"] | 0;
+        items[n].tracks = e["tracks"] | 0;
+        n++;
+    }
+
+    Log.print(F("[Backend] Playlist for bus "));
+    Log.print(bus);
+    Log.print(F(": "));
+    Log.print(n);
+    Log.println(F(" discs"));
+    return n;
+}
+
 bool BackendClient::hasCommand() {
     return _hasPendingCommand;
 }
@@ -281,19 +486,23 @@ BackendCommand BackendClient::getCommand() {
     return cmd;
 }
 
-bool BackendClient::acknowledgeCommand(const char* commandId) {
+bool BackendClient::acknowledgeCommand(const char* commandId, bool success,
+                                       uint32_t latencyMs, const char* result) {
     if (!_backendFound || !commandId || commandId[0] == '\0') {
         return false;
     }
 
-    char json[64];
-    snprintf(json, sizeof(json), "{\"id\":\"%s\",\"success\":true}", commandId);
+    char json[160];
+    snprintf(json, sizeof(json),
+             "{\"id\":\"%s\",\"success\":%s,\"latencyMs\":%lu,\"result\":\"%s\"}",
+             commandId, success ? "true" : "false", (unsigned long)latencyMs,
+             result ? result : (success ? "confirmed" : "failed"));
 
     return _httpPost("/api/esp32/ack", json);
 }
 
 bool BackendClient::isWifiConnected() {
-    return _wifiConnected && WiFi.status() == WL_CONNECTED;
+    return _wifiConnected && SlinkHal::netConnected();
 }
 
 bool BackendClient::isBackendConnected() {
@@ -313,45 +522,16 @@ bool BackendClient::_httpPost(const char* path, const char* json) {
         return false;
     }
 
-    HTTPClient http;
-
     char url[128];
     snprintf(url, sizeof(url), "http://%s:%d%s", _backendHost, _backendPort, path);
 
-    http.begin(url);
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("Connection", "close");  // Ensure connection is closed properly
-    http.setTimeout(3000);  // 3 second timeout (reduced from 10)
-    http.setReuse(false);   // Don't reuse connection (helps with socket cleanup)
-
-    int httpCode = http.POST(json);
-    http.end();
+    int httpCode = SlinkHal::httpPost(url, json, HTTP_TIMEOUT_MS);
 
-    if (httpCode == HTTP_CODE_OK) {
+    if (httpCode == HTTP_OK) {
         return true;
     } else {
-        Serial.print(F("[HTTP] POST failed: "));
-        Serial.print(httpCode);
-        // Print human-readable error for negative codes
-        if (httpCode < 0) {
-            Serial.print(F(" ("));
-            switch (httpCode) {
-                case -1: Serial.print(F("CONNECTION_REFUSED")); break;
-                case -2: Serial.print(F("SEND_HEADER_FAILED")); break;
-                case -3: Serial.print(F("SEND_PAYLOAD_FAILED")); break;
-                case -4: Serial.print(F("NOT_CONNECTED")); break;
-                case -5: Serial.print(F("CONNECTION_LOST")); break;
-                case -6: Serial.print(F("NO_STREAM")); break;
-                case -7: Serial.print(F("NO_HTTP_SERVER")); break;
-                case -8: Serial.print(F("TOO_LESS_RAM")); break;
-                case -9: Serial.print(F("ENCODING")); break;
-                case -10: Serial.print(F("STREAM_WRITE")); break;
-                case -11: Serial.print(F("READ_TIMEOUT")); break;
-                default: Serial.print(F("UNKNOWN")); break;
-            }
-            Serial.print(F(")"));
-        }
-        Serial.println();
+        Log.print(F("[HTTP] POST failed: "));
+        _printHttpError(httpCode);
         return false;
     }
 }
@@ -361,47 +541,40 @@ bool BackendClient::_httpGet(const char* path, char* response, size_t maxLen) {
         return false;
     }
 
-    HTTPClient http;
-
     char url[128];
     snprintf(url, sizeof(url), "http://%s:%d%s", _backendHost, _backendPort, path);
 
-    http.begin(url);
-    http.addHeader("Connection", "close");  // Ensure connection is closed properly
-    http.setTimeout(3000);  // 3 second timeout (reduced from 10)
-    http.setReuse(false);   // Don't reuse connection (helps with socket cleanup)
-
-    int httpCode = http.GET();
+    int httpCode = SlinkHal::httpGet(url, response, maxLen, HTTP_TIMEOUT_MS);
 
-    if (httpCode == HTTP_CODE_OK) {
-        String payload = http.getString();
-        strncpy(response, payload.c_str(), maxLen - 1);
-        response[maxLen - 1] = '\0';
-        http.end();
+    if (httpCode == HTTP_OK) {
         return true;
     } else {
-        Serial.print(F("[HTTP] GET failed: "));
-        Serial.print(httpCode);
-        if (httpCode < 0) {
-            Serial.print(F(" ("));
-            switch (httpCode) {
-                case -1: Serial.print(F("CONNECTION_REFUSED")); break;
-                case -2: Serial.print(F("SEND_HEADER_FAILED")); break;
-                case -3: Serial.print(F("SEND_PAYLOAD_FAILED")); break;
-                case -4: Serial.print(F("NOT_CONNECTED")); break;
-                case -5: Serial.print(F("CONNECTION_LOST")); break;
-                case -6: Serial.print(F("NO_STREAM")); break;
-                case -7: Serial.print(F("NO_HTTP_SERVER")); break;
-                case -8: Serial.print(F("TOO_LESS_RAM")); break;
-                case -9: Serial.print(F("ENCODING")); break;
-                case -10: Serial.print(F("STREAM_WRITE")); break;
-                case -11: Serial.print(F("READ_TIMEOUT")); break;
-                default: Serial.print(F("UNKNOWN")); break;
-            }
-            Serial.print(F(")"));
-        }
-        Serial.println();
-        http.end();
+        Log.print(F("[HTTP] GET failed: "));
+        _printHttpError(httpCode);
         return false;
     }
 }
+
+void BackendClient::_printHttpError(int httpCode) {
+    Log.print(httpCode);
+    // Print human-readable error for negative codes
+    if (httpCode < 0) {
+        Log.print(F(" ("));
+        switch (httpCode) {
+            case -1: Log.print(F("CONNECTION_REFUSED")); break;
+            case -2: Log.print(F("SEND_HEADER_FAILED")); break;
+            case -3: Log.print(F("SEND_PAYLOAD_FAILED")); break;
+            case -4: Log.print(F("NOT_CONNECTED")); break;
+            case -5: Log.print(F("CONNECTION_LOST")); break;
+            case -6: Log.print(F("NO_STREAM")); break;
+            case -7: Log.print(F("NO_HTTP_SERVER")); break;
+            case -8: Log.print(F("TOO_LESS_RAM")); break;
+            case -9: Log.print(F("ENCODING")); break;
+            case -10: Log.print(F("STREAM_WRITE")); break;
+            case -11: Log.print(F("READ_TIMEOUT")); break;
+            default: Log.print(F("UNKNOWN")); break;
+        }
+        Log.print(F(")"));
+    }
+    Log.println();
+}
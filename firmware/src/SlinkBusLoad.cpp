@@ -0,0 +1,204 @@
+#include "SlinkBusLoad.h"
+
+const uint16_t SlinkBusLoad::GAP_LIMIT_MS[GAP_BUCKETS - 1] = {
+    5, 10, 20, 50, 100, 200, 500, 1000, 2000
+};
+
+SlinkBusLoad::SlinkBusLoad(int bus)
+: _bus(bus) {
+}
+
+void SlinkBusLoad::onTraffic(const SlinkTrafficEvent& ev) {
+    if (ev.len < 2 || (long)(ev.endUs - ev.startUs) <= 0) return;
+    uint32_t durationUs = ev.endUs - ev.startUs;
+
+    if (_frames == 0) _firstUs = ev.startUs;
+    _frames++;
+    if (ev.ours) _ours++;
+    _busyUs += durationUs;
+
+    unsigned long sec = ev.startUs / 1000000UL;
+    int slot = sec % UTIL_WINDOW_S;
+    if (_secStamp[slot] != sec) {
+        _secStamp[slot] = sec;
+        _secBusyUs[slot] = 0;
+    }
+    _secBusyUs[slot] += durationUs;
+
+    if (_lastEndUs && (long)(ev.startUs - _lastEndUs) >= 0) {
+        uint32_t gapMs = (ev.startUs - _lastEndUs) / 1000;
+        int b = 0;
+        while (b < GAP_BUCKETS - 1 && gapMs >= GAP_LIMIT_MS[b]) b++;
+        _gaps[b]++;
+    }
+    if (!_lastEndUs || (long)(ev.endUs - _lastEndUs) > 0) _lastEndUs = ev.endUs;
+
+    // Our own frames go out when we choose to; only changers have cadences
+    if (!ev.ours) _learn(_source(ev), ev.startUs, durationUs);
+}
+
+SlinkBusLoad::Source& SlinkBusLoad::_source(const SlinkTrafficEvent& ev) {
+    uint8_t type = ev.len > 2 ? ev.bytes[2] : 0;
+    for (int i = 0; i < _numSources; ++i) {
+        Source& s = _sources[i];
+        if (s.device == ev.bytes[1] && s.type == type && s.len == ev.len) return s;
+    }
+
+    // New source; a full table forgets the one heard from longest ago
+    int slot = _numSources;
+    if (_numSources == MAX_SOURCES) {
+        slot = 0;
+        for (int i = 1; i < _numSources; ++i) {
+            if ((long)(_sources[i].lastUs - _sources[slot].lastUs) < 0) slot = i;
+        }
+    } else {
+        _numSources++;
+    }
+    _sources[slot] = Source{ev.bytes[1], type, (uint8_t)ev.len, 0, 0, 0, 0, 0, 0};
+    return _sources[slot];
+}
+
+// Intervals that are a whole number of periods within tolerance refine the
+// period (a multiple means frames we didn't decode); anything else starts
+// it over
+void SlinkBusLoad::_learn(Source& s, unsigned long startUs, uint32_t durationUs) {
+    if (s.frames > 0) {
+        uint32_t interval = startUs - s.lastUs;
+        bool fits = false;
+        if (s.periodUs) {
+            uint32_t k = (interval + s.periodUs / 2) / s.periodUs;
+            if (k >= 1 && k <= (uint32_t)MAX_MISSED + 1) {
+                int32_t dev = (int32_t)(interval - k * s.periodUs);
+                uint32_t absDev = dev < 0 ? -dev : dev;
+                if (absDev <= s.periodUs / 8) {
+                    fits = true;
+                    s.periodUs += (int32_t)(interval / k - s.periodUs) / 4;
+                    s.jitterUs += ((int32_t)absDev - (int32_t)s.jitterUs) / 4;
+                    if (s.hits < 255) s.hits++;
+                }
+            }
+        }
+        if (!fits) {
+            s.periodUs = interval;
+            s.jitterUs = 0;
+            s.hits = 0;
+        }
+    }
+    s.durationUs = s.frames ? s.durationUs + ((int32_t)durationUs - (int32_t)s.durationUs) / 4
+                            : durationUs;
+    s.lastUs = startUs;
+    s.frames++;
+}
+
+bool SlinkBusLoad::_periodic(const Source& s, unsigned long now) const {
+    return s.hits >= PERIODIC_HITS &&
+           s.periodUs >= MIN_PERIOD_US && s.periodUs <= MAX_PERIOD_US &&
+           now - s.lastUs <= (unsigned long)s.periodUs * (MAX_MISSED + 1);
+}
+
+bool SlinkBusLoad::clearFor(unsigned long startUs, uint32_t durationUs, unsigned long* clearAtUs) const {
+    bool clear = true;
+    unsigned long clearAt = startUs;
+    for (int i = 0; i < _numSources; ++i) {
+        const Source& s = _sources[i];
+        if (!_periodic(s, startUs)) continue;
+
+        // First predicted frame that hasn't ended by startUs
+        uint32_t guard = GUARD_US + 2 * s.jitterUs;
+        long rel = (long)(startUs - s.lastUs) - (long)(s.durationUs + guard);
+        uint32_t k = rel < 0 ? 1 : (uint32_t)rel / s.periodUs + 1;
+        unsigned long next = s.lastUs + k * s.periodUs;
+
+        if ((long)(startUs + durationUs - (next - guard)) > 0) {
+            clear = false;
+            unsigned long end = next + s.durationUs + guard;
+            if ((long)(end - clearAt) > 0) clearAt = end;
+        }
+    }
+    if (!clear && clearAtUs) *clearAtUs = clearAt;
+    return clear;
+}
+
+bool SlinkBusLoad::txSlot(void* ctx, unsigned long startUs, uint32_t durationUs, unsigned long* clearAtUs) {
+    return static_cast<SlinkBusLoad*>(ctx)->clearFor(startUs, durationUs, clearAtUs);
+}
+
+uint16_t SlinkBusLoad::utilization() const {
+    if (_frames == 0) return 0;
+    unsigned long now = SlinkHal::nowMicros();
+    unsigned long sec = now / 1000000UL;
+    uint64_t busy = 0;
+    for (int i = 0; i < UTIL_WINDOW_S; ++i) {
+        if (sec - _secStamp[i] < (unsigned long)UTIL_WINDOW_S) busy += _secBusyUs[i];
+    }
+    // The current second has only partly gone by
+    uint64_t window = (uint64_t)(UTIL_WINDOW_S - 1) * 1000000UL + now % 1000000UL;
+    if (now - _firstUs < window) window = now - _firstUs;
+    return window ? (uint16_t)(busy * 1000 / window > 1000 ? 1000 : busy * 1000 / window) : 0;
+}
+
+uint16_t SlinkBusLoad::utilizationTotal() const {
+    unsigned long elapsed = SlinkHal::nowMicros() - _firstUs;
+    if (_frames == 0 || elapsed == 0) return 0;
+    uint64_t pm = _busyUs * 1000 / elapsed;
+    return (uint16_t)(pm > 1000 ? 1000 : pm);
+}
+
+int SlinkBusLoad::periodicSources() const {
+    unsigned long now = SlinkHal::nowMicros();
+    int n = 0;
+    for (int i = 0; i < _numSources; ++i) {
+        if (_periodic(_sources[i], now)) n++;
+    }
+    return n;
+}
+
+static void printPerMille(Print& out, uint16_t pm) {
+    out.print(pm / 10);
+    out.print('.');
+    out.print(pm % 10);
+    out.print('%');
+}
+
+void SlinkBusLoad::printReport(Print& out) const {
+    out.print(F("  utilization "));
+    printPerMille(out, utilization());
+    out.print(F(" (last "));
+    out.print(UTIL_WINDOW_S);
+    out.print(F("s), "));
+    printPerMille(out, utilizationTotal());
+    out.print(F(" overall  frames="));
+    out.print(_frames);
+    out.print(F(" ours="));
+    out.println(_ours);
+
+    out.print(F("  gaps ms:"));
+    for (int b = 0; b < GAP_BUCKETS; ++b) {
+        out.print(b < GAP_BUCKETS - 1 ? F(" <") : F(" >="));
+        out.print(GAP_LIMIT_MS[b < GAP_BUCKETS - 1 ? b : b - 1]);
+        out.print(':');
+        out.print(_gaps[b]);
+    }
+    out.println();
+
+    unsigned long now = SlinkHal::nowMicros();
+    for (int i = 0; i < _numSources; ++i) {
+        const Source& s = _sources[i];
+        out.print(F("  dev=0x"));
+        out.print(s.device, HEX);
+        out.print(F(" type=0x"));
+        out.print(s.type, HEX);
+        out.print(F(" len="));
+        out.print(s.len);
+        out.print(F(" frames="));
+        out.print(s.frames);
+        out.print(F(" period="));
+        out.print(s.periodUs / 1000);
+        out.print(F("ms jitter="));
+        out.print(s.jitterUs / 1000);
+        out.print(F("ms length="));
+        out.print(s.durationUs / 1000);
+        out.print(F("ms"));
+        out.println(_periodic(s, now) ? F(" periodic") : F(""));
+    }
+}
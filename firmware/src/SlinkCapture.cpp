@@ -0,0 +1,165 @@
+#include "SlinkCapture.h"
+
+static Print& Log = SlinkHal::log();
+
+// RMT clock divider - 1MHz tick rate (1µs resolution)
+static const uint8_t RMT_CLK_DIV = 80;  // 80MHz / 80 = 1MHz
+
+// ---------------- RMT ----------------
+
+SlinkRmtCapture::SlinkRmtCapture(int rxPin, rmt_channel_t channel, uint8_t memBlocks)
+: _rxPin(rxPin), _channel(channel), _memBlocks(memBlocks) {
+}
+
+bool SlinkRmtCapture::begin() {
+    // IMPORTANT: Due to transistor level shifter, signal is INVERTED:
+    // - S-Link bus idle (HIGH) -> ESP32 sees LOW
+    // - S-Link bus active (LOW pulse) -> ESP32 sees HIGH
+    // So we configure RMT for idle-low operation
+    // (no inversion needed - we handle it in pulse extraction)
+
+    SlinkHal::RmtRxConfig rxConfig;
+    rxConfig.clkDiv = RMT_CLK_DIV;
+    rxConfig.memBlocks = _memBlocks;
+    rxConfig.idleThreshold = IDLE_THRESHOLD_US;
+    rxConfig.filterTicks = 100;         // Filter glitches < 100µs
+    rxConfig.ringBufferBytes = 2048;    // 2KB ring buffer
+
+    if (!_rx.begin(_rxPin, _channel, rxConfig)) {
+        Log.println(F("[Capture] RMT init failed"));
+        return false;
+    }
+
+    Log.print(F("[Capture] RMT channel "));
+    Log.print((int)_channel);
+    Log.print(F(", "));
+    Log.print(_memBlocks);
+    Log.println(F(" mem blocks"));
+    return true;
+}
+
+rmt_item32_t* SlinkRmtCapture::receive(size_t* numItems, uint32_t timeoutMs) {
+    rmt_item32_t* items = _rx.receive(numItems, timeoutMs);
+    if (items) {
+        _stats.blocks++;
+        _stats.items += *numItems;
+        _stats.interrupts++;            // one RX-end interrupt per capture
+    }
+    return items;
+}
+
+void SlinkRmtCapture::release(rmt_item32_t* items) {
+    _rx.release(items);
+}
+
+// ---------------- GPIO edge ISR ----------------
+
+SlinkGpioCapture::SlinkGpioCapture(int rxPin)
+: _rxPin(rxPin) {
+}
+
+bool SlinkGpioCapture::begin() {
+    if (!SlinkHal::edgeCaptureBegin(_rxPin, IDLE_THRESHOLD_US, _onEdge, _onIdle, this)) {
+        Log.println(F("[Capture] GPIO edge capture init failed"));
+        return false;
+    }
+    Log.println(F("[Capture] GPIO edge capture"));
+    return true;
+}
+
+// Runs per edge. Each duration is held back by one edge so a glitch
+// (shorter than GLITCH_US) can be folded, with the level after it, into
+// the level before it, as the RMT input filter would.
+void IRAM_ATTR SlinkGpioCapture::_onEdge(void* arg, unsigned long us) {
+    SlinkGpioCapture* self = static_cast<SlinkGpioCapture*>(arg);
+    self->_interrupts++;
+
+    if (self->_idle) {
+        self->_idle = false;
+        self->_lastEdgeUs = us;
+        return;
+    }
+
+    uint32_t dt = us - self->_lastEdgeUs;
+    self->_lastEdgeUs = us;
+
+    if (self->_merge) {
+        self->_held += dt;
+        self->_merge = false;
+        return;
+    }
+    if (dt < GLITCH_US) {
+        self->_held += dt;
+        self->_merge = true;
+        return;
+    }
+
+    if (self->_held) {
+        self->_push(self->_held);
+    }
+    self->_held = dt;
+}
+
+void IRAM_ATTR SlinkGpioCapture::_onIdle(void* arg) {
+    SlinkGpioCapture* self = static_cast<SlinkGpioCapture*>(arg);
+    self->_interrupts++;
+
+    if (self->_held) {
+        self->_push(self->_held);
+    }
+    self->_held = 0;
+    self->_merge = false;
+    self->_idle = true;
+    self->_durations.push(0);
+}
+
+void IRAM_ATTR SlinkGpioCapture::_push(uint32_t us) {
+    // RMT durations are 15 bit; anything that long classifies as a gap anyway
+    _durations.push(us > 0x7FFF ? 0x7FFF : (uint16_t)us);
+}
+
+rmt_item32_t* SlinkGpioCapture::receive(size_t* numItems, uint32_t timeoutMs) {
+    *numItems = 0;
+    unsigned long start = SlinkHal::nowMillis();
+
+    for (;;) {
+        uint16_t d;
+        bool idleEnd = false;
+        while (_staged < BLOCK_ITEMS * 2 && _durations.pop(d)) {
+            rmt_item32_t& item = _items[_staged / 2];
+            if (_staged % 2 == 0) {
+                item.val = 0;
+                item.level0 = 1;
+                item.duration0 = d;
+            } else {
+                item.duration1 = d;
+            }
+            _staged++;
+            if (d == 0) {
+                idleEnd = true;
+                break;
+            }
+        }
+
+        // Hand out a finished burst, or a full block (the decoder carries
+        // the open frame over into the next one)
+        if (idleEnd || _staged == BLOCK_ITEMS * 2) {
+            *numItems = (_staged + 1) / 2;
+            _staged = 0;
+            _stats.blocks++;
+            _stats.items += *numItems;
+            _stats.interrupts = _interrupts;
+            _stats.overruns = _durations.dropped();
+            return _items;
+        }
+
+        if (timeoutMs == 0 || SlinkHal::nowMillis() - start >= timeoutMs) {
+            return nullptr;
+        }
+        SlinkHal::delayMillis(1);
+    }
+}
+
+void SlinkGpioCapture::release(rmt_item32_t* items) {
+    (void)items;
+}
@@ -0,0 +1,273 @@
+#include "SlinkConfirm.h"
+#include "SlinkDecoder.h"
+#include "SlinkCodec.h"
+
+static Print& Log = SlinkHal::log();
+
+SlinkConfirm::SlinkConfirm(SlinkTx& tx, const SlinkDecoder& decoder)
+: _tx(tx), _decoder(decoder) {
+    for (Pending& p : _pending) {
+        p = Pending{};
+        p.owner = this;
+    }
+}
+
+const char* SlinkConfirm::actionName(SlinkConfirmAction action) {
+    switch (action) {
+        case SLINK_CONFIRM_PLAY_DISC: return "play disc";
+        case SLINK_CONFIRM_PLAY:      return "play";
+        case SLINK_CONFIRM_STOP:      return "stop";
+        case SLINK_CONFIRM_PAUSE:     return "pause";
+        case SLINK_CONFIRM_NEXT:      return "next";
+        case SLINK_CONFIRM_PREVIOUS:  return "previous";
+    }
+    return "?";
+}
+
+bool SlinkConfirm::issue(const char* tag, SlinkConfirmAction action, int player, int disc, int track) {
+    if (!SlinkDevices::isValidPlayer(player)) player = 1;
+    _stats.issued++;
+
+    // The player's previous command is moot now, unless it is out and
+    // won't be repeated, or a skip this one adds to: then it still acts,
+    // and ends on its outcome
+    bool skip = action == SLINK_CONFIRM_NEXT || action == SLINK_CONFIRM_PREVIOUS;
+    for (Pending& q : _pending) {
+        if (!q.used || q.player != player || (skip && q.action == action)) continue;
+        if (!q.sent || _resendable(q)) _finish(q, false, "superseded");
+    }
+
+    Pending* slot = nullptr;
+    for (Pending& q : _pending) {
+        if (!q.used && q.queued == 0) {
+            slot = &q;
+            break;
+        }
+    }
+
+    const SlinkTrackStatus& st = _decoder.state(player);
+    Pending p = {};
+    p.owner = this;
+    p.used = true;
+    p.action = action;
+    p.player = (int8_t)player;
+    p.disc = (int16_t)disc;
+    p.track = (int8_t)(track > 0 ? track : 0);
+    p.wasPaused = st.paused;
+    p.discBefore = (int16_t)st.discNumber;
+    p.trackBefore = (int8_t)st.trackNumber;
+    p.steps = 1;
+    for (const Pending& q : _pending) {
+        // Skips still pending the same way act first
+        if (skip && q.used && q.player == player && q.action == action && q.steps >= p.steps) {
+            p.steps = (int8_t)(q.steps + 1);
+            p.discBefore = q.discBefore;
+            p.trackBefore = q.trackBefore;
+        }
+    }
+    p.issuedMs = SlinkHal::nowMillis();
+    p.deadlineMs = p.issuedMs + (action == SLINK_CONFIRM_PLAY_DISC ? DISC_DEADLINE_MS : DEADLINE_MS);
+    if (tag) {
+        strncpy(p.tag, tag, TAG_LEN - 1);
+        p.tag[TAG_LEN - 1] = '\0';
+    }
+
+    // Nothing would change on the bus to confirm these
+    bool onDisc = st.haveStatus && st.discNumber == disc && (!p.track || st.trackNumber == p.track);
+    p.already = (action == SLINK_CONFIRM_PLAY && st.playing) ||
+                (action == SLINK_CONFIRM_STOP && st.stopped) ||
+                (action == SLINK_CONFIRM_PLAY_DISC && onDisc && st.playing);
+
+    if (!slot) {
+        Pending tmp = p;
+        _finish(tmp, false, "not sent");
+        return false;
+    }
+    *slot = p;
+    if (!_send(*slot)) {
+        _finish(*slot, false, "not sent");
+        return false;
+    }
+    return true;
+}
+
+bool SlinkConfirm::_send(Pending& p) {
+    uint8_t bytes[4];
+    int len = 2;
+    bytes[0] = SlinkDevices::txDevice(p.player, p.disc);
+    switch (p.action) {
+        case SLINK_CONFIRM_PLAY_DISC:
+            bytes[1] = SLINK_CMD_PLAY_DISC;
+            bytes[2] = SlinkCodec::encodeDiscByte(p.disc);
+            bytes[3] = SlinkCodec::encodeTrackByte(p.track ? p.track : 1);
+            len = 4;
+            break;
+        case SLINK_CONFIRM_PLAY:     bytes[1] = SLINK_CMD_PLAY; break;
+        case SLINK_CONFIRM_STOP:     bytes[1] = SLINK_CMD_STOP; break;
+        case SLINK_CONFIRM_PAUSE:    bytes[1] = SLINK_CMD_PAUSE; break;
+        case SLINK_CONFIRM_NEXT:     bytes[1] = SLINK_CMD_NEXT_TRACK; break;
+        case SLINK_CONFIRM_PREVIOUS: bytes[1] = SLINK_CMD_PREV_TRACK; break;
+    }
+    // Counted first: a skip folded into a queued one completes right away
+    p.queued++;
+    p.attempts++;
+    p.sentMs = SlinkHal::nowMillis();
+    if (!_tx.sendAsync(bytes, len, _onSent, &p)) {
+        p.queued--;
+        p.attempts--;
+        return false;
+    }
+    return true;
+}
+
+void SlinkConfirm::_onSent(void* ctx, const SlinkTxCompletion& c) {
+    Pending& p = *static_cast<Pending*>(ctx);
+    p.queued--;
+    if (!p.used || !c.sent) return;
+
+    // Time to react counts from when it was on the wire
+    p.sent = true;
+    p.sentMs = SlinkHal::nowMillis();
+    if (p.already) p.owner->_finish(p, true, "already");
+}
+
+bool SlinkConfirm::_resendable(const Pending& p) {
+    return p.action == SLINK_CONFIRM_PLAY_DISC || p.action == SLINK_CONFIRM_PLAY ||
+           p.action == SLINK_CONFIRM_STOP;
+}
+
+void SlinkConfirm::onTransport(const SlinkTransportEvent& ev) {
+    for (Pending& p : _pending) {
+        if (!p.used || !p.sent || p.player != ev.player) continue;
+        p.heard = true;
+
+        bool done = false;
+        switch (p.action) {
+            case SLINK_CONFIRM_PLAY:
+                done = ev.code == 0x00;
+                break;
+            case SLINK_CONFIRM_STOP:
+                done = ev.code == 0x01;
+                break;
+            case SLINK_CONFIRM_PAUSE:
+                done = ev.code == (p.wasPaused ? 0x00 : 0x04);
+                break;
+            case SLINK_CONFIRM_PLAY_DISC: {
+                // Already on that disc and track: no status change to wait for
+                const SlinkTrackStatus& st = _decoder.state(p.player);
+                done = ev.code == 0x00 && st.discNumber == p.disc &&
+                       (!p.track || st.trackNumber == p.track);
+                break;
+            }
+            default:
+                break;
+        }
+        if (done) _finish(p, true, "confirmed");
+    }
+}
+
+void SlinkConfirm::onStatus(const SlinkTrackStatus& st) {
+    for (Pending& p : _pending) {
+        if (!p.used || !p.sent || p.player != st.player) continue;
+        p.heard = true;
+
+        bool done = false;
+        switch (p.action) {
+            case SLINK_CONFIRM_PLAY_DISC:
+                done = st.discNumber == p.disc && (!p.track || st.trackNumber == p.track);
+                break;
+            case SLINK_CONFIRM_NEXT:
+            case SLINK_CONFIRM_PREVIOUS: {
+                // A lone skip takes any change (previous may only restart
+                // the track); one behind others needs to get past them
+                int moved = st.trackNumber - p.trackBefore;
+                if (p.action == SLINK_CONFIRM_PREVIOUS) moved = -moved;
+                done = st.discNumber != p.discBefore || moved >= p.steps ||
+                       (p.steps == 1 && moved != 0);
+                break;
+            }
+            default:
+                break;
+        }
+        if (done) _finish(p, true, "confirmed");
+    }
+}
+
+void SlinkConfirm::loop() {
+    unsigned long now = SlinkHal::nowMillis();
+    for (Pending& p : _pending) {
+        if (!p.used) continue;
+        if ((long)(now - p.deadlineMs) >= 0) {
+            _finish(p, false, "timeout");
+        } else if (!p.heard && p.queued == 0 && _resendable(p) &&
+                   p.attempts < MAX_ATTEMPTS && now - p.sentMs >= RESEND_MS) {
+            Log.print(F("[CONFIRM] No reaction from P"));
+            Log.print(p.player);
+            Log.print(F(" to "));
+            Log.print(actionName((SlinkConfirmAction)p.action));
+            Log.println(F(", resending"));
+            if (_send(p)) _stats.resent++;
+        }
+    }
+}
+
+bool SlinkConfirm::isPending(const char* tag) const {
+    if (!tag || !tag[0]) return false;
+    for (const Pending& p : _pending) {
+        if (p.used && strncmp(p.tag, tag, TAG_LEN - 1) == 0) return true;
+    }
+    return false;
+}
+
+int SlinkConfirm::pending() const {
+    int n = 0;
+    for (const Pending& p : _pending) {
+        if (p.used) n++;
+    }
+    return n;
+}
+
+void SlinkConfirm::_finish(Pending& p, bool success, const char* reason) {
+    uint32_t latencyMs = SlinkHal::nowMillis() - p.issuedMs;
+    p.used = false;
+    if (success) {
+        _stats.confirmed++;
+        _stats.totalLatencyMs += latencyMs;
+        if (latencyMs > _stats.maxLatencyMs) _stats.maxLatencyMs = latencyMs;
+    } else {
+        _stats.failed++;
+    }
+
+    Log.print(F("[CONFIRM] P"));
+    Log.print(p.player);
+    Log.print(' ');
+    Log.print(actionName((SlinkConfirmAction)p.action));
+    Log.print(F(": "));
+    Log.print(reason);
+    Log.print(F(" after "));
+    Log.print(latencyMs);
+    Log.print(F(" ms, "));
+    Log.print(p.attempts);
+    Log.println(F(" sent"));
+
+    _results.emit(SlinkConfirmResult{p.tag, (SlinkConfirmAction)p.action, p.player, success,
+                                     p.attempts, latencyMs, reason});
+}
+
+void SlinkConfirm::printReport(Print& out) const {
+    out.print(F("  issued="));
+    out.print(_stats.issued);
+    out.print(F(" confirmed="));
+    out.print(_stats.confirmed);
+    out.print(F(" failed="));
+    out.print(_stats.failed);
+    out.print(F(" resent="));
+    out.print(_stats.resent);
+    out.print(F(" pending="));
+    out.print(pending());
+    out.print(F("  latency avg="));
+    out.print(_stats.confirmed ? (uint32_t)(_stats.totalLatencyMs / _stats.confirmed) : 0);
+    out.print(F("ms max="));
+    out.print(_stats.maxLatencyMs);
+    out.println(F("ms"));
+}
@@ -1,418 +1,564 @@
 #include "SlinkDecoder.h"
+#include "SlinkCodec.h"
+#include "SlinkDevices.h"
 
-// ---- Timing constants ----
-
-// RMT clock divider - 1MHz tick rate (1µs resolution)
-static const uint8_t RMT_CLK_DIV = 80;  // 80MHz / 80 = 1MHz
+static Print& Log = SlinkHal::log();
 
-// Idle threshold in RMT ticks (µs) - if line is idle this long, frame ends
-// This is handled by RMT hardware, not software
-static const uint16_t RMT_IDLE_THRESHOLD = 20000;  // 20ms
+// ---- Timing constants ----
 
 // Frame gap for software timeout (µs)
 static const unsigned long FRAME_GAP_US = 25000;  // 25ms
 
-// S-Link mark lengths (µs) - for reference
-// static const unsigned long SLINK_MARK_SYNC  = 2400;  // start bit
-// static const unsigned long SLINK_MARK_ONE   = 1200;  // logical 1
-// static const unsigned long SLINK_MARK_ZERO  = 600;   // logical 0
+// S-Link mark lengths live in SlinkPulseClassifier (nominal + learned)
 
 // ---------------- Constructor / setup ----------------
 
-SlinkDecoder::SlinkDecoder(int rxPin)
-: _rxPin(rxPin), _rmtChannel(RMT_CHANNEL_0) {
+SlinkDecoder::SlinkDecoder(int rxPin, rmt_channel_t channel)
+: _rmtCapture(rxPin, channel), _capture(&_rmtCapture) {
+    for (int len = 0; len <= MAX_FRAME_LEN; ++len) {
+        _ruleHead[len] = -1;
+        _ruleTail[len] = -1;
+    }
+
+    // Built-in frame types
+    //   Heartbeat:       41 04 00 55
+    //   Transport:       41 XX 00 CC
+    //   Track status:    41 XX 11 00 + 8
+    //   Time status:     41 XX 11 01 + 8
+    //   Extended status: 41 XX 15 00 + 10
+    registerFrameHandler(4,  frameKey(0x04, 0x00, 0x55), 0xFFFFFF,
+                         _member<&SlinkDecoder::_handleHeartbeatFrame>, this);
+    registerFrameHandler(4,  frameKey(0x00, 0x00, 0x00), 0x00FF00,
+                         _member<&SlinkDecoder::_handleTransportFrame>, this);
+    registerFrameHandler(12, frameKey(0x00, 0x11, 0x00), 0x00FFFF,
+                         _member<&SlinkDecoder::_handleTrackStatusFrame>, this);
+    registerFrameHandler(12, frameKey(0x00, 0x11, 0x01), 0x00FFFF,
+                         _member<&SlinkDecoder::_handleTimeStatusFrame>, this);
+    registerFrameHandler(14, frameKey(0x00, 0x15, 0x00), 0x00FFFF,
+                         _member<&SlinkDecoder::_handleExtendedStatusFrame>, this);
 }
 
 void SlinkDecoder::begin() {
-    // Configure RMT for receiving
-    //
-    // IMPORTANT: Due to transistor level shifter, signal is INVERTED:
-    // - S-Link bus idle (HIGH) -> ESP32 sees LOW
-    // - S-Link bus active (LOW pulse) -> ESP32 sees HIGH
-    // So we configure RMT for idle-low operation
-
-    rmt_config_t rxConfig = RMT_DEFAULT_CONFIG_RX((gpio_num_t)_rxPin, _rmtChannel);
-    rxConfig.clk_div = RMT_CLK_DIV;
-    rxConfig.mem_block_num = 4;  // Use 4 memory blocks (256 items total)
-    rxConfig.rx_config.idle_threshold = RMT_IDLE_THRESHOLD;
-    rxConfig.rx_config.filter_en = true;
-    rxConfig.rx_config.filter_ticks_thresh = 100;  // Filter glitches < 100µs
-
-    // Set idle level to LOW (inverted signal)
-    rxConfig.flags = 0;  // No inversion needed - we handle it in pulse extraction
-
-    esp_err_t err = rmt_config(&rxConfig);
-    if (err != ESP_OK) {
-        Serial.print(F("[SlinkDecoder] RMT config failed: "));
-        Serial.println(err);
+    if (!_capture->begin()) {
+        Log.println(F("[SlinkDecoder] Capture init failed"));
         return;
     }
 
-    err = rmt_driver_install(_rmtChannel, 2048, 0);  // 2KB ring buffer
-    if (err != ESP_OK) {
-        Serial.print(F("[SlinkDecoder] RMT driver install failed: "));
-        Serial.println(err);
-        return;
+    _resetFramer();
+    _lastRxTime = 0;
+    for (int p = 0; p < SLINK_MAX_PLAYERS; ++p) {
+        _states[p] = SlinkTrackStatus{};
+        _states[p].player = p + 1;
+        _states[p].bus = _busId;
     }
 
-    // Start receiving
-    err = rmt_rx_start(_rmtChannel, true);
-    if (err != ESP_OK) {
-        Serial.print(F("[SlinkDecoder] RMT rx start failed: "));
-        Serial.println(err);
-        return;
+    Log.print(F("[SlinkDecoder] RX initialized ("));
+    Log.print(_capture->name());
+    Log.println(F(" capture)"));
+}
+
+bool SlinkDecoder::registerFrameHandler(uint8_t len, uint32_t key, uint32_t mask,
+                                        SlinkFrameHandler fn, void* ctx) {
+    if (len > MAX_FRAME_LEN || !fn || _numRules >= MAX_FRAME_RULES) {
+        Log.println(F("[SlinkDecoder] Frame handler table full or bad length"));
+        return false;
     }
 
-    _pulseCount = 0;
-    _lastRxTime = 0;
-    _haveLastSig = false;
-    _state = SlinkTrackStatus{};
+    int8_t idx = (int8_t)_numRules++;
+    _rules[idx] = FrameRule{key & mask, mask, fn, ctx, -1};
 
-    Serial.println(F("[SlinkDecoder] RMT-based RX initialized"));
+    if (_ruleTail[len] < 0) {
+        _ruleHead[len] = idx;
+    } else {
+        _rules[_ruleTail[len]].next = idx;
+    }
+    _ruleTail[len] = idx;
+    return true;
 }
 
-void SlinkDecoder::onStatus(SlinkStatusCallback cb) {
-    _statusCb = cb;
-}
+// ---------------- Main loop ----------------
+
+bool SlinkDecoder::startTask(int core, int priority) {
+    // Set first: the task may deliver a frame before startTask() returns
+    _taskMode = true;
+    if (!SlinkHal::startTask(_rxTask, this, "slink_rx", 4096, priority, core)) {
+        _taskMode = false;
+        Log.println(F("[SlinkDecoder] RX task start failed, staying in polled mode"));
+        return false;
+    }
 
-void SlinkDecoder::onTransport(SlinkTransportCallback cb) {
-    _transportCb = cb;
+    Log.print(F("[SlinkDecoder] RX task running on core "));
+    Log.println(core);
+    return true;
 }
 
-// ---------------- Main loop ----------------
+void SlinkDecoder::_rxTask(void* arg) {
+    SlinkDecoder* self = static_cast<SlinkDecoder*>(arg);
+    for (;;) {
+        self->_pollCapture(RX_TASK_WAIT_MS);
+    }
+}
 
 void SlinkDecoder::loop() {
-    _pollRmt();
-}
+    if (!_taskMode) {
+        _pollCapture(0);
+        return;
+    }
 
-void SlinkDecoder::_pollRmt() {
-    RingbufHandle_t rb = nullptr;
-    rmt_get_ringbuf_handle(_rmtChannel, &rb);
-    if (!rb) return;
-
-    size_t rxSize = 0;
-    rmt_item32_t* items = (rmt_item32_t*)xRingbufferReceive(rb, &rxSize, 0);
-
-    if (items && rxSize > 0) {
-        int numItems = rxSize / sizeof(rmt_item32_t);
-
-        // Convert RMT items to pulse durations
-        // RMT captures alternating level0/level1 durations
-        // We need ALL durations to find the sync and bit pulses
-        _pulseCount = 0;
-        for (int i = 0; i < numItems && _pulseCount < MAX_PULSES; i++) {
-            // Capture both durations from each RMT item
-            if (items[i].duration0 > 0) {
-                _pulses[_pulseCount++] = items[i].duration0;
-            }
-            if (items[i].duration1 > 0 && _pulseCount < MAX_PULSES) {
-                _pulses[_pulseCount++] = items[i].duration1;
-            }
+    SlinkFrame frame;
+    while (_frameQueue.pop(frame)) {
+        _deliverFrame(frame);
+    }
+}
 
-            // Check for end marker
-            if (items[i].duration0 == 0 && items[i].duration1 == 0) {
-                break;
-            }
+void SlinkDecoder::_pollCapture(uint32_t timeoutMs) {
+    size_t numItems = 0;
+    rmt_item32_t* items = _capture->receive(&numItems, timeoutMs);
+    if (!items) return;
+
+    unsigned long now = SlinkHal::nowMicros();
+    _rxStats.captures++;
+
+    // A frame left open by the previous capture only continues if this
+    // capture follows on directly; otherwise it is lost
+    if (_rxPhase == RX_BITS && now - _lastRxTime > FRAME_GAP_US) {
+        _rxPhase = RX_HUNT;
+        _rxStats.dropped++;
+    }
+    _lastRxTime = now;
+
+    // The capture ended IDLE_THRESHOLD_US after its last edge, so its
+    // pulses lay on the wire just before that
+    unsigned long total = 0;
+    bool ended = false;
+    for (size_t i = 0; i < numItems && !ended; ++i) {
+        total += items[i].duration0;
+        ended = items[i].duration0 == 0 || items[i].duration1 == 0;
+        total += ended ? 0 : items[i].duration1;
+    }
+    _rxClockUs = now - total - (ended ? SlinkCapture::IDLE_THRESHOLD_US : 0);
+
+    // Decode straight out of the borrowed ring-buffer memory.
+    // RMT captures alternating level0/level1 durations and we need ALL of
+    // them to find the sync and bit pulses; no intermediate pulse copy.
+    // A zero duration is the idle end marker.
+    bool idleEnd = false;
+    for (size_t i = 0; i < numItems; ++i) {
+        const rmt_item32_t& item = items[i];
+
+        if (item.duration0 == 0) {
+            idleEnd = true;
+            break;
         }
+        _feedPulse(item.duration0);
 
-        // Return buffer to ring buffer
-        vRingbufferReturnItem(rb, (void*)items);
-
-        // Process the frame if we got pulses
-        if (_pulseCount > 0) {
-            _lastRxTime = micros();
-            _processFrame();
+        if (item.duration1 == 0) {
+            idleEnd = true;
+            break;
         }
+        _feedPulse(item.duration1);
     }
-}
 
-void SlinkDecoder::_processFrame() {
-    if (_pulseCount < 3) {
-        return;
+    // Return buffer to ring buffer before running any handlers
+    _capture->release(items);
+
+    if (_rxPhase == RX_BITS) {
+        if (idleEnd) {
+            _finishFrame();
+        } else {
+            // Capture was cut off mid-frame (RMT memory full): carry over
+            _rxCarried = true;
+        }
     }
-    _decodeFrame();
 }
 
 // ---------------- Pulse classification & frame decode ----------------
 
-char SlinkDecoder::_classifyPulse(unsigned long dt) {
-    if (dt > 200000UL) return 'G';                  // huge gap (ignored)
-    if (dt >= 2000UL && dt < 5000UL) return 'Y';    // sync (~2400 us)
-    if (dt >= 900UL  && dt < 2000UL) return 'L';    // long (~1240 us) = 1
-    if (dt < 900UL)  return 'S';                    // short (~650 us) = 0
-    return '?';
+void SlinkDecoder::_resetFramer() {
+    _rxPhase = RX_HUNT;
+    _rxCarried = false;
+    _rxStats = SlinkRxStats{};
 }
 
-void SlinkDecoder::_decodeFrame() {
-    if (_pulseCount < 3) {
+// Streaming framer: a sync 'Y' opens a frame (closing any open one), S/L
+// bits are shifted in MSB first, and any other symbol or the capture's
+// idle marker closes it. Back-to-back frames in one capture all decode.
+void SlinkDecoder::_feedPulse(uint32_t dt) {
+    uint8_t margin;
+    char c = _classifier.classify(dt, &margin);
+    unsigned long at = _rxClockUs;
+    _rxClockUs += dt;
+
+    if (c == 'Y') {
+        if (_rxPhase == RX_BITS) {
+            _finishFrame();
+        }
+        _startFrame();
+        _rxFrameStartUs = at;
+        _rxFrameEndUs = _rxClockUs;
+        _classifier.learn(c, dt, margin);
+        _rxMinMargin = margin;
+        _rxWidthSum[SlinkPulseClassifier::SYNC] = dt;
+        _rxWidthCount[SlinkPulseClassifier::SYNC] = 1;
         return;
     }
 
-    char symbols[MAX_PULSES];
-    for (int i = 0; i < _pulseCount; ++i) {
-        symbols[i] = _classifyPulse(_pulses[i]);
+    if (_rxPhase != RX_BITS) {
+        return;
     }
 
-    // Find sync 'Y'
-    int syncIndex = -1;
-    for (int i = 0; i < _pulseCount; ++i) {
-        if (symbols[i] == 'Y') {
-            syncIndex = i;
-            break;
-        }
-    }
-    if (syncIndex < 0) {
+    if (c != 'S' && c != 'L') {
+        _finishFrame();
         return;
     }
 
-    int bitStart = syncIndex + 1;
+    _classifier.learn(c, dt, margin);
+    if (margin < _rxMinMargin) _rxMinMargin = margin;
 
-    uint8_t bytes[16];
-    int byteCount = 0;
-    uint8_t curByte = 0;
-    int bitsInByte = 0;
+    int cls = (c == 'L') ? SlinkPulseClassifier::ONE : SlinkPulseClassifier::ZERO;
+    _rxWidthSum[cls] += dt;
+    _rxWidthCount[cls]++;
 
-    for (int i = bitStart; i < _pulseCount; ++i) {
-        char c = symbols[i];
-        if (c != 'S' && c != 'L') {
-            // stop at non-bit
-            break;
+    _rxFrameEndUs = _rxClockUs;
+    _rxByte <<= 1;
+    if (c == 'L') _rxByte |= 1;
+
+    if (++_rxBits == 8) {
+        if (_rxLen < (int)sizeof(_rxBytes)) {
+            _rxBytes[_rxLen++] = _rxByte;
+        } else {
+            _rxOverrun = true;
         }
+        _rxByte = 0;
+        _rxBits = 0;
+    }
+}
 
-        curByte <<= 1;
-        if (c == 'L') curByte |= 1;
+void SlinkDecoder::_startFrame() {
+    _rxPhase = RX_BITS;
+    _rxLen = 0;
+    _rxByte = 0;
+    _rxBits = 0;
+    _rxOverrun = false;
+    _rxCarried = false;
+    _rxMinMargin = 100;
+    for (int i = 0; i < 3; ++i) {
+        _rxWidthSum[i] = 0;
+        _rxWidthCount[i] = 0;
+    }
+    _classifier.frameBegin();
+}
 
-        bitsInByte++;
-        if (bitsInByte == 8) {
-            if (byteCount < (int)sizeof(bytes)) {
-                bytes[byteCount++] = curByte;
-            }
-            curByte = 0;
-            bitsInByte = 0;
+void SlinkDecoder::_finishFrame() {
+    _rxPhase = RX_HUNT;
+
+    if (_rxLen == 0) {
+        _rxStats.dropped++;
+        return;
+    }
+    if (_rxBits != 0 || _rxOverrun) {
+        _rxStats.truncated++;
+    }
+    if (_rxCarried) {
+        _rxStats.carried++;
+    }
+    _rxStats.frames++;
+
+    if (_rxLen >= 2 && _rxBytes[0] == 0x41) {
+        _classifier.frameEnd(SlinkDevices::playerForDevice(_rxBytes[1]));
+    }
+    if (_rxMinMargin < SlinkPulseClassifier::LOW_CONFIDENCE_PCT) {
+        _rxStats.lowConfidence++;
+    }
+
+    // S-Link status frames from CD players always start with 0x41; frames
+    // starting with 0x9x are our own TX commands being echoed back, and go
+    // to the echo channel with their mark widths
+    _emitFrame(_rxBytes, _rxLen, _rxMinMargin);
+}
+
+// In task mode this runs on the RX task: hand the frame over instead of
+// touching decoder state or callbacks from here.
+void SlinkDecoder::_emitFrame(const uint8_t* bytes, int len, uint8_t confidence) {
+    SlinkFrame frame;
+    frame.len = (uint8_t)len;
+    memcpy(frame.bytes, bytes, len);
+    frame.rxMicros = _lastRxTime;
+    frame.confidence = confidence;
+    frame.startUs = _rxFrameStartUs;
+    frame.endUs = _rxFrameEndUs;
+    if (bytes[0] != 0x41) {
+        for (int i = 0; i < 3; ++i) {
+            frame.widthUs[i] = _rxWidthCount[i] ? (uint16_t)(_rxWidthSum[i] / _rxWidthCount[i]) : 0;
         }
     }
 
-    if (byteCount == 0) {
+    if (!_taskMode) {
+        _deliverFrame(frame);
         return;
     }
+    _frameQueue.push(frame);
+}
 
-    // Filter: S-Link status frames from CD players always start with 0x41
-    // Frames starting with 0x9x are our own TX commands being echoed back
-    if (bytes[0] != 0x41) {
+void SlinkDecoder::_deliverFrame(const SlinkFrame& frame) {
+    _events.traffic.emit(SlinkTrafficEvent{_busId, frame.bytes, frame.len,
+                                           frame.startUs, frame.endUs,
+                                           frame.bytes[0] != 0x41});
+    if (frame.bytes[0] != 0x41) {
+        _events.echo.emit(SlinkEchoEvent{_busId, frame.bytes, frame.len,
+                                         frame.widthUs[SlinkPulseClassifier::SYNC],
+                                         frame.widthUs[SlinkPulseClassifier::ONE],
+                                         frame.widthUs[SlinkPulseClassifier::ZERO],
+                                         frame.rxMicros});
         return;
     }
 
-    _handleFrame(bytes, byteCount);
+    if (frame.confidence < SlinkPulseClassifier::LOW_CONFIDENCE_PCT) {
+        Log.print(F("[RX] Low confidence frame (margin "));
+        Log.print(frame.confidence);
+        Log.print(F("%): "));
+        for (int i = 0; i < frame.len; ++i) {
+            if (frame.bytes[i] < 0x10) Log.print('0');
+            Log.print(frame.bytes[i], HEX);
+            if (i < frame.len - 1) Log.print(' ');
+        }
+        Log.println();
+    }
+
+    if (frame.len >= 2 && !_events.activity.empty()) {
+        uint8_t dev = frame.bytes[1];
+        bool heartbeat = dev == SlinkDevices::HEARTBEAT_DEVICE;
+        int player = heartbeat ? SlinkDevices::heartbeatPlayer()
+                               : SlinkDevices::playerForDevice(dev);
+        if (player) {
+            _events.activity.emit(SlinkActivityEvent{_busId, player, dev, heartbeat});
+        }
+    }
+
+    _handlingStartUs = frame.startUs;
+    _handleFrame(frame.bytes, frame.len);
 }
 
 // ---------------- Frame handlers ----------------
 
 void SlinkDecoder::_handleFrame(const uint8_t* bytes, int len) {
-    _handleTransportFrame(bytes, len);
-    _handleTrackStatusFrame(bytes, len);
-    _handleTimeStatusFrame(bytes, len);
-    _handleExtendedStatusFrame(bytes, len);
-    _handleHeartbeatFrame(bytes, len);
+    if (len <= MAX_FRAME_LEN) {
+        uint32_t key = frameKey(len > 1 ? bytes[1] : 0,
+                                len > 2 ? bytes[2] : 0,
+                                len > 3 ? bytes[3] : 0);
+
+        for (int8_t i = _ruleHead[len]; i >= 0; i = _rules[i].next) {
+            const FrameRule& rule = _rules[i];
+            if ((key & rule.mask) == rule.key && rule.fn(rule.ctx, bytes, len)) {
+                return;
+            }
+        }
+    }
+
     _handleOtherFrame(bytes, len);
 }
 
 // Transport frames: 41 XX 00 CC (device code varies by player)
 // Player 1: 0x40, Player 2: 0x44
-void SlinkDecoder::_handleTransportFrame(const uint8_t* bytes, int len) {
-    if (len != 4) return;
-    if (bytes[0] != 0x41) return;
-    // Accept transport frames from any known device (0x40=P1, 0x44=P2)
+bool SlinkDecoder::_handleTransportFrame(const uint8_t* bytes, int) {
+    // Accept transport frames from any known player's low-range device
     uint8_t dev = bytes[1];
-    if (dev != 0x40 && dev != 0x44) return;
-    if (bytes[2] != 0x00) return;
+    if (!SlinkDevices::isTransportDevice(dev)) return false;
 
+    int player = SlinkDevices::playerForDevice(dev);
+    SlinkTrackStatus& state = _states[player - 1];
     uint8_t code = bytes[3];
 
+    Log.print(F("[STATE] P"));
+    Log.print(player);
+    Log.print(' ');
+
     switch (code) {
         case 0x00: // PLAY
-            _state.playing = true;
-            _state.paused  = false;
-            _state.stopped = false;
-            Serial.println(F("[STATE] PLAY"));
+            state.playing = true;
+            state.paused  = false;
+            state.stopped = false;
+            Log.println(F("PLAY"));
             break;
 
         case 0x04: // PAUSE
-            _state.playing = false;
-            _state.paused  = true;
-            _state.stopped = false;
-            Serial.println(F("[STATE] PAUSE"));
+            state.playing = false;
+            state.paused  = true;
+            state.stopped = false;
+            Log.println(F("PAUSE"));
             break;
 
         case 0x01: // STOP
-            _state.playing = false;
-            _state.paused  = false;
-            _state.stopped = true;
-            Serial.println(F("[STATE] STOP"));
+            state.playing = false;
+            state.paused  = false;
+            state.stopped = true;
+            Log.println(F("STOP"));
             break;
 
         default:
-            Serial.print(F("[STATE] TRANSPORT code 0x"));
-            if (code < 0x10) Serial.print('0');
-            Serial.println(code, HEX);
+            Log.print(F("TRANSPORT code 0x"));
+            if (code < 0x10) Log.print('0');
+            Log.println(code, HEX);
             break;
     }
 
-    if (_transportCb) {
-        _transportCb(code);
-    }
+    _events.transport.emit(SlinkTransportEvent{_busId, player, code});
+    return true;
 }
 
 // Extended status:
 // Player 1: dev=0x40 (discs 1–200) or 0x45 (discs 201–300)
 // Player 2: dev=0x44 (discs 1–200) or 0x51 (discs 201–300)
 // Frame format: 41 XX 11 00 [8 bytes sig]
-void SlinkDecoder::_handleTrackStatusFrame(const uint8_t* bytes, int len) {
-    if (len != 12) return;
-    if (bytes[0] != 0x41) return;
-    if (bytes[2] != 0x11 || bytes[3] != 0x00) return;
-
+bool SlinkDecoder::_handleTrackStatusFrame(const uint8_t* bytes, int len) {
     uint8_t dev = bytes[1];
+    int player = SlinkDevices::playerForDevice(dev);
 
     // Log unknown device codes to help discover new player/range combinations
-    if (dev != 0x40 && dev != 0x45 && dev != 0x44 && dev != 0x51) {
-        Serial.print(F("[UNKNOWN DEV] 0x"));
-        if (dev < 0x10) Serial.print('0');
-        Serial.print(dev, HEX);
-        Serial.print(F("  Frame: "));
+    if (player == 0) {
+        Log.print(F("[UNKNOWN DEV] 0x"));
+        if (dev < 0x10) Log.print('0');
+        Log.print(dev, HEX);
+        Log.print(F("  Frame: "));
         for (int i = 0; i < len; ++i) {
-            if (bytes[i] < 0x10) Serial.print('0');
-            Serial.print(bytes[i], HEX);
-            if (i < len - 1) Serial.print(' ');
-        }
-        Serial.println();
-    }
-
-    uint8_t sig[8];
-    for (int i = 0; i < 8; ++i) {
-        sig[i] = bytes[4 + i];
-    }
-
-    bool changed = false;
-    if (_haveLastSig) {
-        for (int i = 0; i < 8; ++i) {
-            if (sig[i] != _lastSig[i]) {
-                changed = true;
-                break;
-            }
+            if (bytes[i] < 0x10) Log.print('0');
+            Log.print(bytes[i], HEX);
+            if (i < len - 1) Log.print(' ');
         }
-    } else {
-        changed = true;
+        Log.println();
+        return true;
     }
 
-    for (int i = 0; i < 8; ++i) {
-        _lastSig[i] = sig[i];
-    }
-    _haveLastSig = true;
+    // Everything below is per player, so interleaved frames from several
+    // changers don't register as changes against each other
+    SlinkTrackStatus& state = _states[player - 1];
 
+    const uint8_t* sig = &bytes[4];
     uint16_t discCode  = (uint16_t(sig[0]) << 8) | sig[1];
     uint16_t trackCode = (uint16_t(sig[2]) << 8) | sig[3];
 
-    int discIndex  = _decodeIndexFromCode(discCode,  300);
-    int trackIndex = _decodeIndexFromCode(trackCode, 200);
+    int discIndex  = SlinkCodec::decodeIndex(discCode,  300);
+    int trackIndex = SlinkCodec::decodeIndex(trackCode, 200);
 
     int discNumber  = -1;
     int trackNumber = -1;
-    int player = 0;
 
-    // Determine player and decode disc number
+    // Decode disc number from the device's disc range
     if (discIndex > 0) {
-        if (dev == 0x40) {
-            // Player 1, discs 1-200
-            player = 1;
-            discNumber = _decodeDiscNumber_1to200_FromIndex(discIndex);
-        } else if (dev == 0x45) {
-            // Player 1, discs 201-300
-            player = 1;
-            discNumber = _decodeDiscNumber_201to300_FromIndex(discIndex);
-        } else if (dev == 0x44) {
-            // Player 2, discs 1-200
-            player = 2;
-            discNumber = _decodeDiscNumber_1to200_FromIndex(discIndex);
-        } else if (dev == 0x51) {
-            // Player 2, discs 201-300
-            player = 2;
-            discNumber = _decodeDiscNumber_201to300_FromIndex(discIndex);
-        }
+        discNumber = SlinkDevices::isHighRange(dev)
+            ? SlinkCodec::discNumberHighFromIndex(discIndex)
+            : SlinkCodec::discNumberLowFromIndex(discIndex);
     }
     if (trackIndex > 0) {
-        trackNumber = _decodeTrackNumberFromIndex(trackIndex);
+        trackNumber = SlinkCodec::trackNumberFromIndex(trackIndex);
+    }
+
+    _statusStats.observed++;
+    if (discNumber < 0 || trackNumber < 0) {
+        _statusStats.invalid++;
+    } else {
+        _events.statusFrame.emit(SlinkStatusFrameEvent{_busId, player, discNumber, trackNumber,
+                                                       _handlingStartUs});
+    }
+
+    // Only a disc/track seen N times in the last M frames becomes state
+    if (!_confirmStatus(player, discNumber, trackNumber)) {
+        return true;
     }
+    _statusStats.committed++;
+
+    state.haveStatus  = true;
+    state.player      = player;
+    state.discCode    = discCode;
+    state.trackCode   = trackCode;
+    state.discIndex   = discIndex;
+    state.trackIndex  = trackIndex;
+    state.discNumber  = discNumber;
+    state.trackNumber = trackNumber;
 
-    // If disc or track changed, the player must be playing
+    // Disc or track changed, so the player must be playing
     // (paused or stopped players don't change tracks)
-    bool discOrTrackChanged = (_state.discNumber != discNumber || _state.trackNumber != trackNumber);
-
-    _state.haveStatus  = true;
-    _state.player      = player;
-    _state.discCode    = discCode;
-    _state.trackCode   = trackCode;
-    _state.discIndex   = discIndex;
-    _state.trackIndex  = trackIndex;
-    _state.discNumber  = discNumber;
-    _state.trackNumber = trackNumber;
-
-    // Infer play state from track changes - if track changed, we're playing
-    if (discOrTrackChanged && _state.haveStatus) {
-        _state.playing = true;
-        _state.paused = false;
-        _state.stopped = false;
-    }
-
-    if (changed) {
-        Serial.print(F("[STATUS] Dev=0x"));
-        if (dev < 0x10) Serial.print('0');
-        Serial.print(dev, HEX);
-        Serial.print(F("  Sig: "));
-        for (int i = 0; i < 8; ++i) {
-            if (sig[i] < 0x10) Serial.print('0');
-            Serial.print(sig[i], HEX);
-            if (i < 7) Serial.print(' ');
-        }
-        Serial.println();
-
-        Serial.print(F("[DECODE] DiscCode=0x"));
-        if (discCode < 0x1000) Serial.print('0');
-        if (discCode < 0x100)  Serial.print('0');
-        if (discCode < 0x10)   Serial.print('0');
-        Serial.print(discCode, HEX);
-
-        Serial.print(F("  TrackCode=0x"));
-        if (trackCode < 0x1000) Serial.print('0');
-        if (trackCode < 0x100)  Serial.print('0');
-        if (trackCode < 0x10)   Serial.print('0');
-        Serial.println(trackCode, HEX);
-
-        Serial.print(F("[DECODE] DiscIndex="));
-        Serial.print(discIndex);
-        Serial.print(F("  TrackIndex="));
-        Serial.println(trackIndex);
-
-        Serial.print(F("[DECODE] Player="));
-        Serial.print(player);
-        Serial.print(F("  DiscNumber="));
-        Serial.print(discNumber);
-        Serial.print(F("  TrackNumber="));
-        Serial.println(trackNumber);
-    }
-
-    Serial.print(F("[FRAME] 41 "));
-    if (dev < 0x10) Serial.print('0');
-    Serial.print(dev, HEX);
-    Serial.print(F(" 11 00 "));
-    for (int i = 4; i < len; ++i) {
-        if (bytes[i] < 0x10) Serial.print('0');
-        Serial.print(bytes[i], HEX);
-        if (i < len - 1) Serial.print(' ');
-    }
-    Serial.println();
-
-    if (_statusCb) {
-        _statusCb(_state);
+    state.playing = true;
+    state.paused = false;
+    state.stopped = false;
+
+    Log.print(F("[STATUS] Dev=0x"));
+    if (dev < 0x10) Log.print('0');
+    Log.print(dev, HEX);
+    Log.print(F("  Sig: "));
+    for (int i = 0; i < 8; ++i) {
+        if (sig[i] < 0x10) Log.print('0');
+        Log.print(sig[i], HEX);
+        if (i < 7) Log.print(' ');
+    }
+    Log.println();
+
+    Log.print(F("[DECODE] DiscCode=0x"));
+    if (discCode < 0x1000) Log.print('0');
+    if (discCode < 0x100)  Log.print('0');
+    if (discCode < 0x10)   Log.print('0');
+    Log.print(discCode, HEX);
+
+    Log.print(F("  TrackCode=0x"));
+    if (trackCode < 0x1000) Log.print('0');
+    if (trackCode < 0x100)  Log.print('0');
+    if (trackCode < 0x10)   Log.print('0');
+    Log.println(trackCode, HEX);
+
+    Log.print(F("[DECODE] DiscIndex="));
+    Log.print(discIndex);
+    Log.print(F("  TrackIndex="));
+    Log.println(trackIndex);
+
+    Log.print(F("[DECODE] Player="));
+    Log.print(player);
+    Log.print(F("  DiscNumber="));
+    Log.print(discNumber);
+    Log.print(F("  TrackNumber="));
+    Log.println(trackNumber);
+
+    _events.status.emit(state);
+    return true;
+}
+
+// Records one disc/track observation for player and returns true when it
+// should be committed: it is valid, differs from the committed state, and
+// at least _confirmN of the last _confirmM observations (within the time
+// window, if set) agree on it.
+bool SlinkDecoder::_confirmStatus(int player, int disc, int track) {
+    StatusHistory& h = _history[player - 1];
+    unsigned long now = SlinkHal::nowMillis();
+
+    StatusObservation& slot = h.obs[h.next];
+    slot.disc  = (int16_t)disc;
+    slot.track = (int8_t)track;
+    slot.ms    = now;
+    h.next = (uint8_t)((h.next + 1) % _confirmM);
+    if (h.count < _confirmM) h.count++;
+
+    const SlinkTrackStatus& state = _states[player - 1];
+    if (disc < 0 || track < 0) return false;
+    if (state.haveStatus && state.discNumber == disc && state.trackNumber == track) return false;
+
+    int agree = 0;
+    for (int i = 0; i < h.count; ++i) {
+        const StatusObservation& o = h.obs[i];
+        if (_confirmWindowMs && now - o.ms > _confirmWindowMs) continue;
+        if (o.disc == disc && o.track == track) agree++;
+    }
+    return agree >= _confirmN;
+}
+
+void SlinkDecoder::setConfirmation(uint8_t n, uint8_t m, uint32_t windowMs) {
+    if (m < 1) m = 1;
+    if (m > MAX_CONFIRM_M) m = MAX_CONFIRM_M;
+    if (n < 1) n = 1;
+    if (n > m) n = m;
+    _confirmN = n;
+    _confirmM = m;
+    _confirmWindowMs = windowMs;
+    for (int p = 0; p < SLINK_MAX_PLAYERS; ++p) {
+        _history[p] = StatusHistory{};
     }
 }
 
@@ -420,20 +566,11 @@ void SlinkDecoder::_handleTrackStatusFrame(const uint8_t* bytes, int len) {
 // These appear during playback with elapsed track time
 // Frame: 41 [DEV] 11 01 [4 bytes constant?] [2 bytes time MM:SS in BCD]
 // Example: 41 44 11 01 00 01 00 01 00 00 05 41 = 5:41 elapsed
-void SlinkDecoder::_handleTimeStatusFrame(const uint8_t* bytes, int len) {
-    if (len != 12) return;
-    if (bytes[0] != 0x41) return;
-    if (bytes[2] != 0x11 || bytes[3] != 0x01) return;
-
+bool SlinkDecoder::_handleTimeStatusFrame(const uint8_t* bytes, int) {
     uint8_t dev = bytes[1];
 
     // Determine player from device code
-    int player = 0;
-    if (dev == 0x40 || dev == 0x45) {
-        player = 1;
-    } else if (dev == 0x44 || dev == 0x51) {
-        player = 2;
-    }
+    int player = SlinkDevices::playerForDevice(dev);
 
     // Last two bytes are elapsed seconds, encoded using S-Link's power-of-4 scheme
     // byte[10] = tens of seconds (0-5), byte[11] = ones of seconds (0-9)
@@ -442,182 +579,63 @@ void SlinkDecoder::_handleTimeStatusFrame(const uint8_t* bytes, int len) {
     uint8_t secOnesCode = bytes[11];
 
     // Decode using power-of-4
-    int secTens = _decodeTimeValue(secTensCode);
-    int secOnes = _decodeTimeValue(secOnesCode);
+    int secTens = SlinkCodec::decodeTimeValue(secTensCode);
+    int secOnes = SlinkCodec::decodeTimeValue(secOnesCode);
     int seconds = secTens * 10 + secOnes;
 
-    // Minutes might be in bytes 8-9? Check what's there
-    // For now, just track seconds within the minute
+    // Bytes 8-9 are the elapsed minutes, tens and ones, in the same encoding
     uint8_t minTensCode = bytes[8];
     uint8_t minOnesCode = bytes[9];
-    int minTens = _decodeTimeValue(minTensCode);
-    int minOnes = _decodeTimeValue(minOnesCode);
+    int minTens = SlinkCodec::decodeTimeValue(minTensCode);
+    int minOnes = SlinkCodec::decodeTimeValue(minOnesCode);
     int minutes = minTens * 10 + minOnes;
 
-    // Suppress unused variable warnings - time data decoded but not logged
-    (void)player;
-    (void)minutes;
-    (void)seconds;
-
-    // Time frames are only available from Command Mode 3 device when playing.
-    // Not useful for display since we can't get time from Mode 1 player.
-    // Data is decoded above if needed in the future.
+    // Time frames are only available from Command Mode 3 device when playing
+    _events.time.emit(SlinkTimeEvent{_busId, player, dev, minutes, seconds});
+    return true;
 }
 
 // Extended status frames: 14 bytes, 41 XX 15 00 ...
 // These appear periodically (every few seconds) and indicate disc is loaded
 // Frame: 41 [DEV] 15 00 [10 bytes payload]
 // Example: 41 51 15 00 00 00 50 00 00 00 00 01 00 00 (Player 2 high-range, disc 201)
-void SlinkDecoder::_handleExtendedStatusFrame(const uint8_t* bytes, int len) {
-    if (len != 14) return;
-    if (bytes[0] != 0x41) return;
-    if (bytes[2] != 0x15 || bytes[3] != 0x00) return;
-
+bool SlinkDecoder::_handleExtendedStatusFrame(const uint8_t* bytes, int) {
     uint8_t dev = bytes[1];
 
     // Determine player from device code
-    int player = 0;
-    bool highRange = false;
-
-    if (dev == 0x40) {
-        player = 1;
-        highRange = false;
-    } else if (dev == 0x45) {
-        player = 1;
-        highRange = true;
-    } else if (dev == 0x44) {
-        player = 2;
-        highRange = false;
-    } else if (dev == 0x51) {
-        player = 2;
-        highRange = true;
-    }
-
-    // Suppress unused variable warnings - data decoded but not logged
-    (void)player;
-    (void)highRange;
+    int player = SlinkDevices::playerForDevice(dev);
+    bool highRange = SlinkDevices::isHighRange(dev);
 
     // EXT14 frames only come from Command Mode 3 device and show its loaded disc.
-    // Not useful for system-wide display. Data is decoded above if needed.
+    // Byte 11 holds the disc in TX encoding for the device's range.
+    int disc = SlinkCodec::decodeDiscByte(bytes[11], highRange);
+    if (player && disc > 0) {
+        _events.loaded.emit(SlinkLoadedDiscEvent{_busId, player, disc});
+    }
+    return true;
 }
 
 // Heartbeat frames: 41 04 00 55
 // These appear periodically (every few seconds) from Command Mode 3 device
-void SlinkDecoder::_handleHeartbeatFrame(const uint8_t* bytes, int len) {
-    if (len != 4) return;
-    if (bytes[0] != 0x41 || bytes[1] != 0x04 || bytes[2] != 0x00 || bytes[3] != 0x55) return;
-
-    // Heartbeat only comes from Command Mode 3 device.
-    // Could be used to detect if that player is powered on.
+bool SlinkDecoder::_handleHeartbeatFrame(const uint8_t* bytes, int) {
+    // Heartbeat only comes from Command Mode 3 device. Presence tracking
+    // picks it up through the activity event.
     // Not logging since it's frequent and not useful for display.
+    _events.heartbeat.emit(SlinkHeartbeatEvent{_busId, bytes[1]});
+    return true;
 }
 
-// Log all frames that don't match known patterns
+// Log frames no rule claimed
 void SlinkDecoder::_handleOtherFrame(const uint8_t* bytes, int len) {
-    // Skip known frame types:
-    // - Transport: 4 bytes, 41 40 00 XX
-    // - Track status: 12 bytes, 41 XX 11 00 ...
-    // - Time status: 12 bytes, 41 XX 11 01 ...
-    // - Extended status: 14 bytes, 41 XX 15 00 ...
-    // - Heartbeat: 4 bytes, 41 04 00 55
-
-    bool isTransport = (len == 4 && bytes[0] == 0x41 && (bytes[1] == 0x40 || bytes[1] == 0x44) && bytes[2] == 0x00);
-    bool isTrackStatus = (len == 12 && bytes[0] == 0x41 && bytes[2] == 0x11 && bytes[3] == 0x00);
-    bool isTimeStatus = (len == 12 && bytes[0] == 0x41 && bytes[2] == 0x11 && bytes[3] == 0x01);
-    bool isExtendedStatus = (len == 14 && bytes[0] == 0x41 && bytes[2] == 0x15 && bytes[3] == 0x00);
-    bool isHeartbeat = (len == 4 && bytes[0] == 0x41 && bytes[1] == 0x04 && bytes[2] == 0x00 && bytes[3] == 0x55);
-
-    if (!isTransport && !isTrackStatus && !isTimeStatus && !isExtendedStatus && !isHeartbeat) {
-        Serial.print(F("[OTHER] len="));
-        Serial.print(len);
-        Serial.print(F(" data: "));
-        for (int i = 0; i < len; ++i) {
-            if (bytes[i] < 0x10) Serial.print('0');
-            Serial.print(bytes[i], HEX);
-            if (i < len - 1) Serial.print(' ');
-        }
-        Serial.println();
-    }
-}
-
-// ---------------- Encoding/decoding helpers ----------------
-
-// encodeIndex: given index n, compute 16-bit "power-of-4" representation we see on bus
-uint16_t SlinkDecoder::_encodeIndex(uint16_t n) {
-    uint16_t code = 0;
-    uint16_t bitPos = 0;
-    uint16_t temp = n;
-
-    while (temp) {
-        if (temp & 1) {
-            uint16_t pow4 = 1;
-            for (uint16_t i = 0; i < bitPos; ++i) {
-                pow4 *= 4;
-            }
-            code += pow4;
-        }
-        temp >>= 1;
-        bitPos++;
-    }
-    return code;
-}
-
-int SlinkDecoder::_decodeIndexFromCode(uint16_t code, uint16_t maxIndex) {
-    for (uint16_t idx = 1; idx <= maxIndex; ++idx) {
-        if (_encodeIndex(idx) == code) {
-            return (int)idx;
-        }
-    }
-    return -1;
-}
-
-// Decode time value from S-Link's power-of-4 encoding (same as index encoding)
-// 0x00=0, 0x01=1, 0x04=2, 0x05=3, 0x10=4, 0x11=5, 0x14=6, 0x15=7, 0x40=8, 0x41=9, etc.
-int SlinkDecoder::_decodeTimeValue(uint8_t code) {
-    // Reverse the power-of-4 encoding: extract pairs of bits
-    // Bit positions: 76 54 32 10 -> each pair is 0-3, representing binary digits
-    int value = 0;
-    value += (code & 0x03);              // bits 1:0 -> ones place (0-3)
-    value += ((code >> 2) & 0x03) * 2;   // bits 3:2 -> twos place (0,2,4,6)
-    value += ((code >> 4) & 0x03) * 4;   // bits 5:4 -> fours place (0,4,8,12)
-    value += ((code >> 6) & 0x03) * 8;   // bits 7:6 -> eights place (0,8,16,24)
-    return value;
-}
-
-// Track numbers: 1..99 with index = n + 6 * floor(n / 10)
-int SlinkDecoder::_decodeTrackNumberFromIndex(int idx) {
-    for (int n = 1; n <= 99; ++n) {
-        if (n + 6 * (n / 10) == idx) {
-            return n;
-        }
-    }
-    return -1;
-}
-
-// Disc numbers 1..200 (dev=0x40)
-//  1..99:   idx = n + 6 * floor(n / 10)
-// 100..200: idx = n + 54
-int SlinkDecoder::_decodeDiscNumber_1to200_FromIndex(int idx) {
-    if (idx <= 153) {
-        for (int n = 1; n <= 99; ++n) {
-            if (n + 6 * (n / 10) == idx) {
-                return n;
-            }
-        }
-    } else {
-        int n = idx - 54;
-        if (n >= 100 && n <= 200) {
-            return n;
-        }
+    Log.print(F("[OTHER] len="));
+    Log.print(len);
+    Log.print(F(" data: "));
+    for (int i = 0; i < len; ++i) {
+        if (bytes[i] < 0x10) Log.print('0');
+        Log.print(bytes[i], HEX);
+        if (i < len - 1) Log.print(' ');
     }
-    return -1;
-}
+    Log.println();
 
-// Disc numbers 201..300 (dev=0x45):
-//  idx = 1..100, DiscNumber = idx + 200
-int SlinkDecoder::_decodeDiscNumber_201to300_FromIndex(int idx) {
-    if (idx >= 1 && idx <= 100) {
-        return idx + 200;
-    }
-    return -1;
+    _events.unknown.emit(SlinkUnknownFrameEvent{bytes, len});
 }
@@ -0,0 +1,251 @@
+#include "SlinkDiscovery.h"
+#include "SlinkTx.h"
+
+static Print& Log = SlinkHal::log();
+
+SlinkDiscovery::SlinkDiscovery(SlinkTx& tx, int bus)
+: _tx(tx), _bus(bus) {
+}
+
+bool SlinkDiscovery::startDevices(uint8_t first, uint8_t last, uint8_t cmd, unsigned long stepMs) {
+    return _start(DEVICES, cmd, first, last, stepMs);
+}
+
+bool SlinkDiscovery::startCommands(uint8_t device, uint8_t first, uint8_t last, unsigned long stepMs) {
+    return _start(COMMANDS, device, first, last, stepMs);
+}
+
+bool SlinkDiscovery::_start(Mode mode, uint8_t fixed, uint8_t first, uint8_t last, unsigned long stepMs) {
+    if (active() || last < first) return false;
+    _mode = mode;
+    _fixed = fixed;
+    _first = first;
+    _count = last - first + 1;
+    _next = 0;
+    _current = -1;
+    _stepMs = stepMs;
+    memset(_probes, 0, sizeof(_probes));
+    _responseCount = 0;
+    _dropped = 0;
+    _ambientCount = 0;
+    _last = -1;
+    _lastProbe = -1;
+    _phase = BASELINE;
+    _phaseMs = SlinkHal::nowMillis();
+
+    Log.print(F("[DISCOVERY] Bus "));
+    Log.print(_bus);
+    Log.print(F(": "));
+    Log.print(_count);
+    Log.print(mode == DEVICES ? F(" device codes, ") : F(" command codes, "));
+    Log.print(stepMs);
+    Log.println(F(" ms apart; listening to the bus first"));
+    return true;
+}
+
+void SlinkDiscovery::stop() {
+    if (!active()) return;
+    Log.println(F("[DISCOVERY] Stopped"));
+    _finish();
+}
+
+// Length and bytes 1-3: which device, frame type and (for 4-byte frames)
+// the code
+uint32_t SlinkDiscovery::_kind(const uint8_t* bytes, int len) {
+    return (uint32_t)len << 24 |
+           (uint32_t)(len > 1 ? bytes[1] : 0) << 16 |
+           (uint32_t)(len > 2 ? bytes[2] : 0) << 8 |
+           (uint32_t)(len > 3 ? bytes[3] : 0);
+}
+
+bool SlinkDiscovery::_isAmbient(uint32_t kind) const {
+    for (int i = 0; i < _ambientCount; ++i) {
+        if (_ambient[i] == kind) return true;
+    }
+    return false;
+}
+
+void SlinkDiscovery::onTraffic(const SlinkTrafficEvent& ev) {
+    _last = -1;
+    _lastProbe = -1;
+    if (_phase == IDLE || ev.ours) return;
+
+    uint32_t kind = _kind(ev.bytes, ev.len);
+    if (_phase == BASELINE) {
+        if (!_isAmbient(kind) && _ambientCount < MAX_AMBIENT) _ambient[_ambientCount++] = kind;
+        return;
+    }
+    // Started before our first probe got out
+    if (_current < 0 || (long)(ev.startUs - _currentUs) < 0) return;
+
+    Probe& p = _probes[_current];
+    if (_isAmbient(kind)) {
+        if (p.ambient < 0xFF) p.ambient++;
+        return;
+    }
+    if (p.responses < 0xFF) p.responses++;
+    _lastProbe = _current;
+    if (_responseCount == MAX_RESPONSES) {
+        _dropped++;
+        return;
+    }
+
+    Response& r = _responses[_responseCount];
+    r.probe = (uint8_t)_current;
+    r.len = (uint8_t)(ev.len < (int)sizeof(r.bytes) ? ev.len : sizeof(r.bytes));
+    memcpy(r.bytes, ev.bytes, r.len);
+    r.unknown = false;
+    unsigned long ms = (ev.startUs - _currentUs) / 1000;
+    r.afterMs = (uint16_t)(ms > 0xFFFF ? 0xFFFF : ms);
+    _last = _responseCount++;
+
+    Log.print(F("[DISCOVERY] dev=0x"));
+    Log.print(device(_current), HEX);
+    Log.print(F(" cmd=0x"));
+    Log.print(command(_current), HEX);
+    Log.print(F(" -> +"));
+    Log.print(r.afterMs);
+    Log.print(F(" ms len="));
+    Log.println(ev.len);
+}
+
+// Comes right after the traffic event for the same frame
+void SlinkDiscovery::onUnknown(const SlinkUnknownFrameEvent&) {
+    if (_phase == IDLE || _lastProbe < 0) return;
+    Probe& p = _probes[_lastProbe];
+    if (p.unknown < 0xFF) p.unknown++;
+    if (_last >= 0) _responses[_last].unknown = true;
+}
+
+void SlinkDiscovery::_onSent(void* ctx, const SlinkTxCompletion& c) {
+    SlinkDiscovery* self = static_cast<SlinkDiscovery*>(ctx);
+    int probe = self->_next - 1;
+    if (!self->active() || probe < 0 || self->_probes[probe].state != PROBE_QUEUED) return;
+    if (!c.sent) {
+        self->_probes[probe].state = PROBE_NOT_SENT;
+        return;
+    }
+    self->_probes[probe].state = PROBE_SENT;
+    self->_current = probe;
+    self->_currentUs = c.startUs;
+}
+
+void SlinkDiscovery::_probe() {
+    int probe = _next++;
+    uint8_t bytes[2] = {device(probe), command(probe)};
+    _probes[probe].state = PROBE_QUEUED;
+    _phaseMs = SlinkHal::nowMillis();
+    if (!_tx.sendAsync(bytes, 2, _onSent, this)) {
+        _probes[probe].state = PROBE_NOT_SENT;
+    }
+}
+
+void SlinkDiscovery::loop() {
+    if (_phase == IDLE) return;
+    unsigned long now = SlinkHal::nowMillis();
+    if (now - _phaseMs < (_phase == BASELINE ? BASELINE_MS : _stepMs)) return;
+
+    switch (_phase) {
+        case BASELINE:
+            Log.print(F("[DISCOVERY] "));
+            Log.print(_ambientCount);
+            Log.println(F(" kinds of frame on the bus already, probing"));
+            _phase = PROBING;
+            _probe();
+            break;
+        case PROBING:
+            // Still waiting for the line: keep the step from its start
+            if (_probes[_next - 1].state == PROBE_QUEUED) return;
+            if (_next < _count) {
+                _probe();
+            } else {
+                _phase = DRAINING;
+                _phaseMs = now;
+            }
+            break;
+        case DRAINING:
+            _finish();
+            break;
+        default:
+            break;
+    }
+}
+
+void SlinkDiscovery::_finish() {
+    _phase = IDLE;
+    int answered = 0;
+    for (int i = 0; i < _next; ++i) answered += _probes[i].responses > 0;
+    Log.print(F("[DISCOVERY] Done: "));
+    Log.print(_next);
+    Log.print(F(" probes, "));
+    Log.print(answered);
+    Log.print(F(" answered, "));
+    Log.print(_responseCount + (int)_dropped);
+    Log.println(F(" frames ('scanres' for the table)"));
+}
+
+void SlinkDiscovery::printReport(Print& out) const {
+    static const char* const PHASES[] = {"idle", "baseline", "probing", "draining"};
+    out.print(F("  "));
+    out.print(PHASES[_phase]);
+    out.print(F(", probe "));
+    out.print(_next);
+    out.print('/');
+    out.print(_count);
+    out.print(F(", "));
+    out.print(_responseCount);
+    out.print(F(" responses ("));
+    out.print(_dropped);
+    out.print(F(" not kept), "));
+    out.print(_ambientCount);
+    out.println(F(" ambient kinds"));
+}
+
+static void printHex(Print& out, uint8_t b) {
+    if (b < 0x10) out.print('0');
+    out.print(b, HEX);
+}
+
+void SlinkDiscovery::printResults(Print& out) const {
+    static const char* const STATES[] = {"pending", "queued", "sent", "not-sent"};
+    out.println(F("bus,device,cmd,state,after_ms,unknown,ambient,frame"));
+    int r = 0;
+    for (int i = 0; i < _next; ++i) {
+        const Probe& p = _probes[i];
+        bool any = false;
+        for (; r < _responseCount && _responses[r].probe == i; ++r) {
+            const Response& resp = _responses[r];
+            out.print(_bus);
+            out.print(F(",0x"));
+            printHex(out, device(i));
+            out.print(F(",0x"));
+            printHex(out, command(i));
+            out.print(',');
+            out.print(STATES[p.state]);
+            out.print(',');
+            out.print(resp.afterMs);
+            out.print(',');
+            out.print(resp.unknown ? 1 : 0);
+            out.print(',');
+            out.print(p.ambient);
+            out.print(',');
+            for (int b = 0; b < resp.len; ++b) {
+                if (b) out.print(' ');
+                printHex(out, resp.bytes[b]);
+            }
+            out.println();
+            any = true;
+        }
+        if (any) continue;
+        out.print(_bus);
+        out.print(F(",0x"));
+        printHex(out, device(i));
+        out.print(F(",0x"));
+        printHex(out, command(i));
+        out.print(',');
+        out.print(STATES[p.state]);
+        out.print(F(",,,"));
+        out.print(p.ambient);
+        out.println(p.responses ? F(",(not kept)") : F(","));
+    }
+}
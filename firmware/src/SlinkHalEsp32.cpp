@@ -0,0 +1,368 @@
+#ifdef ARDUINO
+
+#include "SlinkHal.h"
+
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <ESPmDNS.h>
+#include <Preferences.h>
+
+namespace SlinkHal {
+
+static uint32_t _packIp(const IPAddress& ip) {
+    return (uint32_t(ip[0]) << 24) | (uint32_t(ip[1]) << 16) |
+           (uint32_t(ip[2]) << 8)  |  uint32_t(ip[3]);
+}
+
+// ---------------- Clock ----------------
+
+unsigned long nowMicros() {
+    return micros();
+}
+
+unsigned long nowMillis() {
+    return millis();
+}
+
+// ---------------- GPIO / timing ----------------
+
+void pinOutput(int pin) {
+    pinMode(pin, OUTPUT);
+}
+
+void pinWrite(int pin, bool high) {
+    digitalWrite(pin, high ? HIGH : LOW);
+}
+
+void delayMicros(unsigned long us) {
+    delayMicroseconds(us);
+}
+
+void delayMillis(unsigned long ms) {
+    delay(ms);
+}
+
+// ---------------- Tasks ----------------
+
+bool startTask(void (*fn)(void*), void* arg, const char* name,
+               uint32_t stackBytes, int priority, int core) {
+    BaseType_t affinity = core < 0 ? tskNO_AFFINITY : (BaseType_t)core;
+    return xTaskCreatePinnedToCore(fn, name, stackBytes, arg, priority, nullptr, affinity) == pdPASS;
+}
+
+// ---------------- RMT RX ----------------
+
+bool RmtRx::begin(int rxPin, rmt_channel_t channel, const RmtRxConfig& cfg) {
+    _channel = channel;
+
+    rmt_config_t rxConfig = RMT_DEFAULT_CONFIG_RX((gpio_num_t)rxPin, channel);
+    rxConfig.clk_div = cfg.clkDiv;
+    rxConfig.mem_block_num = cfg.memBlocks;
+    rxConfig.rx_config.idle_threshold = cfg.idleThreshold;
+    rxConfig.rx_config.filter_en = cfg.filterTicks > 0;
+    rxConfig.rx_config.filter_ticks_thresh = cfg.filterTicks;
+    rxConfig.flags = 0;
+
+    esp_err_t err = rmt_config(&rxConfig);
+    if (err != ESP_OK) {
+        Serial.print(F("[HAL] RMT config failed: "));
+        Serial.println(err);
+        return false;
+    }
+
+    err = rmt_driver_install(channel, cfg.ringBufferBytes, 0);
+    if (err != ESP_OK) {
+        Serial.print(F("[HAL] RMT driver install failed: "));
+        Serial.println(err);
+        return false;
+    }
+
+    err = rmt_rx_start(channel, true);
+    if (err != ESP_OK) {
+        Serial.print(F("[HAL] RMT rx start failed: "));
+        Serial.println(err);
+        return false;
+    }
+
+    RingbufHandle_t rb = nullptr;
+    rmt_get_ringbuf_handle(channel, &rb);
+    _ringbuf = rb;
+    return _ringbuf != nullptr;
+}
+
+rmt_item32_t* RmtRx::receive(size_t* numItems, uint32_t timeoutMs) {
+    *numItems = 0;
+    if (!_ringbuf) return nullptr;
+
+    size_t rxSize = 0;
+    rmt_item32_t* items = (rmt_item32_t*)xRingbufferReceive(
+        (RingbufHandle_t)_ringbuf, &rxSize, pdMS_TO_TICKS(timeoutMs));
+    if (!items) return nullptr;
+
+    *numItems = rxSize / sizeof(rmt_item32_t);
+    return items;
+}
+
+void RmtRx::release(rmt_item32_t* items) {
+    if (_ringbuf && items) {
+        vRingbufferReturnItem((RingbufHandle_t)_ringbuf, (void*)items);
+    }
+}
+
+// ---------------- RMT TX ----------------
+
+// The driver has one TX-end callback for all channels; dispatch per channel
+struct TxDoneHandler {
+    RmtTxDone fn;
+    void*     arg;
+};
+static TxDoneHandler _txDone[RMT_CHANNEL_MAX];
+
+static void IRAM_ATTR _txEndIsr(rmt_channel_t channel, void* arg) {
+    (void)arg;
+    if (_txDone[channel].fn) {
+        _txDone[channel].fn(_txDone[channel].arg);
+    }
+}
+
+bool RmtTx::begin(int txPin, rmt_channel_t channel, const RmtTxConfig& cfg,
+                  RmtTxDone onDone, void* arg) {
+    _channel = channel;
+    _pin = txPin;
+
+    rmt_config_t txConfig = RMT_DEFAULT_CONFIG_TX((gpio_num_t)txPin, channel);
+    txConfig.clk_div = cfg.clkDiv;
+    txConfig.mem_block_num = cfg.memBlocks;
+    txConfig.tx_config.carrier_en = false;
+    txConfig.tx_config.idle_output_en = true;
+    txConfig.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+
+    esp_err_t err = rmt_config(&txConfig);
+    if (err != ESP_OK) {
+        Serial.print(F("[HAL] RMT TX config failed: "));
+        Serial.println(err);
+        return false;
+    }
+    err = rmt_driver_install(channel, 0, 0);
+    if (err != ESP_OK) {
+        Serial.print(F("[HAL] RMT TX driver install failed: "));
+        Serial.println(err);
+        return false;
+    }
+
+    _txDone[channel] = TxDoneHandler{onDone, arg};
+    rmt_register_tx_end_callback(_txEndIsr, nullptr);
+    return true;
+}
+
+bool RmtTx::write(const rmt_item32_t* items, size_t numItems) {
+    if (rmt_wait_tx_done(_channel, 0) != ESP_OK) {
+        return false;
+    }
+    return rmt_write_items(_channel, items, numItems, false) == ESP_OK;
+}
+
+bool RmtTx::waitDone(uint32_t timeoutMs) {
+    return rmt_wait_tx_done(_channel, pdMS_TO_TICKS(timeoutMs)) == ESP_OK;
+}
+
+// ---------------- GPIO edge capture ----------------
+
+// Hardware timer used as the edge capture idle detector
+static const uint8_t EDGE_IDLE_TIMER = 1;
+
+static EdgeIsr     _edgeFn = nullptr;
+static IdleIsr     _idleFn = nullptr;
+static void*       _edgeArg = nullptr;
+static int         _edgePin = -1;
+static hw_timer_t* _idleTimer = nullptr;
+
+// Line monitors by pin; edge capture on the same pin feeds its monitor
+static const int MONITOR_PINS = 40;
+static LineMonitor* _lineMonitors[MONITOR_PINS] = {};
+
+static void IRAM_ATTR _edgeIsr() {
+    unsigned long us = micros();
+    _edgeFn(_edgeArg, us);
+    if (LineMonitor* m = _lineMonitors[_edgePin]) m->edge(us);
+    timerWrite(_idleTimer, 0);
+    timerAlarmEnable(_idleTimer);
+}
+
+static void IRAM_ATTR _idleIsr() {
+    timerAlarmDisable(_idleTimer);
+    _idleFn(_edgeArg);
+}
+
+bool edgeCaptureBegin(int pin, uint32_t idleUs, EdgeIsr onEdge, IdleIsr onIdle, void* arg) {
+    if (_edgeFn || !onEdge || !onIdle) return false;
+
+    _idleTimer = timerBegin(EDGE_IDLE_TIMER, 80, true);   // 1µs ticks
+    if (!_idleTimer) {
+        Serial.println(F("[HAL] Edge capture timer unavailable"));
+        return false;
+    }
+    _edgeFn = onEdge;
+    _idleFn = onIdle;
+    _edgeArg = arg;
+    _edgePin = pin;
+
+    timerAttachInterrupt(_idleTimer, _idleIsr, true);
+    timerAlarmWrite(_idleTimer, idleUs, false);
+
+    pinMode(pin, INPUT);
+    attachInterrupt(digitalPinToInterrupt(pin), _edgeIsr, CHANGE);
+    return true;
+}
+
+// ---------------- Line activity ----------------
+
+static void IRAM_ATTR _lineIsr(void* arg) {
+    static_cast<LineMonitor*>(arg)->edge(micros());
+}
+
+bool LineMonitor::begin(int pin) {
+    if (pin < 0 || pin >= MONITOR_PINS) return false;
+    _pin = pin;
+    _lineMonitors[pin] = this;
+    if (pin != _edgePin) {
+        pinMode(pin, INPUT);
+        attachInterruptArg(digitalPinToInterrupt(pin), _lineIsr, this, CHANGE);
+    }
+    return true;
+}
+
+// RX transistor inverts: a mark on the line reads high
+bool LineMonitor::mark() const {
+    return digitalRead(_pin) == HIGH;
+}
+
+unsigned long LineMonitor::lastEdgeUs() const {
+    uint32_t n = _edges;
+    return n ? _history[(n - 1) % HISTORY] : 0;
+}
+
+uint32_t LineMonitor::edgesBetween(unsigned long fromUs, unsigned long toUs) const {
+    uint32_t n = _edges;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < n && i < (uint32_t)HISTORY; ++i) {
+        unsigned long t = _history[(n - 1 - i) % HISTORY];
+        if ((long)(t - fromUs) <= 0) break;
+        if ((long)(t - toUs) <= 0) count++;
+    }
+    return count;
+}
+
+void IRAM_ATTR LineMonitor::edge(unsigned long us) {
+    _history[_edges % HISTORY] = us;
+    _edges = _edges + 1;
+}
+
+// ---------------- Network ----------------
+
+bool netBegin(const char* ssid, const char* password, unsigned long timeoutMs) {
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(ssid, password);
+
+    unsigned long start = millis();
+    while (WiFi.status() != WL_CONNECTED && millis() - start < timeoutMs) {
+        delay(500);
+        Serial.print(".");
+    }
+    Serial.println();
+
+    return WiFi.status() == WL_CONNECTED;
+}
+
+bool netConnected() {
+    return WiFi.status() == WL_CONNECTED;
+}
+
+void netReconnect() {
+    WiFi.reconnect();
+}
+
+uint32_t netLocalIp() {
+    return _packIp(WiFi.localIP());
+}
+
+bool mdnsBegin(const char* hostname) {
+    return MDNS.begin(hostname);
+}
+
+int mdnsQueryService(const char* service, const char* proto, uint32_t* ip, int* port) {
+    int n = MDNS.queryService(service, proto);
+    if (n > 0) {
+        *ip = _packIp(MDNS.IP(0));
+        *port = MDNS.port(0);
+    }
+    return n;
+}
+
+uint32_t mdnsQueryHost(const char* hostname, unsigned long timeoutMs) {
+    IPAddress ip = MDNS.queryHost(hostname, timeoutMs);
+    if (ip == INADDR_NONE) return 0;
+    return _packIp(ip);
+}
+
+int httpPost(const char* url, const char* json, unsigned long timeoutMs) {
+    HTTPClient http;
+
+    http.begin(url);
+    http.addHeader("Content-Type", "application/json");
+    http.addHeader("Connection", "close");  // Ensure connection is closed properly
+    http.setTimeout(timeoutMs);
+    http.setReuse(false);   // Don't reuse connection (helps with socket cleanup)
+
+    int httpCode = http.POST(json);
+    http.end();
+    return httpCode;
+}
+
+int httpGet(const char* url, char* response, size_t maxLen, unsigned long timeoutMs) {
+    HTTPClient http;
+
+    http.begin(url);
+    http.addHeader("Connection", "close");  // Ensure connection is closed properly
+    http.setTimeout(timeoutMs);
+    http.setReuse(false);   // Don't reuse connection (helps with socket cleanup)
+
+    int httpCode = http.GET();
+    if (httpCode == HTTP_CODE_OK) {
+        String payload = http.getString();
+        strncpy(response, payload.c_str(), maxLen - 1);
+        response[maxLen - 1] = '\0';
+    }
+    http.end();
+    return httpCode;
+}
+
+// ---------------- Persistent storage ----------------
+
+static const char* STORE_NAMESPACE = "slink";
+
+bool storeLoad(const char* key, void* data, size_t len) {
+    Preferences prefs;
+    if (!prefs.begin(STORE_NAMESPACE, true)) return false;
+    bool ok = prefs.getBytesLength(key) == len && prefs.getBytes(key, data, len) == len;
+    prefs.end();
+    return ok;
+}
+
+bool storeSave(const char* key, const void* data, size_t len) {
+    Preferences prefs;
+    if (!prefs.begin(STORE_NAMESPACE, false)) return false;
+    bool ok = prefs.putBytes(key, data, len) == len;
+    prefs.end();
+    return ok;
+}
+
+// ---------------- Log ----------------
+
+Print& log() {
+    return Serial;
+}
+
+}  // namespace SlinkHal
+
+#endif  // ARDUINO
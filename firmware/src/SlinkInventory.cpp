@@ -0,0 +1,76 @@
+#include "SlinkInventory.h"
+
+static Print& Log = SlinkHal::log();
+
+SlinkInventory::SlinkInventory(int bus)
+: _bus(bus) {
+}
+
+void SlinkInventory::onLoaded(const SlinkLoadedDiscEvent& ev) {
+    setSlot(ev.player, ev.disc, true);
+}
+
+void SlinkInventory::onStatus(const SlinkTrackStatus& st) {
+    if (st.haveStatus) {
+        setSlot(st.player, st.discNumber, true);
+    }
+}
+
+void SlinkInventory::setSlot(int player, int disc, bool loaded) {
+    if (!SlinkDevices::isValidPlayer(player) || disc < 1 || disc > SLOTS) return;
+    if (slot(player, disc) == (loaded ? LOADED : EMPTY)) return;
+
+    Player& p = _players[player - 1];
+    int byte = (disc - 1) / 8;
+    uint8_t bit = (uint8_t)(1u << ((disc - 1) % 8));
+    p.known[byte] |= bit;
+    if (loaded) p.loaded[byte] |= bit;
+    else        p.loaded[byte] &= (uint8_t)~bit;
+    p.dirty = true;
+
+    Log.print(F("[INVENTORY] Bus="));
+    Log.print(_bus);
+    Log.print(F(" Player="));
+    Log.print(player);
+    Log.print(F(" Slot="));
+    Log.print(disc);
+    Log.println(loaded ? F(" loaded") : F(" empty"));
+}
+
+SlinkInventory::Slot SlinkInventory::slot(int player, int disc) const {
+    if (!SlinkDevices::isValidPlayer(player) || disc < 1 || disc > SLOTS) return UNKNOWN;
+    const Player& p = _players[player - 1];
+    int byte = (disc - 1) / 8;
+    uint8_t bit = (uint8_t)(1u << ((disc - 1) % 8));
+    if (!(p.known[byte] & bit)) return UNKNOWN;
+    return (p.loaded[byte] & bit) ? LOADED : EMPTY;
+}
+
+int SlinkInventory::count(int player, Slot s) const {
+    const Player& p = _players[player - 1];
+    int known = 0;
+    int loaded = 0;
+    for (int i = 0; i < BITSET_BYTES; ++i) {
+        known += __builtin_popcount(p.known[i]);
+        loaded += __builtin_popcount(p.loaded[i]);
+    }
+    switch (s) {
+        case LOADED: return loaded;
+        case EMPTY:  return known - loaded;
+        default:     return SLOTS - known;
+    }
+}
+
+void SlinkInventory::printReport(Print& out) const {
+    for (int player = 1; player <= SLINK_MAX_PLAYERS; ++player) {
+        out.print(F("  Player "));
+        out.print(player);
+        out.print(F(": loaded="));
+        out.print(count(player, LOADED));
+        out.print(F(" empty="));
+        out.print(count(player, EMPTY));
+        out.print(F(" unknown="));
+        out.print(count(player, UNKNOWN));
+        out.println(dirty(player) ? F(" (not synced)") : F(""));
+    }
+}
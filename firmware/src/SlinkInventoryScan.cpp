@@ -0,0 +1,293 @@
+#include "SlinkInventoryScan.h"
+#include "SlinkDecoder.h"
+#include "SlinkTx.h"
+#include "SlinkInventory.h"
+#include "SlinkSeekProfile.h"
+
+static Print& Log = SlinkHal::log();
+
+SlinkInventoryScan::SlinkInventoryScan(SlinkTx& tx, const SlinkDecoder& decoder, SlinkInventory& inventory,
+                                       const SlinkSeekProfile& seek, int bus)
+: _tx(tx), _decoder(decoder), _inventory(inventory), _seek(seek), _bus(bus) {
+    snprintf(_key, sizeof(_key), "scan%d", bus);
+    for (Player& p : _players) {
+        p = Player{};
+        p.next = 1;
+        p.sent = 1;
+    }
+    memset(_results, 0, sizeof(_results));
+}
+
+void SlinkInventoryScan::begin() {
+    // Too big for the loop task's stack
+    static Stored stored;
+    if (!SlinkHal::storeLoad(_key, &stored, sizeof(stored)) || stored.magic != STORE_MAGIC) return;
+
+    for (int i = 0; i < SLINK_MAX_PLAYERS; ++i) {
+        _players[i].next = stored.next[i];
+        _players[i].sent = stored.sent[i];
+        _players[i].elapsedMs = stored.elapsedMs[i];
+    }
+    memcpy(_results, stored.results, sizeof(_results));
+    _interrupted = stored.scanning;
+
+    if (_interrupted) {
+        Log.print(F("[SCAN] Bus "));
+        Log.print(_bus);
+        Log.print(F(": interrupted scan saved at"));
+        for (int player = 1; player <= SLINK_MAX_PLAYERS; ++player) {
+            if (!(_interrupted & (1u << (player - 1)))) continue;
+            Log.print(F(" P"));
+            Log.print(player);
+            Log.print(F(" slot "));
+            Log.print(next(player));
+        }
+        Log.println();
+    }
+}
+
+bool SlinkInventoryScan::start(uint8_t players, bool resume) {
+    bool any = false;
+    unsigned long now = SlinkHal::nowMillis();
+    for (int player = 1; player <= SLINK_MAX_PLAYERS; ++player) {
+        if (!(players & (1u << (player - 1)))) continue;
+        Player& p = _players[player - 1];
+        if (resume) {
+            if (p.next > SLOTS) continue;
+            // What was found so far is still there
+            for (int disc = 1; disc < p.next; ++disc) {
+                uint8_t s = _results[player - 1][disc - 1].state;
+                if (s != SlinkInventory::UNKNOWN) _inventory.setSlot(player, disc, s == SlinkInventory::LOADED);
+            }
+        } else {
+            memset(_results[player - 1], 0, sizeof(_results[player - 1]));
+            p.next = 1;
+            p.sent = 1;
+            p.elapsedMs = 0;
+        }
+        p.scanning = true;
+        p.waiting = false;
+        p.unsaved = 0;
+        p.startMs = now;
+        any = true;
+
+        Log.print(F("[SCAN] Player "));
+        Log.print(player);
+        Log.print(resume && p.next > 1 ? F(": resuming at slot ") : F(": scanning from slot "));
+        Log.println(p.next);
+    }
+    _interrupted = 0;
+    if (any) _save();
+    return any;
+}
+
+void SlinkInventoryScan::stop() {
+    for (int player = 1; player <= SLINK_MAX_PLAYERS; ++player) {
+        if (_players[player - 1].scanning) _end(player, false);
+    }
+}
+
+bool SlinkInventoryScan::active() const {
+    for (const Player& p : _players) {
+        if (p.scanning) return true;
+    }
+    return false;
+}
+
+bool SlinkInventoryScan::resumable() const {
+    if (_interrupted) return true;
+    for (const Player& p : _players) {
+        if (!p.scanning && p.next > 1 && p.next <= SLOTS) return true;
+    }
+    return false;
+}
+
+void SlinkInventoryScan::_send(int player) {
+    Player& p = _players[player - 1];
+    if (!p.waiting) {
+        // Where the carousel is: on the slot before, once the scan has moved it
+        const Result& prev = _results[player - 1][p.next - 2 < 0 ? 0 : p.next - 2];
+        p.from = (int16_t)(p.next > 1 && prev.state != SlinkInventory::UNKNOWN
+                           ? p.next - 1 : _decoder.state(player).discNumber);
+        p.waiting = true;
+        p.attempts = 0;
+    }
+    p.heard = false;
+    p.attempts++;
+    p.sentMs = SlinkHal::nowMillis();
+
+    uint32_t predicted = _seek.predictMs(player, p.from, p.next);
+    p.deadlineMs = p.sentMs + (predicted ? predicted + DEADLINE_MARGIN_MS : DEADLINE_MS);
+
+    if (!_tx.playDisc(player, p.next, 1)) {
+        Log.print(F("[SCAN] Player "));
+        Log.print(player);
+        Log.println(F(": play disc not sent, scan stopped"));
+        _end(player, false);
+    }
+}
+
+void SlinkInventoryScan::_record(int player, uint8_t state, int track) {
+    Player& p = _players[player - 1];
+    Result& r = _results[player - 1][p.next - 1];
+    unsigned long ms = SlinkHal::nowMillis() - p.sentMs;
+    r.state = state;
+    r.firstTrack = (uint8_t)(track > 0 && track < 100 ? track : 0);
+    r.loadMs = (uint16_t)(state == SlinkInventory::LOADED && ms < 0xFFFF ? ms : 0);
+    _inventory.setSlot(player, p.next, state == SlinkInventory::LOADED);
+
+    p.waiting = false;
+    p.next++;
+    if (++p.unsaved >= SAVE_EVERY) _save();
+    if (p.next > SLOTS) _end(player, true);
+}
+
+void SlinkInventoryScan::_end(int player, bool finished) {
+    Player& p = _players[player - 1];
+    p.scanning = false;
+    p.waiting = false;
+    p.elapsedMs += SlinkHal::nowMillis() - p.startMs;
+    // Don't leave it playing the last slot
+    _tx.sendCommand(SlinkDevices::txDevice(player, p.next > SLOTS ? SLOTS : p.next), SLINK_CMD_STOP);
+    _save();
+
+    Log.print(F("[SCAN] Player "));
+    Log.print(player);
+    if (finished) {
+        Log.print(F(": done in "));
+        Log.print(p.elapsedMs / 1000);
+        Log.print(F(" s, "));
+    } else {
+        Log.print(F(": stopped at slot "));
+        Log.print(p.next);
+        Log.print(F(", "));
+    }
+    int loaded = 0;
+    for (int disc = 1; disc < p.next; ++disc) {
+        loaded += _results[player - 1][disc - 1].state == SlinkInventory::LOADED;
+    }
+    Log.print(loaded);
+    Log.print(F(" of "));
+    Log.print(p.next - 1);
+    Log.println(F(" slots loaded"));
+}
+
+void SlinkInventoryScan::onStatusFrame(const SlinkStatusFrameEvent& ev) {
+    if (!SlinkDevices::isValidPlayer(ev.player)) return;
+    Player& p = _players[ev.player - 1];
+    if (!p.scanning || !p.waiting) return;
+
+    if (ev.disc == p.next) {
+        _record(ev.player, SlinkInventory::LOADED, ev.track);
+    } else if (ev.disc != p.from) {
+        // Not the status frames of the slot before, still coming in: it
+        // went somewhere else
+        _record(ev.player, SlinkInventory::EMPTY, 0);
+    }
+}
+
+void SlinkInventoryScan::onTransport(const SlinkTransportEvent& ev) {
+    if (!SlinkDevices::isValidPlayer(ev.player)) return;
+    Player& p = _players[ev.player - 1];
+    if (!p.scanning || !p.waiting) return;
+
+    // Play and near end can still be the slot before
+    if (ev.code != 0x01 && ev.code != 0x00 && ev.code != 0x50) {
+        p.heard = true;
+    } else if (ev.code == 0x01 && p.heard) {
+        // Went for the slot and gave up
+        _record(ev.player, SlinkInventory::EMPTY, 0);
+    }
+}
+
+void SlinkInventoryScan::loop() {
+    unsigned long now = SlinkHal::nowMillis();
+    for (int player = 1; player <= SLINK_MAX_PLAYERS; ++player) {
+        Player& p = _players[player - 1];
+        if (!p.scanning) continue;
+
+        if (!p.waiting) {
+            _send(player);
+        } else if (!p.heard && now - p.sentMs >= RESEND_MS) {
+            if (p.attempts < MAX_ATTEMPTS) {
+                _send(player);
+            } else {
+                Log.print(F("[SCAN] Player "));
+                Log.print(player);
+                Log.println(F(" not responding"));
+                _end(player, false);
+            }
+        } else if (p.heard && (long)(now - p.deadlineMs) >= 0) {
+            _record(player, SlinkInventory::EMPTY, 0);
+        }
+    }
+}
+
+bool SlinkInventoryScan::uploadDue(int player, int* fromDisc, int* count) const {
+    const Player& p = _players[player - 1];
+    int n = p.next - p.sent;
+    if (n <= 0 || (n < UPLOAD_BATCH && p.scanning)) return false;
+    *fromDisc = p.sent;
+    *count = n < UPLOAD_BATCH ? n : UPLOAD_BATCH;
+    return true;
+}
+
+void SlinkInventoryScan::markSent(int player, int count) {
+    Player& p = _players[player - 1];
+    p.sent = (int16_t)(p.sent + count > p.next ? p.next : p.sent + count);
+    if (!p.scanning) _save();
+}
+
+void SlinkInventoryScan::_save() {
+    static Stored stored;
+    stored.magic = STORE_MAGIC;
+    stored.scanning = _interrupted;
+    unsigned long now = SlinkHal::nowMillis();
+    for (int i = 0; i < SLINK_MAX_PLAYERS; ++i) {
+        const Player& p = _players[i];
+        if (p.scanning) stored.scanning |= (uint8_t)(1u << i);
+        stored.next[i] = p.next;
+        stored.sent[i] = p.sent;
+        stored.elapsedMs[i] = p.elapsedMs + (p.scanning ? now - p.startMs : 0);
+        _players[i].unsaved = 0;
+    }
+    memcpy(stored.results, _results, sizeof(_results));
+    if (!SlinkHal::storeSave(_key, &stored, sizeof(stored))) {
+        Log.println(F("[SCAN] Saving progress failed"));
+    }
+}
+
+void SlinkInventoryScan::printReport(Print& out) const {
+    unsigned long now = SlinkHal::nowMillis();
+    for (int player = 1; player <= SLINK_MAX_PLAYERS; ++player) {
+        const Player& p = _players[player - 1];
+        int loaded = 0, empty = 0;
+        for (int disc = 1; disc < p.next; ++disc) {
+            uint8_t s = _results[player - 1][disc - 1].state;
+            loaded += s == SlinkInventory::LOADED;
+            empty += s == SlinkInventory::EMPTY;
+        }
+        out.print(F("  Player "));
+        out.print(player);
+        out.print(p.scanning ? F(": scanning slot ") : F(": "));
+        if (p.scanning) {
+            out.print(p.next);
+            out.print(F(", "));
+        } else if (p.next > SLOTS) {
+            out.print(F("done, "));
+        } else if (p.next > 1) {
+            out.print(F("stopped at slot "));
+            out.print(p.next);
+            out.print(F(", "));
+        }
+        out.print(loaded);
+        out.print(F(" loaded, "));
+        out.print(empty);
+        out.print(F(" empty, "));
+        out.print((p.elapsedMs + (p.scanning ? now - p.startMs : 0)) / 1000);
+        out.print(F(" s, "));
+        out.print(p.next - p.sent);
+        out.println(F(" not uploaded"));
+    }
+    if (_interrupted) out.println(F("  Interrupted scan saved: 'invscan' resumes it"));
+}
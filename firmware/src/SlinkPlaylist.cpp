@@ -0,0 +1,273 @@
+#include "SlinkPlaylist.h"
+#include "SlinkDecoder.h"
+#include "SlinkTx.h"
+
+static Print& Log = SlinkHal::log();
+
+SlinkPlaylist::SlinkPlaylist(SlinkTx& tx, const SlinkDecoder& decoder)
+: _tx(tx), _decoder(decoder) {
+}
+
+int SlinkPlaylist::load(const SlinkPlaylistEntry* entries, int count, bool start) {
+    clear();
+    for (int i = 0; i < count && _count < MAX_ENTRIES; ++i) {
+        const SlinkPlaylistEntry& e = entries[i];
+        if (!SlinkDevices::isValidPlayer(e.player) || e.disc < 1 || e.disc > 300) continue;
+        _entries[_count++] = e;
+    }
+
+    Log.print(F("[PLAYLIST] Loaded "));
+    Log.print(_count);
+    Log.println(F(" discs"));
+    if (start) this->start();
+    return _count;
+}
+
+bool SlinkPlaylist::start() {
+    if (_count == 0) return false;
+    _current = 0;
+    _active = true;
+    _started = false;
+    _onLastTrack = false;
+    _prep = PREP_NONE;
+    _handingOver = false;
+    _play(_entries[0]);
+    return true;
+}
+
+void SlinkPlaylist::clear() {
+    _count = 0;
+    _current = 0;
+    _active = false;
+    _started = false;
+    _onLastTrack = false;
+    _prep = PREP_NONE;
+    _handingOver = false;
+}
+
+int SlinkPlaylist::tracks(int player, int disc) const {
+    for (int i = 0; i < _count; ++i) {
+        const SlinkPlaylistEntry& e = _entries[i];
+        if (e.player == player && e.disc == disc && e.tracks) return e.tracks;
+    }
+    return 0;
+}
+
+const SlinkPlaylistEntry* SlinkPlaylist::_next() const {
+    return _current + 1 < _count ? &_entries[_current + 1] : nullptr;
+}
+
+void SlinkPlaylist::_play(const SlinkPlaylistEntry& e) {
+    Log.print(F("[PLAYLIST] "));
+    Log.print(_current + 1);
+    Log.print('/');
+    Log.print(_count);
+    Log.print(F(": P"));
+    Log.print(e.player);
+    Log.print(F(" disc "));
+    Log.println(e.disc);
+    _tx.playDisc(e.player, e.disc, e.track ? e.track : 1);
+}
+
+void SlinkPlaylist::_pause(int player) {
+    _tx.sendCommand(SlinkDevices::txDevice(player, 1), SLINK_CMD_PAUSE);
+}
+
+// Turn the idle player's carousel to the next disc while this one plays
+void SlinkPlaylist::_prepare() {
+    const SlinkPlaylistEntry* next = _next();
+    if (!next || next->player == _entries[_current].player) {
+        _prep = PREP_FAILED;
+        return;
+    }
+
+    Log.print(F("[PLAYLIST] Pre-positioning P"));
+    Log.print(next->player);
+    Log.print(F(" on disc "));
+    Log.println(next->disc);
+    _prep = PREP_LOADING;
+    _prepOnDisc = false;
+    _prepPaused = false;
+    _prepPauses = 0;
+    _prepSinceMs = SlinkHal::nowMillis();
+    _tx.playDisc(next->player, next->disc, next->track ? next->track : 1);
+}
+
+void SlinkPlaylist::_handover(bool stopCurrent) {
+    const SlinkPlaylistEntry& cur = _entries[_current];
+    const SlinkPlaylistEntry* next = _next();
+    _started = false;
+    _onLastTrack = false;
+
+    if (!next) {
+        Log.println(F("[PLAYLIST] Finished"));
+        if (stopCurrent) _tx.sendCommand(SlinkDevices::txDevice(cur.player, cur.disc), SLINK_CMD_STOP);
+        _active = false;
+        return;
+    }
+    // A changer that moved on by itself would play on under the next disc
+    if (stopCurrent && next->player != cur.player) {
+        _tx.sendCommand(SlinkDevices::txDevice(cur.player, cur.disc), SLINK_CMD_STOP);
+    }
+
+    _current++;
+    _handovers++;
+    _handingOver = true;
+    _endMs = SlinkHal::nowMillis();
+    if (_prep == PREP_READY) {
+        _warm++;
+        Log.print(F("[PLAYLIST] "));
+        Log.print(_current + 1);
+        Log.print('/');
+        Log.print(_count);
+        Log.print(F(": resuming P"));
+        Log.println(next->player);
+        _pause(next->player);
+    } else {
+        _play(*next);
+    }
+    _prep = PREP_NONE;
+}
+
+// The current player's committed state after any of its frames
+void SlinkPlaylist::_check() {
+    const SlinkPlaylistEntry& cur = _entries[_current];
+    const SlinkTrackStatus& st = _decoder.state(cur.player);
+    if (!st.haveStatus) return;
+
+    if (st.discNumber != cur.disc) {
+        // Left the disc without a stop: continuous play moved on
+        if (_started) _handover(true);
+        return;
+    }
+    if (!st.playing) return;
+    if (!_started && _handingOver) {
+        _handingOver = false;
+        _lastGapMs = SlinkHal::nowMillis() - _endMs;
+        if (_lastGapMs > _maxGapMs) _maxGapMs = _lastGapMs;
+    }
+    _started = true;
+    _onLastTrack = !cur.tracks || st.trackNumber >= cur.tracks;
+    if (_onLastTrack && _prep == PREP_NONE) _prepare();
+}
+
+void SlinkPlaylist::onStatus(const SlinkTrackStatus& st) {
+    if (!_active) return;
+    if (st.player == _entries[_current].player) {
+        _check();
+        return;
+    }
+
+    const SlinkPlaylistEntry* next = _next();
+    if (!next || st.player != next->player || st.discNumber != next->disc) return;
+    if (_prep == PREP_LOADING || _prep == PREP_PAUSING) {
+        _prepOnDisc = true;
+        if (_prep == PREP_LOADING) {
+            _prep = PREP_PAUSING;
+            _prepPauses++;
+            _pause(next->player);
+        } else if (_prepPaused) {
+            _prep = PREP_READY;
+        }
+    }
+}
+
+void SlinkPlaylist::onTransport(const SlinkTransportEvent& ev) {
+    if (!_active) return;
+    const SlinkPlaylistEntry& cur = _entries[_current];
+    if (ev.player == cur.player) {
+        if (ev.code == 0x01 && _started) {
+            if (_onLastTrack) {
+                _handover(false);
+            } else {
+                Log.println(F("[PLAYLIST] Stopped before the last track, queue ended"));
+                clear();
+            }
+            return;
+        }
+        _check();
+        return;
+    }
+
+    const SlinkPlaylistEntry* next = _next();
+    if (!next || ev.player != next->player) return;
+    switch (_prep) {
+        case PREP_LOADING:
+            // Loading: pause now so it stops at the start of the disc
+            if (ev.code == 0x40 || ev.code == 0x00) {
+                _prep = PREP_PAUSING;
+                _prepPauses++;
+                _pause(next->player);
+            }
+            break;
+        case PREP_PAUSING:
+            if (ev.code == 0x04) {
+                _prepPaused = true;
+                if (_prepOnDisc) _prep = PREP_READY;
+            } else if (ev.code == 0x00) {
+                // The pause went in before it loaded and was lost, or
+                // paused and resumed: pause again
+                _prepPaused = false;
+                if (_prepPauses < MAX_PAUSES) {
+                    _prepPauses++;
+                    _pause(next->player);
+                } else {
+                    _prep = PREP_FAILED;
+                }
+            }
+            break;
+        case PREP_READY:
+            // Someone else resumed it
+            if (ev.code != 0x04) _prep = PREP_FAILED;
+            break;
+        default:
+            break;
+    }
+}
+
+void SlinkPlaylist::loop() {
+    if (!_active) return;
+    if ((_prep == PREP_LOADING || _prep == PREP_PAUSING) &&
+        SlinkHal::nowMillis() - _prepSinceMs > PREP_TIMEOUT_MS) {
+        Log.println(F("[PLAYLIST] Pre-positioning timed out, next disc starts cold"));
+        _prep = PREP_FAILED;
+    }
+}
+
+void SlinkPlaylist::printReport(Print& out) const {
+    out.print(F("  "));
+    out.print(_active ? F("playing ") : F("idle, "));
+    if (_active) {
+        out.print(_current + 1);
+        out.print('/');
+    }
+    out.print(_count);
+    out.print(F(" discs  handovers="));
+    out.print(_handovers);
+    out.print(F(" warm="));
+    out.print(_warm);
+    out.print(F(" gap last="));
+    out.print(_lastGapMs);
+    out.print(F("ms max="));
+    out.print(_maxGapMs);
+    out.println(F("ms"));
+    for (int i = 0; i < _count; ++i) {
+        const SlinkPlaylistEntry& e = _entries[i];
+        out.print(i == _current && _active ? F("  > ") : F("    "));
+        out.print(i + 1);
+        out.print(F(". P"));
+        out.print(e.player);
+        out.print(F(" disc "));
+        out.print(e.disc);
+        if (e.tracks) {
+            out.print(F(" ("));
+            out.print(e.tracks);
+            out.print(F(" tracks)"));
+        }
+        if (i == _current + 1 && _active) {
+            static const char* const PREP_NAMES[] = {"", " loading", " pausing", " ready", " cold"};
+            out.print(PREP_NAMES[_prep]);
+        }
+        out.println();
+    }
+}
@@ -0,0 +1,120 @@
+#include "SlinkPresence.h"
+#include "SlinkTx.h"
+
+static Print& Log = SlinkHal::log();
+
+SlinkPresence::SlinkPresence(int bus)
+: _bus(bus) {
+}
+
+void SlinkPresence::setTimeouts(uint32_t heartbeatMs, uint32_t activityMs) {
+    _heartbeatTimeoutMs = heartbeatMs;
+    _activityTimeoutMs = activityMs;
+}
+
+uint32_t SlinkPresence::_timeout(int player) const {
+    return player == SlinkDevices::heartbeatPlayer() ? _heartbeatTimeoutMs : _activityTimeoutMs;
+}
+
+void SlinkPresence::onActivity(const SlinkActivityEvent& ev) {
+    if (!SlinkDevices::isValidPlayer(ev.player)) return;
+    Player& p = _players[ev.player - 1];
+    unsigned long now = SlinkHal::nowMillis();
+
+    p.lastSeenMs = now;
+    p.frames++;
+    if (ev.heartbeat) p.heartbeats++;
+
+    if (p.state == POWERED_OFF && now - p.powerOffMs < POWER_OFF_GRACE_MS) return;
+    if (p.state != ONLINE) _set(ev.player, ONLINE);
+}
+
+void SlinkPresence::loop() {
+    unsigned long now = SlinkHal::nowMillis();
+    for (int player = 1; player <= SLINK_MAX_PLAYERS; ++player) {
+        const Player& p = _players[player - 1];
+        uint32_t timeout = _timeout(player);
+        if (p.state == ONLINE && timeout && now - p.lastSeenMs > timeout) {
+            _set(player, OFFLINE);
+        }
+    }
+}
+
+bool SlinkPresence::accepts(int player) const {
+    if (!SlinkDevices::isValidPlayer(player)) return true;
+    State s = _players[player - 1].state;
+    return s != OFFLINE && s != POWERED_OFF;
+}
+
+bool SlinkPresence::txGate(void* ctx, uint8_t device, uint8_t cmd) {
+    SlinkPresence* self = static_cast<SlinkPresence*>(ctx);
+    int player = SlinkDevices::playerForTxDevice(device);
+    if (!player) return true;       // raw commands to other addresses
+
+    if (cmd == SLINK_CMD_POWER_ON) {
+        // Back to waiting for it to speak up
+        if (!self->accepts(player)) self->_set(player, UNKNOWN);
+        return true;
+    }
+    if (!self->accepts(player)) return false;
+
+    if (cmd == SLINK_CMD_POWER_OFF) {
+        self->_players[player - 1].powerOffMs = SlinkHal::nowMillis();
+        self->_set(player, POWERED_OFF);
+    }
+    return true;
+}
+
+void SlinkPresence::_set(int player, State s) {
+    Player& p = _players[player - 1];
+    State previous = p.state;
+    p.state = s;
+
+    Log.print(F("[PRESENCE] Bus="));
+    Log.print(_bus);
+    Log.print(F(" Player="));
+    Log.print(player);
+    Log.print(F(" "));
+    Log.print(stateName(previous));
+    Log.print(F(" -> "));
+    Log.println(stateName(s));
+
+    _changed.emit(SlinkPresenceEvent{_bus, player, s, previous});
+}
+
+const char* SlinkPresence::stateName(State s) {
+    switch (s) {
+        case ONLINE:      return "online";
+        case OFFLINE:     return "offline";
+        case POWERED_OFF: return "powered-off";
+        default:          return "unknown";
+    }
+}
+
+void SlinkPresence::printReport(Print& out) const {
+    unsigned long now = SlinkHal::nowMillis();
+    for (int player = 1; player <= SLINK_MAX_PLAYERS; ++player) {
+        const Player& p = _players[player - 1];
+        out.print(F("  Player "));
+        out.print(player);
+        out.print(F(": "));
+        out.print(stateName(p.state));
+        out.print(F("  frames="));
+        out.print(p.frames);
+        out.print(F(" heartbeats="));
+        out.print(p.heartbeats);
+        if (p.frames) {
+            out.print(F(" last="));
+            out.print((now - p.lastSeenMs) / 1000);
+            out.print(F("s ago"));
+        }
+        uint32_t timeout = _timeout(player);
+        out.print(F(" timeout="));
+        if (timeout) {
+            out.print(timeout / 1000);
+            out.println(F("s"));
+        } else {
+            out.println(F("none"));
+        }
+    }
+}
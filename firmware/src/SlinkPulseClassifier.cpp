@@ -0,0 +1,194 @@
+#include "SlinkPulseClassifier.h"
+
+// Nominal S-Link mark lengths (µs)
+static const uint32_t NOMINAL_US[SlinkPulseClassifier::NUM_CLASSES] = {
+    600,    // ZERO
+    1200,   // ONE
+    2400,   // SYNC
+};
+
+// Learned widths may drift at most this far from nominal (%)
+static const uint32_t MAX_DRIFT_PCT = 40;
+
+// Only pulses at least this far inside their window are learned from
+static const uint8_t LEARN_MARGIN_PCT = 30;
+
+static const uint32_t GAP_US = 200000;
+
+static const char SYMBOLS[SlinkPulseClassifier::NUM_CLASSES] = { 'S', 'L', 'Y' };
+
+SlinkPulseClassifier::SlinkPulseClassifier() {
+    reset();
+}
+
+void SlinkPulseClassifier::reset() {
+    for (int c = 0; c < NUM_CLASSES; ++c) {
+        _centerX16[c] = (int32_t)(NOMINAL_US[c] << 4);
+        _stats[c] = SlinkPulseClassStats{};
+        for (int p = 0; p < SLINK_MAX_PLAYERS; ++p) {
+            _playerWidth[p][c] = 0;
+        }
+    }
+    frameBegin();
+    _updateWindows();
+}
+
+// Windows with the nominal centers: zero < 900, one 900-2000, sync 2000-5000
+void SlinkPulseClassifier::_updateWindows() {
+    uint32_t zero = _centerX16[ZERO] >> 4;
+    uint32_t one  = _centerX16[ONE] >> 4;
+    uint32_t sync = _centerX16[SYNC] >> 4;
+
+    _zeroOneUs = (zero + one) / 2;
+    _oneSyncUs = one + (sync - one) * 2 / 3;
+    _syncMaxUs = sync * 25 / 12;
+
+    for (int c = 0; c < NUM_CLASSES; ++c) {
+        _stats[c].centerUs = (uint16_t)(_centerX16[c] >> 4);
+    }
+}
+
+uint8_t SlinkPulseClassifier::_margin(uint32_t dt, uint32_t lo, int c, uint32_t hi) const {
+    // Distance to the edge on dt's side of the center, relative to the
+    // center's own distance from that edge
+    uint32_t center = (uint32_t)(_centerX16[c] >> 4);
+    uint32_t span, dist;
+    if (dt < center) {
+        span = center - lo;
+        dist = dt - lo;
+    } else {
+        span = hi - center;
+        dist = hi - dt;
+    }
+    if (span == 0) return 0;
+    uint32_t pct = dist * 100 / span;
+    return pct > 100 ? 100 : (uint8_t)pct;
+}
+
+char SlinkPulseClassifier::classify(uint32_t dt, uint8_t* marginPct) {
+    *marginPct = 0;
+
+    if (dt > GAP_US) return 'G';                    // huge gap (ignored)
+    if (dt >= _oneSyncUs && dt < _syncMaxUs) {      // sync (~2400 us)
+        *marginPct = _margin(dt, _oneSyncUs, SYNC, _syncMaxUs);
+        return 'Y';
+    }
+    if (dt >= _zeroOneUs && dt < _oneSyncUs) {      // long (~1200 us) = 1
+        *marginPct = _margin(dt, _zeroOneUs, ONE, _oneSyncUs);
+        return 'L';
+    }
+    if (dt < _zeroOneUs) {                          // short (~600 us) = 0
+        // The zero window is open-ended below; mirror it around the center
+        uint32_t zero = _centerX16[ZERO] >> 4;
+        uint32_t lo = 2 * zero > _zeroOneUs ? 2 * zero - _zeroOneUs : 0;
+        *marginPct = dt < lo ? 0 : _margin(dt, lo, ZERO, _zeroOneUs);
+        return 'S';
+    }
+    return '?';
+}
+
+void SlinkPulseClassifier::learn(char symbol, uint32_t dt, uint8_t marginPct) {
+    int c;
+    switch (symbol) {
+        case 'S': c = ZERO; break;
+        case 'L': c = ONE;  break;
+        case 'Y': c = SYNC; break;
+        default:  return;
+    }
+
+    SlinkPulseClassStats& st = _stats[c];
+    st.count++;
+    if (dt < st.minUs) st.minUs = (uint16_t)dt;
+    if (dt > st.maxUs) st.maxUs = (uint16_t)dt;
+    if (marginPct < st.minMargin) st.minMargin = marginPct;
+
+    int32_t bin = ((int32_t)dt - (int32_t)st.centerUs + 400) / 50;
+    if (bin < 0) bin = 0;
+    if (bin > 15) bin = 15;
+    if (st.hist[bin] < 0xFFFF) st.hist[bin]++;
+
+    _frameSum[c] += dt;
+    _frameCount[c]++;
+
+    if (!_adaptive || marginPct < LEARN_MARGIN_PCT) {
+        return;
+    }
+
+    int32_t next = _centerX16[c] + (((int32_t)(dt << 4) - _centerX16[c]) >> LEARN_SHIFT);
+    int32_t lo = (int32_t)((NOMINAL_US[c] * (100 - MAX_DRIFT_PCT) / 100) << 4);
+    int32_t hi = (int32_t)((NOMINAL_US[c] * (100 + MAX_DRIFT_PCT) / 100) << 4);
+    if (next < lo) next = lo;
+    if (next > hi) next = hi;
+
+    // Keep the classes well apart (each at least 1.5x the one below)
+    if (c > ZERO && next * 2 < _centerX16[c - 1] * 3) return;
+    if (c < SYNC && next * 3 > _centerX16[c + 1] * 2) return;
+
+    _centerX16[c] = next;
+    _updateWindows();
+}
+
+void SlinkPulseClassifier::frameBegin() {
+    for (int c = 0; c < NUM_CLASSES; ++c) {
+        _frameSum[c] = 0;
+        _frameCount[c] = 0;
+    }
+}
+
+void SlinkPulseClassifier::frameEnd(int player) {
+    if (!SlinkDevices::isValidPlayer(player)) return;
+
+    for (int c = 0; c < NUM_CLASSES; ++c) {
+        if (_frameCount[c] == 0) continue;
+        uint16_t avg = (uint16_t)(_frameSum[c] / _frameCount[c]);
+        uint16_t& w = _playerWidth[player - 1][c];
+        w = (w == 0) ? avg : (uint16_t)(w + ((int32_t)avg - (int32_t)w) / 8);
+    }
+}
+
+void SlinkPulseClassifier::printReport(Print& out) const {
+    out.print(F("[RX] classifier "));
+    out.print(_adaptive ? F("adaptive") : F("fixed"));
+    out.print(F("  windows: S<"));
+    out.print(_zeroOneUs);
+    out.print(F(" L<"));
+    out.print(_oneSyncUs);
+    out.print(F(" Y<"));
+    out.println(_syncMaxUs);
+
+    for (int c = NUM_CLASSES - 1; c >= 0; --c) {
+        const SlinkPulseClassStats& st = _stats[c];
+        out.print(F("  "));
+        out.print(SYMBOLS[c]);
+        out.print(F(" center="));
+        out.print(st.centerUs);
+        out.print(F(" n="));
+        out.print(st.count);
+        if (st.count > 0) {
+            out.print(F(" min="));
+            out.print(st.minUs);
+            out.print(F(" max="));
+            out.print(st.maxUs);
+            out.print(F(" margin="));
+            out.print(st.minMargin);
+            out.print('%');
+        }
+        out.print(F("  hist:"));
+        for (int b = 0; b < 16; ++b) {
+            out.print(' ');
+            out.print(st.hist[b]);
+        }
+        out.println();
+    }
+
+    for (int p = 0; p < SLINK_MAX_PLAYERS; ++p) {
+        out.print(F("  P"));
+        out.print(p + 1);
+        out.print(F(" widths Y/L/S="));
+        out.print(_playerWidth[p][SYNC]);
+        out.print('/');
+        out.print(_playerWidth[p][ONE]);
+        out.print('/');
+        out.println(_playerWidth[p][ZERO]);
+    }
+}
@@ -0,0 +1,268 @@
+#include "SlinkSeekProfile.h"
+#include "SlinkDecoder.h"
+#include "SlinkTx.h"
+#include "SlinkInventory.h"
+#include "SlinkCodec.h"
+
+static Print& Log = SlinkHal::log();
+
+// Spread out so that a short sweep already covers near and far
+const int SlinkSeekProfile::SWEEP_STEPS[] = {1, 150, 5, 60, 20, 100, 2, 40, 10, 130, 30, 80};
+const int SlinkSeekProfile::NUM_SWEEP_STEPS = sizeof(SWEEP_STEPS) / sizeof(SWEEP_STEPS[0]);
+
+SlinkSeekProfile::SlinkSeekProfile(const SlinkDecoder& decoder, int bus)
+: _decoder(decoder), _bus(bus) {
+    snprintf(_key, sizeof(_key), "seek%d", bus);
+    for (Player& p : _players) p = Player{};
+    for (Timing& t : _timing) t = Timing{};
+}
+
+void SlinkSeekProfile::begin() {
+    Stored stored;
+    if (!SlinkHal::storeLoad(_key, &stored, sizeof(stored)) || stored.magic != STORE_MAGIC) return;
+
+    uint32_t total = 0;
+    for (int p = 0; p < SLINK_MAX_PLAYERS; ++p) {
+        memcpy(_players[p].meanMs, stored.meanMs[p], sizeof(_players[p].meanMs));
+        memcpy(_players[p].samples, stored.samples[p], sizeof(_players[p].samples));
+        _players[p].dirty = true;
+        total += sampleCount(p + 1);
+    }
+    Log.print(F("[SEEK] Loaded model for bus "));
+    Log.print(_bus);
+    Log.print(F(": "));
+    Log.print(total);
+    Log.println(F(" samples"));
+}
+
+int SlinkSeekProfile::distance(int fromDisc, int toDisc) {
+    int d = fromDisc > toDisc ? fromDisc - toDisc : toDisc - fromDisc;
+    return d > SLOTS / 2 ? SLOTS - d : d;
+}
+
+int SlinkSeekProfile::_bucket(int distance) {
+    return distance <= 0 ? 0 : (distance - 1) / SLOTS_PER_BUCKET + 1;
+}
+
+void SlinkSeekProfile::onTraffic(const SlinkTrafficEvent& ev) {
+    if (!ev.ours || ev.len != 4 || ev.bytes[1] != SLINK_CMD_PLAY_DISC) return;
+    int player = SlinkDevices::playerForTxDevice(ev.bytes[0]);
+    if (!player) return;
+
+    bool highRange = ev.bytes[0] == SlinkDevices::PLAYERS[player - 1].txHi;
+    int to = SlinkCodec::decodeDiscByte(ev.bytes[2], highRange);
+    if (to < 1) return;
+
+    // The same disc again: the changer didn't act on the first frame
+    Timing& t = _timing[player - 1];
+    const SlinkTrackStatus& st = _decoder.state(player);
+    t.fromDisc = (int16_t)(t.active && t.toDisc == to ? t.fromDisc : st.discNumber);
+    t.active = true;
+    t.toDisc = (int16_t)to;
+    t.sentUs = ev.endUs;
+}
+
+void SlinkSeekProfile::onStatusFrame(const SlinkStatusFrameEvent& ev) {
+    if (!SlinkDevices::isValidPlayer(ev.player)) return;
+    Timing& t = _timing[ev.player - 1];
+    if (!t.active || ev.disc != t.toDisc) return;
+    t.active = false;
+
+    long us = (long)(ev.startUs - t.sentUs);
+    if (us < 0 || t.fromDisc < 1 || (unsigned long)us / 1000 > SAMPLE_TIMEOUT_MS) return;
+
+    uint32_t ms = (uint32_t)us / 1000;
+    int d = distance(t.fromDisc, t.toDisc);
+    _add(ev.player, d, ms);
+
+    Log.print(F("[SEEK] Player "));
+    Log.print(ev.player);
+    Log.print(F(": disc "));
+    Log.print(t.fromDisc);
+    Log.print(F(" -> "));
+    Log.print(t.toDisc);
+    Log.print(F(" ("));
+    Log.print(d);
+    Log.print(F(" slots) "));
+    Log.print(ms);
+    Log.println(F(" ms"));
+
+    if (_sweepLeft > 0 && ev.player == _sweepPlayer) {
+        _sweepNextMs = SlinkHal::nowMillis() + SWEEP_SETTLE_MS;
+    }
+}
+
+void SlinkSeekProfile::_add(int player, int distance, uint32_t ms) {
+    Player& p = _players[player - 1];
+    int b = _bucket(distance);
+    if (p.samples[b] < 0xFFFF) p.samples[b]++;
+    int32_t n = p.samples[b] < AVERAGE_OVER ? p.samples[b] : AVERAGE_OVER;
+    int32_t mean = p.meanMs[b] + ((int32_t)(ms > 0xFFFF ? 0xFFFF : ms) - p.meanMs[b]) / n;
+    p.meanMs[b] = (uint16_t)mean;
+    p.dirty = true;
+    _unsaved = true;
+}
+
+uint32_t SlinkSeekProfile::sampleCount(int player) const {
+    uint32_t n = 0;
+    for (int b = 0; b < BUCKETS; ++b) n += _players[player - 1].samples[b];
+    return n;
+}
+
+// Least squares through the bucket means at their middle distance,
+// weighted by samples (up to AVERAGE_OVER)
+bool SlinkSeekProfile::fit(int player, float* baseMs, float* msPerSlot) const {
+    const Player& p = _players[player - 1];
+    float sw = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+    int used = 0;
+    for (int b = 1; b < BUCKETS; ++b) {
+        if (!p.samples[b]) continue;
+        float w = p.samples[b] < AVERAGE_OVER ? p.samples[b] : AVERAGE_OVER;
+        float x = (b - 1) * SLOTS_PER_BUCKET + (SLOTS_PER_BUCKET + 1) / 2.0f;
+        float y = p.meanMs[b];
+        sw += w;
+        sx += w * x;
+        sy += w * y;
+        sxx += w * x * x;
+        sxy += w * x * y;
+        used++;
+    }
+    float det = sw * sxx - sx * sx;
+    if (used < 2 || det <= 0) return false;
+    *msPerSlot = (sw * sxy - sx * sy) / det;
+    *baseMs = (sy - *msPerSlot * sx) / sw;
+    return true;
+}
+
+uint32_t SlinkSeekProfile::predictMs(int player, int fromDisc, int toDisc) const {
+    if (!SlinkDevices::isValidPlayer(player) || fromDisc < 1 || toDisc < 1) return 0;
+    const Player& p = _players[player - 1];
+    int d = distance(fromDisc, toDisc);
+    int b = _bucket(d);
+    if (p.samples[b] >= MIN_SAMPLES) return p.meanMs[b];
+
+    float base, perSlot;
+    if (d > 0 && fit(player, &base, &perSlot)) {
+        float ms = base + perSlot * d;
+        return ms < 1 ? 1 : (uint32_t)ms;
+    }
+    return p.samples[b] ? p.meanMs[b] : 0;
+}
+
+bool SlinkSeekProfile::startSweep(SlinkTx& tx, const SlinkInventory* inventory, int player, int count) {
+    if (!SlinkDevices::isValidPlayer(player) || count <= 0) return false;
+    _sweepTx = &tx;
+    _sweepInventory = inventory;
+    _sweepPlayer = (int8_t)player;
+    _sweepLeft = (int16_t)count;
+    _sweepNextMs = SlinkHal::nowMillis();
+    return true;
+}
+
+// A loaded slot close after target (wrapping), else the first one at or
+// after it that the inventory doesn't know to be empty
+void SlinkSeekProfile::_sweepNext(unsigned long now) {
+    int player = _sweepPlayer;
+    int from = _decoder.state(player).discNumber;
+    int target = from < 1 ? 1 : (from - 1 + SWEEP_STEPS[_sweepStep++ % NUM_SWEEP_STEPS]) % SLOTS + 1;
+
+    if (_sweepInventory) {
+        int pick = 0;
+        for (int i = 0; i < SLOTS_PER_BUCKET && !pick; ++i) {
+            int disc = (target - 1 + i) % SLOTS + 1;
+            if (disc != from && _sweepInventory->slot(player, disc) == SlinkInventory::LOADED) pick = disc;
+        }
+        for (int i = 0; i < SLOTS && !pick; ++i) {
+            int disc = (target - 1 + i) % SLOTS + 1;
+            if (disc != from && _sweepInventory->slot(player, disc) != SlinkInventory::EMPTY) pick = disc;
+        }
+        if (pick) target = pick;
+    }
+
+    _sweepLeft--;
+    _sweepNextMs = now + SAMPLE_TIMEOUT_MS;
+    _sweepTx->playDisc(player, target, 1);
+}
+
+void SlinkSeekProfile::loop() {
+    unsigned long now = SlinkHal::nowMillis();
+    unsigned long nowUs = SlinkHal::nowMicros();
+    for (Timing& t : _timing) {
+        if (t.active && (long)(nowUs - t.sentUs) > (long)(SAMPLE_TIMEOUT_MS * 1000UL)) t.active = false;
+    }
+
+    if (_sweepLeft > 0 && !_timing[_sweepPlayer - 1].active && (long)(now - _sweepNextMs) >= 0) {
+        _sweepNext(now);
+    }
+
+    if (_unsaved && now - _lastSaveMs >= SAVE_INTERVAL_MS) save();
+}
+
+bool SlinkSeekProfile::save() {
+    Stored stored;
+    stored.magic = STORE_MAGIC;
+    for (int p = 0; p < SLINK_MAX_PLAYERS; ++p) {
+        memcpy(stored.meanMs[p], _players[p].meanMs, sizeof(stored.meanMs[p]));
+        memcpy(stored.samples[p], _players[p].samples, sizeof(stored.samples[p]));
+    }
+    _lastSaveMs = SlinkHal::nowMillis();
+    _unsaved = false;
+    if (!SlinkHal::storeSave(_key, &stored, sizeof(stored))) {
+        Log.println(F("[SEEK] Saving the model failed"));
+        return false;
+    }
+    return true;
+}
+
+void SlinkSeekProfile::reset() {
+    for (Player& p : _players) {
+        p = Player{};
+        p.dirty = true;
+    }
+    for (Timing& t : _timing) t = Timing{};
+    save();
+}
+
+void SlinkSeekProfile::printReport(Print& out) const {
+    for (int player = 1; player <= SLINK_MAX_PLAYERS; ++player) {
+        const Player& p = _players[player - 1];
+        out.print(F("  Player "));
+        out.print(player);
+        out.print(F(": "));
+        out.print(sampleCount(player));
+        out.print(F(" samples"));
+        float base, perSlot;
+        if (fit(player, &base, &perSlot)) {
+            out.print(F(", fit "));
+            out.print((int)base);
+            out.print(F(" ms + "));
+            out.print(perSlot, 1);
+            out.print(F(" ms/slot"));
+        }
+        out.println();
+        for (int b = 0; b < BUCKETS; ++b) {
+            if (!p.samples[b]) continue;
+            out.print(F("    "));
+            if (b == 0) {
+                out.print(F("same disc"));
+            } else {
+                out.print((b - 1) * SLOTS_PER_BUCKET + 1);
+                out.print('-');
+                out.print(b * SLOTS_PER_BUCKET);
+                out.print(F(" slots"));
+            }
+            out.print(F(": "));
+            out.print(p.meanMs[b]);
+            out.print(F(" ms (n="));
+            out.print(p.samples[b]);
+            out.println(')');
+        }
+    }
+    if (_sweepLeft > 0) {
+        out.print(F("  Sweeping player "));
+        out.print(_sweepPlayer);
+        out.print(F(", "));
+        out.print(_sweepLeft);
+        out.println(F(" discs to go"));
+    }
+}
@@ -1,169 +1,828 @@
 #include "SlinkTx.h"
+#include "SlinkCodec.h"
+#include "SlinkDevices.h"
 
-SlinkTx::SlinkTx(int txPin)
-    : _txPin(txPin) {
+static Print& Log = SlinkHal::log();
+
+// RMT clock divider - 1MHz tick rate (1µs resolution)
+static const uint8_t RMT_TX_CLK_DIV = 80;
+
+SlinkTx::SlinkTx(int txPin, rmt_channel_t channel)
+    : _txPin(txPin), _channel(channel) {
 }
 
 void SlinkTx::begin() {
-    pinMode(_txPin, OUTPUT);
-    digitalWrite(_txPin, LOW);  // Idle state - transistor off, line floats high
+    // Idle output low - transistor off, line floats high
+    SlinkHal::RmtTxConfig txConfig;
+    txConfig.clkDiv = RMT_TX_CLK_DIV;
+    txConfig.memBlocks = 1;             // a whole command fits in 64 items
+    if (!_rmt.begin(_txPin, _channel, txConfig, _onTxEnd, this)) {
+        Log.println(F("[TX] RMT init failed"));
+    }
+    if (_rxPin >= 0 && !_line.begin(_rxPin)) {
+        Log.println(F("[TX] Carrier sense unavailable, using blind lead-in"));
+    }
+    _random = SlinkHal::nowMicros() ^ ((uint32_t)_txPin << 16) ^ 0x9E3779B9u;
 }
 
 // ---- Basic transport commands ----
 
-void SlinkTx::play() {
-    sendCommand(SLINK_DEV_CDP1_LO, SLINK_CMD_PLAY);
+bool SlinkTx::play() {
+    return sendCommand(SLINK_DEV_CDP1_LO, SLINK_CMD_PLAY);
 }
 
-void SlinkTx::stop() {
-    sendCommand(SLINK_DEV_CDP1_LO, SLINK_CMD_STOP);
+bool SlinkTx::stop() {
+    return sendCommand(SLINK_DEV_CDP1_LO, SLINK_CMD_STOP);
 }
 
-void SlinkTx::pause() {
-    sendCommand(SLINK_DEV_CDP1_LO, SLINK_CMD_PAUSE);
+bool SlinkTx::pause() {
+    return sendCommand(SLINK_DEV_CDP1_LO, SLINK_CMD_PAUSE);
 }
 
-void SlinkTx::nextTrack() {
-    sendCommand(SLINK_DEV_CDP1_LO, SLINK_CMD_NEXT_TRACK);
+bool SlinkTx::nextTrack() {
+    return sendCommand(SLINK_DEV_CDP1_LO, SLINK_CMD_NEXT_TRACK);
 }
 
-void SlinkTx::prevTrack() {
-    sendCommand(SLINK_DEV_CDP1_LO, SLINK_CMD_PREV_TRACK);
+bool SlinkTx::prevTrack() {
+    return sendCommand(SLINK_DEV_CDP1_LO, SLINK_CMD_PREV_TRACK);
 }
 
-void SlinkTx::powerOn() {
-    sendCommand(SLINK_DEV_CDP1_LO, SLINK_CMD_POWER_ON);
+bool SlinkTx::powerOn() {
+    return sendCommand(SLINK_DEV_CDP1_LO, SLINK_CMD_POWER_ON);
 }
 
-void SlinkTx::powerOff() {
-    sendCommand(SLINK_DEV_CDP1_LO, SLINK_CMD_POWER_OFF);
+bool SlinkTx::powerOff() {
+    return sendCommand(SLINK_DEV_CDP1_LO, SLINK_CMD_POWER_OFF);
 }
 
 // ---- Play specific disc/track ----
 
-void SlinkTx::playDisc(int player, int disc, int track) {
-    uint8_t device;
-
+bool SlinkTx::playDisc(int player, int disc, int track) {
     // Select device address based on player and disc range
-    if (player == 2) {
-        device = (disc > 200) ? SLINK_DEV_CDP2_HI : SLINK_DEV_CDP2_LO;
-    } else {
-        device = (disc > 200) ? SLINK_DEV_CDP1_HI : SLINK_DEV_CDP1_LO;
+    if (!SlinkDevices::isValidPlayer(player)) {
+        player = 1;
     }
+    uint8_t device = SlinkDevices::txDevice(player, disc);
+
+    // Encode disc number and track (BCD)
+    uint8_t discByte  = SlinkCodec::encodeDiscByte(disc);
+    uint8_t trackByte = SlinkCodec::encodeTrackByte(track);
 
-    // Encode disc number
-    uint8_t discByte = _encodeDiscBCD(disc);
+    Log.print(F("[TX] playDisc player="));
+    Log.print(player);
+    Log.print(F(" disc="));
+    Log.print(disc);
+    Log.print(F(" track="));
+    Log.print(track);
+    Log.print(F(" -> dev=0x"));
+    Log.print(device, HEX);
+    Log.print(F(" discByte=0x"));
+    Log.print(discByte, HEX);
+    Log.print(F(" trackByte=0x"));
+    Log.println(trackByte, HEX);
+
+    return sendCommand(device, SLINK_CMD_PLAY_DISC, discByte, trackByte);
+}
+
+// ---- Low-level send functions ----
+
+bool SlinkTx::sendCommand(uint8_t device, uint8_t cmd) {
+    const uint8_t bytes[] = {device, cmd};
+    return _submit(bytes, sizeof(bytes));
+}
+
+bool SlinkTx::sendCommand(uint8_t device, uint8_t cmd, uint8_t param1) {
+    const uint8_t bytes[] = {device, cmd, param1};
+    return _submit(bytes, sizeof(bytes));
+}
+
+bool SlinkTx::sendCommand(uint8_t device, uint8_t cmd, uint8_t param1, uint8_t param2) {
+    const uint8_t bytes[] = {device, cmd, param1, param2};
+    return _submit(bytes, sizeof(bytes));
+}
 
-    // Encode track as BCD
-    uint8_t trackByte = 0;
-    if (track > 0 && track <= 99) {
-        trackByte = ((track / 10) << 4) | (track % 10);
+// Blocking wrapper (unless setBlocking(false)): waits for room, queues,
+// then waits until the command is out
+bool SlinkTx::_submit(const uint8_t* bytes, int len) {
+    loop();
+    if (_count == QUEUE_LEN) {
+        flush();
+    }
+    bool queued = sendAsync(bytes, len);
+    if (queued && _blocking) {
+        flush();
+    }
+    return queued;
+}
+
+bool SlinkTx::sendAsync(const uint8_t* bytes, int len, SlinkTxDone done, void* ctx) {
+    if (len < 2 || len > MAX_CMD_BYTES) {
+        return false;
+    }
+
+    if (_gate && !_gate(_gateCtx, bytes[0], bytes[1])) {
+        _gated++;
+        Log.print(F("[TX] Not sent, player not present: dev=0x"));
+        Log.print(bytes[0], HEX);
+        Log.print(F(" cmd=0x"));
+        Log.println(bytes[1], HEX);
+        return false;
+    }
+
+    Entry e = {};
+    memcpy(e.bytes, bytes, len);
+    e.len = (uint8_t)len;
+    e.priority = priorityOf(bytes[1]);
+    if (len == 2 && bytes[1] == SLINK_CMD_NEXT_TRACK) e.skip = 1;
+    if (len == 2 && bytes[1] == SLINK_CMD_PREV_TRACK) e.skip = -1;
+    e.done = done;
+    e.ctx = ctx;
+    e.queuedUs = SlinkHal::nowMicros();
+
+    if (_coalescing && _coalesce(e)) {
+        _stats.queued++;
+        _stats.coalesced++;
+        loop();
+        return true;
+    }
+
+    if (_count == QUEUE_LEN) {
+        // Make room by dropping the newest less urgent command
+        int victim = -1;
+        for (int i = _count - 1; i >= (_inFlight ? 1 : 0); --i) {
+            if (_queue[i].priority > e.priority) {
+                victim = i;
+                break;
+            }
+        }
+        if (victim < 0) {
+            _stats.rejected++;
+            Log.println(F("[TX] Queue full"));
+            return false;
+        }
+        _stats.evicted++;
+        _remove(victim, false);
     }
 
-    Serial.print(F("[TX] playDisc player="));
-    Serial.print(player);
-    Serial.print(F(" disc="));
-    Serial.print(disc);
-    Serial.print(F(" track="));
-    Serial.print(track);
-    Serial.print(F(" -> dev=0x"));
-    Serial.print(device, HEX);
-    Serial.print(F(" discByte=0x"));
-    Serial.print(discByte, HEX);
-    Serial.print(F(" trackByte=0x"));
-    Serial.println(trackByte, HEX);
+    _insert(e);
+    _stats.queued++;
+    if (_count > _stats.maxDepth) _stats.maxDepth = (uint8_t)_count;
 
-    sendCommand(device, SLINK_CMD_PLAY_DISC, discByte, trackByte);
+    loop();
+    return true;
 }
 
-// ---- Low-level send functions ----
+SlinkTxPriority SlinkTx::priorityOf(uint8_t cmd) {
+    switch (cmd) {
+        case SLINK_CMD_STOP:
+        case SLINK_CMD_PAUSE:
+        case SLINK_CMD_POWER_ON:
+        case SLINK_CMD_POWER_OFF:
+            return SLINK_TX_URGENT;
+        case SLINK_CMD_PLAY:
+        case SLINK_CMD_PLAY_DISC:
+            return SLINK_TX_SELECT;
+        default:
+            return SLINK_TX_BROWSE;
+    }
+}
+
+// Same player (either address range), or the same raw address
+bool SlinkTx::_sameTarget(uint8_t a, uint8_t b) {
+    int player = SlinkDevices::playerForTxDevice(a);
+    return player ? player == SlinkDevices::playerForTxDevice(b) : a == b;
+}
 
-void SlinkTx::sendCommand(uint8_t device, uint8_t cmd) {
-    _waitForBus();
-    _writeSync();
-    _writeByte(device);
-    _writeByte(cmd);
-    delay(2);  // Post-command delay
+bool SlinkTx::_isSkip(const Entry& e) {
+    return e.len == 2 && (e.bytes[1] == SLINK_CMD_NEXT_TRACK || e.bytes[1] == SLINK_CMD_PREV_TRACK);
 }
 
-void SlinkTx::sendCommand(uint8_t device, uint8_t cmd, uint8_t param1) {
-    _waitForBus();
-    _writeSync();
-    _writeByte(device);
-    _writeByte(cmd);
-    _writeByte(param1);
-    delay(2);
+// Folds e into the queue. true if nothing is left to queue; otherwise
+// commands e makes pointless have been dropped and e still goes in.
+bool SlinkTx::_coalesce(const Entry& e) {
+    const uint8_t cmd = e.bytes[1];
+    const int first = _inFlight ? 1 : 0;    // the frame on the wire is fixed
+
+    if (_isSkip(e)) {
+        // Only the newest command to the player can absorb it, so a skip
+        // never moves across a stop or pause
+        for (int i = _count - 1; i >= 0; --i) {
+            Entry& q = _queue[i];
+            if (!_sameTarget(q.bytes[0], e.bytes[0])) continue;
+            if (e.done && e.done != q.done) return false;
+            // Another command of the same owner: it learns at once that q
+            // carries it
+            bool own = e.done && e.ctx != q.ctx;
+
+            if (_isSkip(q)) {
+                // Also while on the wire: only the remaining steps change
+                int skip = q.skip + e.skip;
+                if (skip < -99 || skip > 99 || (own && skip == 0)) return false;
+                q.skip = (int8_t)skip;
+                if (q.skip == 0 && i >= first) _remove(i, false);
+                if (own) _finish(e, true, true);
+                return true;
+            }
+            if (q.bytes[1] == SLINK_CMD_PLAY_DISC && q.len == 4 && i >= first) {
+                int track = SlinkCodec::decodeTrackByte(q.bytes[3]);
+                track = (track ? track : 1) + e.skip;
+                q.bytes[3] = SlinkCodec::encodeTrackByte(track < 1 ? 1 : track > 99 ? 99 : track);
+                if (own) _finish(e, true, true);
+                return true;
+            }
+            return false;
+        }
+        return false;
+    }
+
+    bool absorbed = false;
+    if (cmd == SLINK_CMD_PLAY_DISC || cmd == SLINK_CMD_STOP) {
+        // Newest first, so a play disc replaces the latest one in place and
+        // anything queued for the player after it goes
+        for (int i = _count - 1; i >= 0; --i) {
+            Entry& q = _queue[i];
+            if (!_sameTarget(q.bytes[0], e.bytes[0])) continue;
+            uint8_t qcmd = q.bytes[1];
+            if (qcmd != SLINK_CMD_PLAY && qcmd != SLINK_CMD_PLAY_DISC && !_isSkip(q)) continue;
+
+            if (i < first) {
+                // Stepping through a skip: stop after the current step
+                if (_isSkip(q)) q.skip = _frameSkip;
+                continue;
+            }
+            bool mergeable = !e.done || (e.done == q.done && e.ctx == q.ctx);
+            if (cmd == SLINK_CMD_PLAY_DISC && qcmd == SLINK_CMD_PLAY_DISC && mergeable && !absorbed) {
+                memcpy(q.bytes, e.bytes, e.len);
+                absorbed = true;
+                continue;
+            }
+            _stats.superseded++;
+            _remove(i, false);
+        }
+        if (absorbed) return true;
+    }
+
+    if (cmd == SLINK_CMD_PLAY || cmd == SLINK_CMD_STOP ||
+        cmd == SLINK_CMD_POWER_ON || cmd == SLINK_CMD_POWER_OFF) {
+        // Duplicate of the newest command still waiting for the player
+        for (int i = _count - 1; i >= first; --i) {
+            const Entry& q = _queue[i];
+            if (!_sameTarget(q.bytes[0], e.bytes[0])) continue;
+            bool mergeable = !e.done || (e.done == q.done && e.ctx == q.ctx);
+            bool playing = cmd == SLINK_CMD_PLAY && q.bytes[1] == SLINK_CMD_PLAY_DISC;
+            return mergeable && (playing || (q.len == e.len && q.bytes[1] == cmd));
+        }
+    }
+    return false;
 }
 
-void SlinkTx::sendCommand(uint8_t device, uint8_t cmd, uint8_t param1, uint8_t param2) {
-    _waitForBus();
-    _writeSync();
-    _writeByte(device);
-    _writeByte(cmd);
-    _writeByte(param1);
-    _writeByte(param2);
-    delay(2);
+// Behind everything at least as urgent, but never ahead of an earlier
+// command to the same player: a stop must not land before the play it
+// was meant to end
+void SlinkTx::_insert(const Entry& e) {
+    int pos = _count;
+    while (pos > (_inFlight ? 1 : 0)) {
+        const Entry& q = _queue[pos - 1];
+        if (q.priority <= e.priority || _sameTarget(q.bytes[0], e.bytes[0])) break;
+        pos--;
+    }
+    for (int i = _count; i > pos; --i) {
+        _queue[i] = _queue[i - 1];
+    }
+    _queue[pos] = e;
+    _count++;
+}
+
+// Off the queue, for _finish() or a verify slot
+SlinkTx::Entry SlinkTx::_take(int index) {
+    Entry e = _queue[index];
+    for (int i = index; i < _count - 1; ++i) {
+        _queue[i] = _queue[i + 1];
+    }
+    _count--;
+    return e;
+}
+
+// Done with a command: its callback
+void SlinkTx::_finish(const Entry& e, bool sent, bool coalesced) {
+    if (!e.done) return;
+    SlinkTxCompletion c = {e.bytes[0], e.bytes[1], sent, e.retries, e.queuedUs,
+                           e.started ? e.startUs : 0, SlinkHal::nowMicros(),
+                           e.verified, e.bitErrors, e.echoUs, coalesced};
+    e.done(e.ctx, c);
+}
+
+void SlinkTx::loop() {
+    if (_inFlight && _txEnd) {
+        _complete();
+    }
+    unsigned long now = SlinkHal::nowMicros();
+    while (_verifyCount > 0 && now - _verify[0].endUs >= ECHO_TIMEOUT_US) {
+        _verifyDone(false, 0, 0);
+    }
+    if (!_inFlight && _count > 0 && _lineReady()) {
+        _start();
+    }
+}
+
+void SlinkTx::flush() {
+    while (_count > 0) {
+        loop();
+        if (_inFlight && !_txEnd && !_rmt.waitDone(FLUSH_TIMEOUT_MS)) {
+            Log.println(F("[TX] RMT timeout"));
+            _complete();
+        } else if (!_inFlight && _count > 0) {
+            SlinkHal::delayMicros(LINE_POLL_US);    // waiting for the line
+        }
+    }
 }
 
 // ---- Private helpers ----
 
-void SlinkTx::_waitForBus() {
-    // For now, just a small delay
-    // A proper implementation would monitor the RX pin for idle
-    delay(5);
+void IRAM_ATTR SlinkTx::_onTxEnd(void* arg) {
+    static_cast<SlinkTx*>(arg)->_txEnd = true;
+}
+
+// Whether the head command may go now: the line idle for LINE_READY_US
+// plus a backoff drawn when it started waiting, and no predicted traffic
+// in the way
+bool SlinkTx::_lineReady() {
+    bool sensing = _line.active();
+    if (!sensing && !_slotCheck) return true;
+
+    unsigned long now = SlinkHal::nowMicros();
+    if (!_waiting) {
+        _waiting = true;
+        _lineBusy = false;
+        _deferred = false;
+        _holdUntilUs = now;
+        _waitSinceUs = now;
+        _random ^= _random << 13;
+        _random ^= _random >> 17;
+        _random ^= _random << 5;
+        _backoffUs = _random % (BACKOFF_SLOT_US << _queue[0].frameRetries);
+    }
+
+    bool idle = !sensing ||
+                (!_line.mark() && now - _line.lastEdgeUs() >= LINE_READY_US + _backoffUs);
+    if (idle && _slotFree(now)) {
+        return true;
+    }
+    if (!idle && !_lineBusy) {
+        _lineBusy = true;
+        _stats.lineWaits++;
+    }
+    if (now - _waitSinceUs >= LINE_WAIT_MAX_US) {
+        _stats.forced++;
+        Log.println(F("[TX] Line never idle, sending anyway"));
+        return true;
+    }
+    return false;
+}
+
+bool SlinkTx::_slotFree(unsigned long now) {
+    if (!_slotCheck) return true;
+    if ((long)(now - _holdUntilUs) < 0) return false;
+
+    // The marks start after the lead-in when sending blind
+    unsigned long startUs = now + (_line.active() ? 0 : _timing.leadInUs);
+    unsigned long clearAtUs = 0;
+    if (_slotCheck(_slotCtx, startUs, _frameUs(_queue[0]), &clearAtUs)) {
+        return true;
+    }
+    if (!_deferred) {
+        _deferred = true;
+        _deferSinceUs = now;
+        _stats.deferred++;
+    }
+    _holdUntilUs = clearAtUs - (startUs - now);
+    return false;
+}
+
+// Wire time of the entry's frame; a skip may go out as a play disc, so
+// assume the longest one
+uint32_t SlinkTx::_frameUs(const Entry& e) const {
+    const uint32_t oneUs = _width(SlinkPulseClassifier::ONE) + _timing.delimiterUs;
+    const uint32_t zeroUs = _width(SlinkPulseClassifier::ZERO) + _timing.delimiterUs;
+    uint32_t us = _width(SlinkPulseClassifier::SYNC) + _timing.delimiterUs;
+    if (_isSkip(e)) return us + 8 * MAX_CMD_BYTES * oneUs;
+    for (int i = 0; i < e.len; ++i) {
+        for (int b = 7; b >= 0; --b) {
+            us += ((e.bytes[i] >> b) & 1) ? oneUs : zeroUs;
+        }
+    }
+    return us;
+}
+
+// Our marks make two edges each; anything else on the line while they went
+// out means overlapping frames. No edges at all: the RX side doesn't hear
+// us, so nothing can be told.
+bool SlinkTx::_collided() const {
+    if (!_line.active()) return false;
+    uint32_t edges = _line.edgesBetween(_marksStartUs - 1, _marksEndUs);
+    return edges != 0 && edges != _frameEdges;
+}
+
+// Mark (transistor on = line LOW) for each symbol, then a delimiter
+int SlinkTx::_encode(const uint8_t* bytes, int len, rmt_item32_t* items, uint16_t leadInUs) const {
+    int n = 0;
+    auto idle = [&](uint16_t us) {
+        items[n].val = 0;
+        items[n].duration0 = us / 2 ? us / 2 : 1;
+        items[n].duration1 = us - us / 2 ? us - us / 2 : 1;
+        n++;
+    };
+    auto mark = [&](uint16_t us) {
+        items[n].val = 0;
+        items[n].level0 = 1;
+        items[n].duration0 = us;
+        items[n].duration1 = _timing.delimiterUs;
+        n++;
+    };
+
+    if (leadInUs) idle(leadInUs);
+    const uint16_t oneUs = _width(SlinkPulseClassifier::ONE);
+    const uint16_t zeroUs = _width(SlinkPulseClassifier::ZERO);
+    mark(_width(SlinkPulseClassifier::SYNC));
+    for (int i = 0; i < len; ++i) {
+        for (int b = 7; b >= 0; --b) {      // MSB first
+            mark(((bytes[i] >> b) & 1) ? oneUs : zeroUs);
+        }
+    }
+    idle(_timing.trailUs);
+    items[n++].val = 0;                     // end marker
+    return n;
+}
+
+void SlinkTx::_start() {
+    Entry& e = _queue[0];
+    uint8_t bytes[MAX_CMD_BYTES];
+    int len = e.len;
+    memcpy(bytes, e.bytes, len);
+
+    unsigned long now = SlinkHal::nowMicros();
+    int player = SlinkDevices::playerForTxDevice(e.bytes[0]);
+
+    _frameSkip = 0;
+    if (_isSkip(e)) {
+        int disc = 0;
+        int track = 0;
+        int tracks = 0;
+        if (!e.started && player && _position &&
+            SlinkHal::nowMillis() - _lastSentMs[player - 1] >= POSITION_SETTLE_MS &&
+            _position(_positionCtx, player, &disc, &track, &tracks)) {
+            e.baseDisc = (int16_t)disc;
+            e.baseTrack = (int8_t)track;
+            e.baseTracks = (uint8_t)(tracks > 0 && tracks <= 99 ? tracks : 0);
+        }
+        // Going back depends on how far into the track the player is, so
+        // previous always steps. Forward only jumps to a track on the disc.
+        int target = e.baseTrack + e.stepped + e.skip;
+        if (e.baseDisc && e.skip > 1 && target <= e.baseTracks) {
+            // The rest of the skip as one frame
+            bytes[0] = SlinkDevices::txDevice(player, e.baseDisc);
+            bytes[1] = SLINK_CMD_PLAY_DISC;
+            bytes[2] = SlinkCodec::encodeDiscByte(e.baseDisc);
+            bytes[3] = SlinkCodec::encodeTrackByte(target);
+            len = 4;
+            _frameSkip = e.skip;
+            _stats.skipsResolved++;
+        } else {
+            bytes[1] = e.skip < 0 ? SLINK_CMD_PREV_TRACK : SLINK_CMD_NEXT_TRACK;
+            _frameSkip = e.skip < 0 ? -1 : 1;
+        }
+    }
+
+    if (!e.started) {
+        e.started = true;
+        e.startUs = now;
+        uint32_t waitUs = now - e.queuedUs;
+        _stats.started++;
+        _stats.totalWaitUs += waitUs;
+        if (waitUs > _stats.maxWaitUs) _stats.maxWaitUs = waitUs;
+    }
+
+    if (_waiting) {
+        uint32_t waitUs = now - _waitSinceUs;
+        if (_lineBusy && waitUs > _stats.maxLineWaitUs) _stats.maxLineWaitUs = waitUs;
+        if (_deferred && now - _deferSinceUs > _stats.maxDeferUs) {
+            _stats.maxDeferUs = now - _deferSinceUs;
+        }
+        _waiting = false;
+    }
+
+    // Carrier sense already saw the line idle, so no blind lead-in
+    uint16_t leadInUs = _line.active() ? 0 : _timing.leadInUs;
+    int numItems = _encode(bytes, len, _items, leadInUs);
+    int marks = 1 + 8 * len;
+    _marksStartUs = now + leadInUs;
+    _marksEndUs = _marksStartUs;
+    for (int i = leadInUs ? 1 : 0; i < (leadInUs ? 1 : 0) + marks; ++i) {
+        _marksEndUs += _items[i].duration0 + _items[i].duration1;
+    }
+    _frameEdges = (uint16_t)(2 * marks);
+
+    memcpy(_frameBytes, bytes, len);
+    _frameLen = (uint8_t)len;
+    for (int c = 0; c < SlinkPulseClassifier::NUM_CLASSES; ++c) {
+        _frameWidthUs[c] = _width((SlinkPulseClassifier::Class)c);
+    }
+
+    _txEnd = false;
+    _frameStartUs = now;
+    if (_rmt.write(_items, numItems)) {
+        _inFlight = true;
+        return;
+    }
+    Log.println(F("[TX] RMT write failed, command dropped"));
+    _remove(0, false);
+}
+
+void SlinkTx::_complete() {
+    _inFlight = false;
+    _stats.sent++;
+    _stats.busUs += SlinkHal::nowMicros() - _frameStartUs;
+
+    Entry& e = _queue[0];
+    int player = SlinkDevices::playerForTxDevice(e.bytes[0]);
+    if (player) _lastSentMs[player - 1] = SlinkHal::nowMillis();
+
+    if (_collided()) {
+        _stats.collisions++;
+        Log.print(F("[TX] Collision: dev=0x"));
+        Log.print(e.bytes[0], HEX);
+        Log.print(F(" cmd=0x"));
+        Log.print(e.bytes[1], HEX);
+        if (e.frameRetries < MAX_RETRIES) {
+            e.frameRetries++;
+            e.retries++;
+            _stats.retries++;
+            Log.println(F(", resending"));
+            return;
+        }
+        Log.println(F(", giving up"));
+    }
+    if (_echoSeen) _verifyPush();
+
+    bool stepping = false;
+    if (_frameSkip) {
+        e.skip -= _frameSkip;
+        e.stepped += _frameSkip;
+        stepping = e.skip != 0;
+    }
+    if (stepping) {
+        // More steps to go, after anything more urgent for other players.
+        // e moves with the swaps, so compare against a copy.
+        e.frameRetries = 0;
+        const uint8_t device = e.bytes[0];
+        const uint8_t priority = e.priority;
+        for (int i = 0; i + 1 < _count; ++i) {
+            const Entry& next = _queue[i + 1];
+            if (next.priority >= priority || _sameTarget(next.bytes[0], device)) break;
+            Entry tmp = _queue[i];
+            _queue[i] = _queue[i + 1];
+            _queue[i + 1] = tmp;
+        }
+    } else if (_echoSeen) {
+        // Completes once the echo is back
+        Verify& v = _verify[_verifyCount - 1];
+        v.entry = _take(0);
+        v.hasEntry = true;
+    } else {
+        _remove(0, true);
+    }
+
+    // Giving up on the oldest frame may queue its resend at the head, so
+    // only once the command just sent is off it
+    if (_verifyCount > VERIFY_LEN) _verifyDone(false, 0, 0);
 }
 
-void SlinkTx::_writeSync() {
-    // Sync pulse: drive line LOW for 2400us, then release for 600us
-    digitalWrite(_txPin, HIGH);  // Transistor ON = pull line LOW
-    delayMicroseconds(SYNC_PULSE_US);
-    digitalWrite(_txPin, LOW);   // Transistor OFF = line floats HIGH
-    delayMicroseconds(DELIMITER_US);
+// Mark width to program for a pulse class: nominal, less what the round
+// trip has been adding
+uint16_t SlinkTx::_width(SlinkPulseClassifier::Class c) const {
+    int nominal = c == SlinkPulseClassifier::SYNC ? _timing.syncUs
+                : c == SlinkPulseClassifier::ONE  ? _timing.oneUs
+                : _timing.zeroUs;
+    if (!_calibrate) return (uint16_t)nominal;
+    int us = nominal - _skewX16[c] / 16;
+    return (uint16_t)(us < 1 ? 1 : us);
 }
 
-void SlinkTx::_writeByte(uint8_t b) {
-    // MSB first
-    for (int i = 7; i >= 0; i--) {
-        _writeBit((b >> i) & 1);
+// The frame just sent now waits for its echo
+void SlinkTx::_verifyPush() {
+    Verify& v = _verify[_verifyCount++];
+    v.hasEntry = false;
+    memcpy(v.bytes, _frameBytes, _frameLen);
+    v.len = _frameLen;
+    memcpy(v.widthUs, _frameWidthUs, sizeof(v.widthUs));
+    v.startUs = _frameStartUs;
+    v.endUs = SlinkHal::nowMicros();
+}
+
+void SlinkTx::onEcho(const SlinkEchoEvent& ev) {
+    // With loop() held up, the echo can come in before the frame's end has
+    // been handled: its verify entry must be there to match
+    if (_inFlight && _txEnd) _complete();
+
+    if (!_echoSeen) {
+        _echoSeen = true;
+        Log.println(F("[TX] Hearing our own frames, verifying echoes"));
+    }
+    if (_verifyCount == 0) return;      // sent before verification started
+
+    // Oldest frame first, but an intact match further on means the echoes
+    // of the ones before it went missing
+    uint8_t errors[VERIFY_LEN];
+    int match = -1;
+    for (int i = 0; i < _verifyCount; ++i) {
+        const Verify& v = _verify[i];
+        int n = v.len < ev.len ? v.len : ev.len;
+        int bits = 8 * (v.len > ev.len ? v.len - ev.len : ev.len - v.len);
+        for (int b = 0; b < n; ++b) {
+            uint8_t x = v.bytes[b] ^ ev.bytes[b];
+            while (x) {
+                bits += x & 1;
+                x >>= 1;
+            }
+        }
+        errors[i] = (uint8_t)(bits > 255 ? 255 : bits);
+        if (bits == 0) {
+            match = i;
+            break;
+        }
+    }
+
+    for (int i = 0; i < match; ++i) {
+        _verifyDone(false, 0, 0);
+    }
+    _echoLostRun = 0;
+    const Verify& v = _verify[0];
+    unsigned long echoUs = ev.rxMicros - v.startUs;
+    if (match >= 0) {
+        if (_calibrate) _calibrateFrom(v, ev);
+        _verifyDone(true, 0, echoUs);
+    } else {
+        _verifyDone(true, errors[0], echoUs);
+    }
+}
+
+// Skew per pulse class as a running average (1/8 weight per frame)
+void SlinkTx::_calibrateFrom(const Verify& v, const SlinkEchoEvent& ev) {
+    uint16_t measured[SlinkPulseClassifier::NUM_CLASSES];
+    measured[SlinkPulseClassifier::ZERO] = ev.zeroUs;
+    measured[SlinkPulseClassifier::ONE] = ev.oneUs;
+    measured[SlinkPulseClassifier::SYNC] = ev.syncUs;
+
+    for (int c = 0; c < SlinkPulseClassifier::NUM_CLASSES; ++c) {
+        if (!measured[c]) continue;
+        int32_t skewX16 = ((int32_t)measured[c] - v.widthUs[c]) * 16;
+        int32_t s = _skewX16[c] + (skewX16 - _skewX16[c]) / 8;
+        if (s > MAX_SKEW_US * 16) s = MAX_SKEW_US * 16;
+        if (s < -MAX_SKEW_US * 16) s = -MAX_SKEW_US * 16;
+        _skewX16[c] = s;
     }
 }
 
-void SlinkTx::_writeBit(bool bit) {
-    // Drive line LOW for bit duration, then release
-    digitalWrite(_txPin, HIGH);  // Transistor ON = pull line LOW
-    if (bit) {
-        delayMicroseconds(BIT_ONE_US);
+// The oldest frame waiting for an echo is settled: it came back (with
+// bitErrors, 0 = intact), or it didn't
+void SlinkTx::_verifyDone(bool echoed, uint8_t bitErrors, unsigned long echoUs) {
+    Verify v = _verify[0];
+    for (int i = 0; i + 1 < _verifyCount; ++i) {
+        _verify[i] = _verify[i + 1];
+    }
+    _verifyCount--;
+
+    bool intact = echoed && bitErrors == 0;
+    if (echoed) {
+        _stats.bitErrors += bitErrors;
+        _stats.totalEchoUs += echoUs;
+        if (echoUs > _stats.maxEchoUs) _stats.maxEchoUs = echoUs;
+        if (intact) {
+            _stats.echoes++;
+        } else {
+            _stats.mangled++;
+        }
     } else {
-        delayMicroseconds(BIT_ZERO_US);
-    }
-    digitalWrite(_txPin, LOW);   // Transistor OFF = line floats HIGH
-    delayMicroseconds(DELIMITER_US);
-}
-
-uint8_t SlinkTx::_encodeDiscBCD(int disc) {
-    // Disc encoding for S-Link TX commands:
-    // 1-99:    Standard BCD (confirmed working)
-    // 100-200: (disc - 100) + 0x9A  (disc 100=0x9A, disc 200=0xFE)
-    // 201-300: Raw value (disc - 200) as single byte
-    //          Device interprets as: disc = 200 + byte_value
-
-    if (disc <= 0) {
-        return 0x00;
-    } else if (disc <= 99) {
-        // Standard BCD: disc 1 = 0x01, disc 99 = 0x99
-        return ((disc / 10) << 4) | (disc % 10);
-    } else if (disc <= 200) {
-        // 100-200: offset encoding
-        // disc 100 = 0x9A, disc 150 = 0xCC, disc 200 = 0xFE
-        return (disc - 100) + 0x9A;
-    } else if (disc <= 300) {
-        // 201-300: raw byte value
-        // disc 201 → 0x01 (1)
-        // disc 210 → 0x0A (10)
-        // disc 250 → 0x32 (50)
-        // disc 300 → 0x64 (100)
-        return (uint8_t)(disc - 200);
-    }
-
-    return 0x00;
+        _stats.lost++;
+        if (++_echoLostRun >= ECHO_LOST_LIMIT) {
+            _echoSeen = false;
+            _echoLostRun = 0;
+            Log.println(F("[TX] Echoes stopped, no longer verifying"));
+        }
+    }
+    if (!v.hasEntry) return;
+
+    Entry& e = v.entry;
+    e.verified = intact;
+    e.bitErrors = bitErrors;
+    e.echoUs = echoUs;
+
+    // Sending it again must not act twice, nor undo a later command to the
+    // player, sent or queued
+    bool resend = !intact && e.frameRetries < MAX_RETRIES && _count < QUEUE_LEN &&
+                  !_isSkip(e) && e.bytes[1] != SLINK_CMD_PAUSE;
+    for (int i = 0; resend && i < _verifyCount; ++i) {
+        if (_sameTarget(_verify[i].bytes[0], e.bytes[0])) resend = false;
+    }
+    for (int i = 0; resend && i < _count; ++i) {
+        if (_sameTarget(_queue[i].bytes[0], e.bytes[0])) resend = false;
+    }
+    if (!resend) {
+        e.frameRetries = 0;
+        _finish(e, true);
+        return;
+    }
+
+    Log.print(echoed ? F("[TX] Echo mangled (") : F("[TX] No echo ("));
+    Log.print(bitErrors);
+    Log.print(F(" bit errors): dev=0x"));
+    Log.print(e.bytes[0], HEX);
+    Log.print(F(" cmd=0x"));
+    Log.print(e.bytes[1], HEX);
+    Log.println(F(", resending"));
+    e.frameRetries++;
+    e.retries++;
+    _stats.echoRetries++;
+    _insert(e);
+}
+
+void SlinkTx::printStats(Print& out) const {
+    out.print(F("  queued="));
+    out.print(_stats.queued);
+    out.print(F(" sent="));
+    out.print(_stats.sent);
+    out.print(F(" coalesced="));
+    out.print(_stats.coalesced);
+    out.print(F(" superseded="));
+    out.print(_stats.superseded);
+    out.print(F(" evicted="));
+    out.print(_stats.evicted);
+    out.print(F(" rejected="));
+    out.print(_stats.rejected);
+    out.print(F(" gated="));
+    out.print(_gated);
+    out.print(F(" skips-resolved="));
+    out.println(_stats.skipsResolved);
+
+    out.print(F("  depth="));
+    out.print(_count);
+    out.print(F(" max="));
+    out.print(_stats.maxDepth);
+    out.print(F("  wait avg="));
+    out.print(_stats.started ? (uint32_t)(_stats.totalWaitUs / _stats.started) : 0);
+    out.print(F("us max="));
+    out.print(_stats.maxWaitUs);
+    out.print(F("us  bus="));
+    out.print((uint32_t)(_stats.busUs / 1000));
+    out.println(F("ms"));
+
+    out.print(F("  carrier sense="));
+    out.print(_line.active() ? F("on") : F("off"));
+    out.print(F(" line-waits="));
+    out.print(_stats.lineWaits);
+    out.print(F(" (max "));
+    out.print(_stats.maxLineWaitUs);
+    out.print(F("us) forced="));
+    out.print(_stats.forced);
+    out.print(F(" collisions="));
+    out.print(_stats.collisions);
+    out.print(F(" retries="));
+    out.println(_stats.retries);
+
+    out.print(F("  slot check="));
+    out.print(_slotCheck ? F("on") : F("off"));
+    out.print(F(" deferred="));
+    out.print(_stats.deferred);
+    out.print(F(" (max "));
+    out.print(_stats.maxDeferUs);
+    out.println(F("us)"));
+
+    out.print(F("  echo verify="));
+    out.print(_echoSeen ? F("on") : F("off"));
+    out.print(F(" intact="));
+    out.print(_stats.echoes);
+    out.print(F(" mangled="));
+    out.print(_stats.mangled);
+    out.print(F(" lost="));
+    out.print(_stats.lost);
+    out.print(F(" resent="));
+    out.print(_stats.echoRetries);
+    out.print(F(" bit-errors="));
+    out.print(_stats.bitErrors);
+    uint32_t echoed = _stats.echoes + _stats.mangled;
+    out.print(F("  latency avg="));
+    out.print(echoed ? (uint32_t)(_stats.totalEchoUs / echoed) : 0);
+    out.print(F("us max="));
+    out.print(_stats.maxEchoUs);
+    out.println(F("us"));
+
+    out.print(F("  calibration="));
+    out.print(_calibrate ? F("on") : F("off"));
+    out.print(F(" skew sync="));
+    out.print(skewUs(SlinkPulseClassifier::SYNC));
+    out.print(F("us one="));
+    out.print(skewUs(SlinkPulseClassifier::ONE));
+    out.print(F("us zero="));
+    out.print(skewUs(SlinkPulseClassifier::ZERO));
+    out.println(F("us"));
 }
@@ -1,23 +1,181 @@
 #include <Arduino.h>
-#include "SlinkDecoder.h"
-#include "SlinkTx.h"
+#include "SlinkBus.h"
 #include "BackendClient.h"
 
-const int SLINK_RX_PIN = 34;
-const int SLINK_TX_PIN = 25;
+// One row per S-Link bus (rack of changers): RX pin, TX pin, RX and TX RMT
+// channels. RX uses two channels of RMT memory. The row index is the bus id
+// reported to the backend.
+SlinkBus slinkBuses[] = {
+    { 0, { 34, 25, RMT_CHANNEL_0, RMT_CHANNEL_2 } },
+//  { 1, { 35, 26, RMT_CHANNEL_4, RMT_CHANNEL_6 } },
+};
+const int SLINK_NUM_BUSES = sizeof(slinkBuses) / sizeof(slinkBuses[0]);
+static_assert(SLINK_NUM_BUSES <= SLINK_MAX_BUSES, "raise SLINK_MAX_BUSES");
+
+// Decode S-Link in its own task so HTTP timeouts and blocking CLI commands
+// in loop() can't let the RMT ring buffer overflow. Core 0 keeps it off the
+// Arduino loop core; priority sits above loop() (1) and below WiFi.
+const bool SLINK_RX_TASK     = true;
+const int  SLINK_RX_CORE     = 0;
+const int  SLINK_RX_PRIORITY = 5;
+
+// Capture bus 0 with the GPIO edge interrupt instead of an RMT RX channel,
+// e.g. when the RMT channels are needed for TX or further buses
+const bool SLINK_CAPTURE_GPIO = false;
+SlinkGpioCapture slinkGpioCapture(34);
+
+// Serial commands act on this bus ("bus<N>" switches)
+int cliBusId = 0;
 
-SlinkDecoder slink(SLINK_RX_PIN);
-SlinkTx slinkTx(SLINK_TX_PIN);
 BackendClient backend;
 
-// Track current state for backend updates
-SlinkTrackStatus currentState;
+// Mirrors decoder events from all buses to the backend. Keeps the latest
+// state per bus and player and follows whichever player is playing.
+struct BackendSync {
+    BackendClient&   client;
+    SlinkTrackStatus players[SLINK_MAX_BUSES][SLINK_MAX_PLAYERS];
+    SlinkTrackStatus current;
 
-// simple callback: prints a concise "Now playing" line when disc/track changes
-void onStatus(const SlinkTrackStatus& st) {
-    if (!st.haveStatus) return;
+    static bool sameSource(const SlinkTrackStatus& a, const SlinkTrackStatus& b) {
+        return a.bus == b.bus && a.player == b.player;
+    }
+
+    explicit BackendSync(BackendClient& c) : client(c) {}
+
+    void send(const SlinkTrackStatus& st) {
+        if (client.isBackendConnected() && st.haveStatus) {
+            PlayerState ps;
+            ps.bus = st.bus;
+            ps.player = st.player;
+            ps.disc = st.discNumber;
+            ps.track = st.trackNumber;
+            ps.state = st.playing ? "play" : (st.paused ? "pause" : "stop");
+            client.sendState(ps);
+        }
+    }
+
+    void onStatus(const SlinkTrackStatus& st) {
+        if (!st.haveStatus || !SlinkDevices::isValidPlayer(st.player)) return;
+        if (!SlinkDevices::isValidBus(st.bus)) return;
+
+        players[st.bus][st.player - 1] = st;
+
+        // Follow whichever player is playing; a confirmed change on an idle
+        // changer (a disc loaded while stopped) doesn't take over "current"
+        if (st.playing || sameSource(st, current) || !current.haveStatus) {
+            current = st;
+            send(st);
+        }
+    }
+
+    // React to transport codes (play/pause/stop) and update backend
+    void onTransport(const SlinkTransportEvent& ev) {
+        if (!SlinkDevices::isValidPlayer(ev.player)) return;
+        if (!SlinkDevices::isValidBus(ev.bus)) return;
+        SlinkTrackStatus& st = players[ev.bus][ev.player - 1];
+
+        // Update our local state based on transport code
+        switch (ev.code) {
+            case 0x00: // PLAY
+                st.playing = true;
+                st.paused = false;
+                st.stopped = false;
+                break;
+            case 0x04: // PAUSE
+                st.playing = false;
+                st.paused = true;
+                st.stopped = false;
+                break;
+            case 0x01: // STOP
+                st.playing = false;
+                st.paused = false;
+                st.stopped = true;
+                break;
+            default:
+                return; // Don't send update for unknown codes
+        }
+
+        // Send updated state to backend (if we have disc/track info)
+        if (st.haveStatus && (st.playing || sameSource(st, current))) {
+            current = st;
+            send(st);
+        }
+    }
+
+    // Elapsed time of the playing track; the disc and track come from the
+    // player's last committed status
+    void onTime(const SlinkTimeEvent& ev) {
+        if (!SlinkDevices::isValidPlayer(ev.player)) return;
+        if (!SlinkDevices::isValidBus(ev.bus)) return;
+        const SlinkTrackStatus& st = players[ev.bus][ev.player - 1];
+        if (!st.haveStatus || !st.playing || !client.isBackendConnected()) return;
+
+        PlayerPosition pos;
+        pos.bus = ev.bus;
+        pos.player = ev.player;
+        pos.disc = st.discNumber;
+        pos.track = st.trackNumber;
+        pos.position = ev.minutes * 60 + ev.seconds;
+        client.sendPosition(pos);
+    }
+
+    void onPresence(const SlinkPresenceEvent& ev) {
+        if (client.isBackendConnected()) {
+            client.sendPresence(ev.bus, ev.player, SlinkPresence::stateName(ev.state));
+        }
+    }
 
-    Serial.print(F("[NOW] Player="));
+    // A backend command is only acked once the changer has confirmed it (or
+    // not). The last few outcomes are kept so that a command delivered again
+    // because its ack got lost is acked again rather than re-executed.
+    struct Ack {
+        char        id[SlinkConfirm::TAG_LEN];
+        bool        success;
+        uint32_t    latencyMs;
+        const char* result;
+    };
+    static const int RECENT_ACKS = 4;
+    Ack recentAcks[RECENT_ACKS] = {};
+    int nextAck = 0;
+
+    void onResult(const SlinkConfirmResult& r) {
+        ack(r.tag, r.success, r.latencyMs, r.reason);
+    }
+
+    // result must be a string literal (it is kept for reack())
+    void ack(const char* id, bool success, uint32_t latencyMs, const char* result) {
+        if (!id[0]) return;
+        Ack& a = recentAcks[nextAck];
+        nextAck = (nextAck + 1) % RECENT_ACKS;
+        strncpy(a.id, id, sizeof(a.id) - 1);
+        a.id[sizeof(a.id) - 1] = '\0';
+        a.success = success;
+        a.latencyMs = latencyMs;
+        a.result = result;
+        client.acknowledgeCommand(a.id, a.success, a.latencyMs, a.result);
+    }
+
+    bool reack(const char* id) {
+        if (!id[0]) return false;
+        for (const Ack& a : recentAcks) {
+            if (strcmp(a.id, id) == 0) {
+                client.acknowledgeCommand(a.id, a.success, a.latencyMs, a.result);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+BackendSync backendSync(backend);
+
+// Prints a concise "Now playing" line for every player status
+static void logNowPlaying(void*, const SlinkTrackStatus& st) {
+    if (!st.haveStatus || !SlinkDevices::isValidPlayer(st.player)) return;
+
+    Serial.print(F("[NOW] Bus="));
+    Serial.print(st.bus);
+    Serial.print(F(" Player="));
     Serial.print(st.player);
     Serial.print(F(" Disc="));
     Serial.print(st.discNumber);
@@ -28,53 +186,6 @@ void onStatus(const SlinkTrackStatus& st) {
     Serial.print(F(" TrackIdx="));
     Serial.print(st.trackIndex);
     Serial.println(F(")"));
-
-    // Update current state for backend
-    currentState = st;
-
-    // Send to backend
-    if (backend.isBackendConnected()) {
-        PlayerState ps;
-        ps.player = st.player;
-        ps.disc = st.discNumber;
-        ps.track = st.trackNumber;
-        ps.state = st.playing ? "play" : (st.paused ? "pause" : "stop");
-        backend.sendState(ps);
-    }
-}
-
-// React to transport codes (play/pause/stop) and update backend
-void onTransport(uint8_t code) {
-    // Update our local state based on transport code
-    switch (code) {
-        case 0x00: // PLAY
-            currentState.playing = true;
-            currentState.paused = false;
-            currentState.stopped = false;
-            break;
-        case 0x04: // PAUSE
-            currentState.playing = false;
-            currentState.paused = true;
-            currentState.stopped = false;
-            break;
-        case 0x01: // STOP
-            currentState.playing = false;
-            currentState.paused = false;
-            currentState.stopped = true;
-            break;
-        default:
-            return; // Don't send update for unknown codes
-    }
-
-    // Send updated state to backend (if we have disc/track info)
-    if (backend.isBackendConnected() && currentState.haveStatus) {
-        PlayerState ps;
-        ps.player = currentState.player;
-        ps.disc = currentState.discNumber;
-        ps.track = currentState.trackNumber;
-        ps.state = currentState.playing ? "play" : (currentState.paused ? "pause" : "stop");
-        backend.sendState(ps);
-    }
 }
 
 // Parse hex byte from string, returns -1 on error
@@ -106,8 +217,28 @@ void printHelp() {
     Serial.println(F("  d<num>t<num>  - Play disc & track (e.g., d125t5)"));
     Serial.println(F("  2d<num>       - Play disc on Player 2 (e.g., 2d50)"));
     Serial.println(F("  x<DD><CC>[<P1><P2>] - Raw hex: dev, cmd, params (e.g., x9050FE01)"));
-    Serial.println(F("  scan<HH>-<HH> - Scan device addresses with PLAY cmd (e.g., scan90-9F)"));
-    Serial.println(F("  cmdscan<DD>,<HH>-<HH> - Scan cmd codes to device (e.g., cmdscan90,20-2F)"));
+    Serial.println(F("  scan<HH>-<HH> - Probe device addresses with PLAY cmd in the background (e.g., scan90-9F)"));
+    Serial.println(F("  cmdscan<DD>,<HH>-<HH> - Probe cmd codes to device in the background (e.g., cmdscan90,20-2F)"));
+    Serial.println(F("  scanstat      - Discovery progress"));
+    Serial.println(F("  scanres       - Discovery results, one CSV row per response"));
+    Serial.println(F("  scanstop      - Stop discovery"));
+    Serial.println(F("  rxstat        - RX framer/capture counters and pulse timing report"));
+    Serial.println(F("  presence      - Player online/offline/powered-off state"));
+    Serial.println(F("  inventory     - Loaded/empty/unknown slot counts and scan progress"));
+    Serial.println(F("  invscan       - Scan all slots of both players (resumes an interrupted scan)"));
+    Serial.println(F("  invscan<P>    - Scan player P only (e.g., invscan2)"));
+    Serial.println(F("  invrescan     - Scan both players again from slot 1"));
+    Serial.println(F("  invstop       - Stop the scan (invscan resumes it)"));
+    Serial.println(F("  txstat        - TX queue depth, wait times, coalesced commands"));
+    Serial.println(F("  busload       - Bus utilization, frame gaps, learnt changer cadences"));
+    Serial.println(F("  confirm       - Backend command confirmations, resends, latency"));
+    Serial.println(F("  seek          - Disc load times by carousel distance"));
+    Serial.println(F("  seek<P>,<N>   - Profile player P: play N discs at spread distances (e.g., seek1,12)"));
+    Serial.println(F("  seekreset     - Forget the load time model"));
+    Serial.println(F("  playlist      - Play queue and handover gaps"));
+    Serial.println(F("  pl<P>:<D>,... - Play a queue of discs (e.g., pl1:12,2:40,1:77)"));
+    Serial.println(F("  plstop        - Clear the play queue"));
+    Serial.println(F("  bus<N>        - Direct serial commands to bus N (e.g., bus1)"));
     Serial.println(F("  h  - Show this help"));
     Serial.println();
 }
@@ -116,6 +247,9 @@ void handleSerialCommand() {
     static char cmdBuf[32];
     static int cmdLen = 0;
 
+    SlinkDecoder& slink = slinkBuses[cliBusId].decoder;
+    SlinkTx& slinkTx = slinkBuses[cliBusId].tx;
+
     while (Serial.available()) {
         char c = Serial.read();
         if (c == '\n' || c == '\r') {
@@ -133,6 +267,39 @@ void handleSerialCommand() {
                 }
 
                 // Check for multi-character commands first
+                if (strncmp(cmdBuf, "bus", 3) == 0 && cmdBuf[3] >= '0' && cmdBuf[3] <= '9') {
+                    int bus = atoi(&cmdBuf[3]);
+                    if (bus < SLINK_NUM_BUSES) {
+                        cliBusId = bus;
+                        Serial.print(F("[CMD] Serial commands now go to bus "));
+                        Serial.println(bus);
+                    } else {
+                        Serial.println(F("[ERR] No such bus"));
+                    }
+                    cmdLen = 0;
+                    return;
+                }
+
+                if (strcmp(cmdBuf, "scanstat") == 0) {
+                    Serial.print(F("[DISCOVERY] Bus "));
+                    Serial.println(cliBusId);
+                    slinkBuses[cliBusId].discovery.printReport(Serial);
+                    cmdLen = 0;
+                    return;
+                }
+
+                if (strcmp(cmdBuf, "scanres") == 0) {
+                    slinkBuses[cliBusId].discovery.printResults(Serial);
+                    cmdLen = 0;
+                    return;
+                }
+
+                if (strcmp(cmdBuf, "scanstop") == 0) {
+                    slinkBuses[cliBusId].discovery.stop();
+                    cmdLen = 0;
+                    return;
+                }
+
                 if (strncmp(&cmdBuf[idx], "scan", 4) == 0) {
                     // Parse scan<start>-<end> e.g., scan90-9F
                     int i = idx + 4;
@@ -157,19 +324,194 @@ void handleSerialCommand() {
                         return;
                     }
 
-                    Serial.print(F("[SCAN] Sending PLAY (0x00) to devices 0x"));
-                    Serial.print(startAddr, HEX);
-                    Serial.print(F(" - 0x"));
-                    Serial.println(endAddr, HEX);
-                    Serial.println(F("Watch for player response..."));
-
-                    for (int addr = startAddr; addr <= endAddr; addr++) {
-                        Serial.print(F("  Trying 0x"));
-                        Serial.println(addr, HEX);
-                        slinkTx.sendCommand(addr, SLINK_CMD_PLAY);
-                        delay(500);  // Wait between attempts to see response
+                    if (!slinkBuses[cliBusId].discovery.startDevices(startAddr, endAddr, SLINK_CMD_PLAY)) {
+                        Serial.println(F("[ERR] Discovery already running or empty range (scanstop)"));
                     }
-                    Serial.println(F("[SCAN] Done"));
+                    cmdLen = 0;
+                    return;
+                }
+
+                if (strcmp(cmdBuf, "rxstat") == 0) {
+                    const SlinkRxStats& st = slink.rxStats();
+                    Serial.print(F("[RX] captures="));
+                    Serial.print(st.captures);
+                    Serial.print(F(" frames="));
+                    Serial.print(st.frames);
+                    Serial.print(F(" truncated="));
+                    Serial.print(st.truncated);
+                    Serial.print(F(" dropped="));
+                    Serial.print(st.dropped);
+                    Serial.print(F(" carried="));
+                    Serial.print(st.carried);
+                    Serial.print(F(" lowConfidence="));
+                    Serial.print(st.lowConfidence);
+                    Serial.print(F(" queueDropped="));
+                    Serial.println(slink.droppedFrames());
+                    const SlinkCaptureStats& cs = slink.capture().stats();
+                    Serial.print(F("[RX] capture="));
+                    Serial.print(slink.capture().name());
+                    Serial.print(F(" blocks="));
+                    Serial.print(cs.blocks);
+                    Serial.print(F(" items="));
+                    Serial.print(cs.items);
+                    Serial.print(F(" interrupts="));
+                    Serial.print(cs.interrupts);
+                    Serial.print(F(" overruns="));
+                    Serial.println(cs.overruns);
+                    const SlinkStatusStats& ss = slink.statusStats();
+                    Serial.print(F("[RX] status observed="));
+                    Serial.print(ss.observed);
+                    Serial.print(F(" invalid="));
+                    Serial.print(ss.invalid);
+                    Serial.print(F(" committed="));
+                    Serial.println(ss.committed);
+                    slink.classifier().printReport(Serial);
+                    cmdLen = 0;
+                    return;
+                }
+
+                if (strcmp(cmdBuf, "presence") == 0) {
+                    Serial.print(F("[PRESENCE] Bus "));
+                    Serial.print(cliBusId);
+                    Serial.print(F(", commands held back: "));
+                    Serial.println(slinkTx.gatedCommands());
+                    slinkBuses[cliBusId].presence.printReport(Serial);
+                    cmdLen = 0;
+                    return;
+                }
+
+                if (strcmp(cmdBuf, "txstat") == 0) {
+                    Serial.print(F("[TX] Bus "));
+                    Serial.println(cliBusId);
+                    slinkTx.printStats(Serial);
+                    cmdLen = 0;
+                    return;
+                }
+
+                if (strcmp(cmdBuf, "confirm") == 0) {
+                    Serial.print(F("[CONFIRM] Bus "));
+                    Serial.println(cliBusId);
+                    slinkBuses[cliBusId].confirm.printReport(Serial);
+                    cmdLen = 0;
+                    return;
+                }
+
+                if (strcmp(cmdBuf, "busload") == 0) {
+                    Serial.print(F("[LOAD] Bus "));
+                    Serial.println(cliBusId);
+                    slinkBuses[cliBusId].load.printReport(Serial);
+                    cmdLen = 0;
+                    return;
+                }
+
+                if (strcmp(cmdBuf, "playlist") == 0) {
+                    Serial.print(F("[PLAYLIST] Bus "));
+                    Serial.println(cliBusId);
+                    slinkBuses[cliBusId].playlist.printReport(Serial);
+                    cmdLen = 0;
+                    return;
+                }
+
+                if (strcmp(cmdBuf, "plstop") == 0) {
+                    slinkBuses[cliBusId].playlist.clear();
+                    Serial.println(F("[PLAYLIST] Cleared"));
+                    cmdLen = 0;
+                    return;
+                }
+
+                // pl<player>:<disc>,<player>:<disc>,...
+                if (strncmp(cmdBuf, "pl", 2) == 0 && cmdBuf[2] >= '1' && cmdBuf[2] <= '9') {
+                    SlinkPlaylistEntry entries[8];
+                    int count = 0;
+                    const char* p = &cmdBuf[2];
+                    while (*p && count < 8) {
+                        int player = atoi(p);
+                        const char* colon = strchr(p, ':');
+                        if (!colon) break;
+                        entries[count++] = SlinkPlaylistEntry{(uint8_t)player, (int16_t)atoi(colon + 1), 0, 0};
+                        const char* comma = strchr(colon, ',');
+                        if (!comma) break;
+                        p = comma + 1;
+                    }
+                    if (slinkBuses[cliBusId].playlist.load(entries, count) == 0) {
+                        Serial.println(F("[PLAYLIST] Usage: pl<player>:<disc>,... (e.g., pl1:12,2:40)"));
+                    }
+                    cmdLen = 0;
+                    return;
+                }
+
+                if (strcmp(cmdBuf, "seek") == 0) {
+                    Serial.print(F("[SEEK] Bus "));
+                    Serial.println(cliBusId);
+                    slinkBuses[cliBusId].seek.printReport(Serial);
+                    cmdLen = 0;
+                    return;
+                }
+
+                if (strcmp(cmdBuf, "seekreset") == 0) {
+                    slinkBuses[cliBusId].seek.reset();
+                    Serial.println(F("[SEEK] Model cleared"));
+                    cmdLen = 0;
+                    return;
+                }
+
+                // seek<player>,<count>: sweep the carousel to fill the model
+                if (strncmp(cmdBuf, "seek", 4) == 0 && cmdBuf[4] >= '1' && cmdBuf[4] <= '9') {
+                    int player = atoi(&cmdBuf[4]);
+                    const char* comma = strchr(cmdBuf, ',');
+                    int count = comma ? atoi(comma + 1) : 0;
+                    SlinkBus& bus = slinkBuses[cliBusId];
+                    if (bus.seek.startSweep(bus.tx, &bus.inventory, player, count)) {
+                        Serial.print(F("[SEEK] Sweeping player "));
+                        Serial.print(player);
+                        Serial.print(F(" over "));
+                        Serial.print(count);
+                        Serial.println(F(" discs"));
+                    } else {
+                        Serial.println(F("[SEEK] Usage: seek<player>,<count> (e.g., seek1,12)"));
+                    }
+                    cmdLen = 0;
+                    return;
+                }
+
+                if (strcmp(cmdBuf, "inventory") == 0) {
+                    Serial.print(F("[INVENTORY] Bus "));
+                    Serial.println(cliBusId);
+                    slinkBuses[cliBusId].inventory.printReport(Serial);
+                    Serial.println(F("[SCAN]"));
+                    slinkBuses[cliBusId].scan.printReport(Serial);
+                    cmdLen = 0;
+                    return;
+                }
+
+                // invscan, invscan<player>, invrescan
+                bool rescan = strcmp(cmdBuf, "invrescan") == 0;
+                if (rescan || strncmp(cmdBuf, "invscan", 7) == 0) {
+                    SlinkBus& bus = slinkBuses[cliBusId];
+                    const char* arg = rescan ? "" : &cmdBuf[7];
+                    int player = 0;
+                    bool valid = arg[0] == '\0';
+                    if (arg[0] >= '0' && arg[0] <= '9' && arg[1] == '\0') {
+                        player = arg[0] - '0';
+                        valid = SlinkDevices::isValidPlayer(player);
+                    }
+                    if (!valid) {
+                        Serial.println(F("[SCAN] Usage: invscan, invscan<player> or invrescan"));
+                    } else if (bus.playlist.active() || bus.seek.sweeping()) {
+                        Serial.println(F("[SCAN] Playlist or seek sweep running, stop it first"));
+                    } else {
+                        uint8_t mask = player ? (uint8_t)(1u << (player - 1))
+                                              : (uint8_t)((1u << SLINK_MAX_PLAYERS) - 1);
+                        if (!bus.scan.start(mask, !rescan)) {
+                            Serial.println(F("[SCAN] Nothing left to scan (invrescan starts over)"));
+                        }
+                    }
+                    cmdLen = 0;
+                    return;
+                }
+
+                if (strcmp(cmdBuf, "invstop") == 0) {
+                    slinkBuses[cliBusId].scan.stop();
                     cmdLen = 0;
                     return;
                 }
@@ -211,25 +553,9 @@ void handleSerialCommand() {
                         return;
                     }
 
-                    Serial.print(F("[CMDSCAN] Sending cmds 0x"));
-                    Serial.print(startCmd, HEX);
-                    Serial.print(F(" - 0x"));
-                    Serial.print(endCmd, HEX);
-                    Serial.print(F(" to device 0x"));
-                    Serial.println(devAddr, HEX);
-                    Serial.println(F("Watch for status response frames..."));
-                    Serial.println(F("(2 second delay between commands)"));
-
-                    for (int cmdCode = startCmd; cmdCode <= endCmd; cmdCode++) {
-                        Serial.print(F("  >> 0x"));
-                        Serial.print(devAddr, HEX);
-                        Serial.print(F(" 0x"));
-                        Serial.println(cmdCode, HEX);
-                        slinkTx.sendCommand(devAddr, cmdCode);
-                        // Longer delay to watch for responses
-                        delay(2000);
+                    if (!slinkBuses[cliBusId].discovery.startCommands(devAddr, startCmd, endCmd)) {
+                        Serial.println(F("[ERR] Discovery already running or empty range (scanstop)"));
                     }
-                    Serial.println(F("[CMDSCAN] Done"));
                     cmdLen = 0;
                     return;
                 }
@@ -365,15 +691,71 @@ void handleSerialCommand() {
     }
 }
 
-// Helper to send current state to backend
-void sendStateToBackend(const char* newState) {
-    if (backend.isBackendConnected() && currentState.haveStatus) {
-        PlayerState ps;
-        ps.player = currentState.player;
-        ps.disc = currentState.discNumber;
-        ps.track = currentState.trackNumber;
-        ps.state = newState;
-        backend.sendState(ps);
+// Push changed slot bitsets to the backend. Changes are coalesced: at most
+// one upload per player every INVENTORY_SYNC_MS.
+static const unsigned long INVENTORY_SYNC_MS = 2000;
+
+void syncInventory() {
+    static unsigned long lastSync = 0;
+    unsigned long now = millis();
+    if (!backend.isBackendConnected() || now - lastSync < INVENTORY_SYNC_MS) return;
+    lastSync = now;
+
+    for (SlinkBus& bus : slinkBuses) {
+        SlinkInventory& inv = bus.inventory;
+        for (int player = 1; player <= SLINK_MAX_PLAYERS; ++player) {
+            if (inv.dirty(player) &&
+                backend.sendInventory(bus.id(), player, inv.loadedBits(player),
+                                      inv.knownBits(player), SlinkInventory::BITSET_BYTES)) {
+                inv.clearDirty(player);
+            }
+        }
+    }
+}
+
+// Upload inventory scan results in batches as they come in
+void syncInventoryScan() {
+    static unsigned long lastSync = 0;
+    unsigned long now = millis();
+    if (!backend.isBackendConnected() || now - lastSync < INVENTORY_SYNC_MS) return;
+    lastSync = now;
+
+    for (SlinkBus& bus : slinkBuses) {
+        SlinkInventoryScan& scan = bus.scan;
+        for (int player = 1; player <= SLINK_MAX_PLAYERS; ++player) {
+            int from, count;
+            if (!scan.uploadDue(player, &from, &count)) continue;
+            ScanSlot slots[BackendClient::MAX_SCAN_SLOTS];
+            if (count > BackendClient::MAX_SCAN_SLOTS) count = BackendClient::MAX_SCAN_SLOTS;
+            for (int i = 0; i < count; ++i) {
+                const SlinkInventoryScan::Result& r = scan.result(player, from + i);
+                slots[i] = ScanSlot{from + i, r.state == SlinkInventory::LOADED, r.firstTrack, r.loadMs};
+            }
+            if (backend.sendScanResults(bus.id(), player, slots, count)) {
+                scan.markSent(player, count);
+            }
+        }
+    }
+}
+
+// Push changed load time models the same way
+void syncSeekProfile() {
+    static unsigned long lastSync = 0;
+    unsigned long now = millis();
+    if (!backend.isBackendConnected() || now - lastSync < INVENTORY_SYNC_MS) return;
+    lastSync = now;
+
+    for (SlinkBus& bus : slinkBuses) {
+        SlinkSeekProfile& seek = bus.seek;
+        for (int player = 1; player <= SLINK_MAX_PLAYERS; ++player) {
+            if (!seek.dirty(player)) continue;
+            SeekModel model = {bus.id(), player, SlinkSeekProfile::SLOTS_PER_BUCKET,
+                               SlinkSeekProfile::BUCKETS, seek.meanMs(player), seek.samples(player)};
+            model.hasFit = seek.fit(player, &model.baseMs, &model.msPerSlot);
+            if (backend.sendSeekModel(model)) {
+                seek.clearDirty(player);
+            }
+        }
     }
 }
 
@@ -384,52 +766,65 @@ void processBackendCommand() {
     BackendCommand cmd = backend.getCommand();
     if (!cmd.valid) return;
 
+    if (cmd.bus < 0 || cmd.bus >= SLINK_NUM_BUSES) {
+        Serial.print(F("[Backend] No such bus: "));
+        Serial.println(cmd.bus);
+        if (cmd.id[0] != '\0') {
+            backend.acknowledgeCommand(cmd.id, false, 0, "no such bus");
+        }
+        return;
+    }
+    SlinkConfirm& confirm = slinkBuses[cmd.bus].confirm;
+
+    // Polled again while the changer hasn't confirmed it yet, or after an
+    // ack that didn't get through
+    if (confirm.isPending(cmd.id) || backendSync.reack(cmd.id)) return;
+
     Serial.print(F("[Backend] Executing: "));
     Serial.println(cmd.action);
 
+    // The queue itself is fetched in one batch
+    if (strcmp(cmd.action, "playlist") == 0) {
+        static PlaylistItem items[BackendClient::MAX_PLAYLIST];
+        int n = backend.fetchPlaylist(cmd.bus, items, BackendClient::MAX_PLAYLIST);
+        if (n < 0) {
+            backendSync.ack(cmd.id, false, 0, "fetch failed");
+            return;
+        }
+        SlinkPlaylistEntry entries[SlinkPlaylist::MAX_ENTRIES];
+        int count = 0;
+        for (int i = 0; i < n && count < SlinkPlaylist::MAX_ENTRIES; ++i) {
+            entries[count++] = SlinkPlaylistEntry{(uint8_t)items[i].player, (int16_t)items[i].disc,
+                                                  (uint8_t)items[i].track, (uint8_t)items[i].tracks};
+        }
+        slinkBuses[cmd.bus].playlist.load(entries, count);
+        backendSync.ack(cmd.id, true, 0, n ? "loaded" : "cleared");
+        return;
+    }
+
+    // No local state is set here: the changer's own frames update the
+    // backend once it has acted, and the command is acked from
+    // BackendSync::onResult when confirmed or given up. Commands to a
+    // changer that is off never reach the bus (presence gate).
+    int player = cmd.player > 0 ? cmd.player : 1;
     if (strcmp(cmd.action, "play") == 0) {
         if (cmd.player > 0 && cmd.disc > 0) {
             // Play specific disc/track on specific player
-            slinkTx.playDisc(cmd.player, cmd.disc, cmd.track > 0 ? cmd.track : 1);
+            confirm.issue(cmd.id, SLINK_CONFIRM_PLAY_DISC, player, cmd.disc,
+                          cmd.track > 0 ? cmd.track : 1);
         } else {
-            slinkTx.play();
+            confirm.issue(cmd.id, SLINK_CONFIRM_PLAY, player);
         }
-        // Update local state and notify backend
-        currentState.playing = true;
-        currentState.paused = false;
-        currentState.stopped = false;
-        sendStateToBackend("play");
     } else if (strcmp(cmd.action, "pause") == 0) {
-        slinkTx.pause();
-        // Pause is a toggle - flip between play and pause
-        if (currentState.paused) {
-            // Was paused, now playing
-            currentState.playing = true;
-            currentState.paused = false;
-            sendStateToBackend("play");
-        } else {
-            // Was playing, now paused
-            currentState.playing = false;
-            currentState.paused = true;
-            sendStateToBackend("pause");
-        }
+        confirm.issue(cmd.id, SLINK_CONFIRM_PAUSE, player);
     } else if (strcmp(cmd.action, "stop") == 0) {
-        slinkTx.stop();
-        currentState.playing = false;
-        currentState.paused = false;
-        currentState.stopped = true;
-        sendStateToBackend("stop");
+        confirm.issue(cmd.id, SLINK_CONFIRM_STOP, player);
     } else if (strcmp(cmd.action, "next") == 0) {
-        slinkTx.nextTrack();
-        // Don't update state - wait for actual track change from CD player
+        confirm.issue(cmd.id, SLINK_CONFIRM_NEXT, player);
     } else if (strcmp(cmd.action, "previous") == 0) {
-        slinkTx.prevTrack();
-        // Don't update state - wait for actual track change from CD player
-    }
-
-    // Acknowledge the command
-    if (cmd.id[0] != '\0') {
-        backend.acknowledgeCommand(cmd.id);
+        confirm.issue(cmd.id, SLINK_CONFIRM_PREVIOUS, player);
+    } else if (cmd.id[0] != '\0') {
+        backend.acknowledgeCommand(cmd.id, false, 0, "unknown action");
     }
 }
 
@@ -439,17 +834,33 @@ void setup() {
 
     Serial.println();
     Serial.println(F("=== Sony CX355 S-Link Controller ==="));
-    Serial.print(F("RX pin: GPIO "));
-    Serial.print(SLINK_RX_PIN);
-    Serial.print(F("  TX pin: GPIO "));
-    Serial.println(SLINK_TX_PIN);
+    for (int b = 0; b < SLINK_NUM_BUSES; ++b) {
+        Serial.print(F("Bus "));
+        Serial.print(b);
+        Serial.print(F(": RX pin GPIO "));
+        Serial.print(slinkBuses[b].config().rxPin);
+        Serial.print(F("  TX pin GPIO "));
+        Serial.println(slinkBuses[b].config().txPin);
+    }
     Serial.println();
 
-    slink.begin();
-    slink.onStatus(onStatus);
-    slink.onTransport(onTransport);
-
-    slinkTx.begin();
+    if (SLINK_CAPTURE_GPIO) {
+        slinkBuses[0].decoder.setCapture(&slinkGpioCapture);
+    }
+    for (SlinkBus& bus : slinkBuses) {
+        bus.begin();
+        bus.tx.setBlocking(false);      // commands go out from loop(), no stall
+        SlinkDecoderEvents& ev = bus.decoder.events();
+        ev.status.subscribe(logNowPlaying);
+        ev.status.subscribe<BackendSync, &BackendSync::onStatus>(&backendSync);
+        ev.transport.subscribe<BackendSync, &BackendSync::onTransport>(&backendSync);
+        ev.time.subscribe<BackendSync, &BackendSync::onTime>(&backendSync);
+        bus.presence.changed().subscribe<BackendSync, &BackendSync::onPresence>(&backendSync);
+        bus.confirm.results().subscribe<BackendSync, &BackendSync::onResult>(&backendSync);
+        if (SLINK_RX_TASK) {
+            bus.decoder.startTask(SLINK_RX_CORE, SLINK_RX_PRIORITY);
+        }
+    }
 
     // Connect to WiFi and find backend
     Serial.println(F("\n--- WiFi Setup ---"));
@@ -467,8 +878,13 @@ void setup() {
 }
 
 void loop() {
-    slink.loop();
+    for (SlinkBus& bus : slinkBuses) {
+        bus.loop();
+    }
     handleSerialCommand();
     backend.loop();
     processBackendCommand();
+    syncInventory();
+    syncSeekProfile();
+    syncInventoryScan();
 }
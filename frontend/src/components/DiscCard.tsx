@@ -13,6 +13,8 @@ interface DiscCardProps {
 export function DiscCard({ disc, onClick, isPlaying }: DiscCardProps) {
   // Check if disc needs enrichment (missing MusicBrainz data)
   const needsEnrichment = !disc.musicbrainz_id || !disc.track_count;
+  // The changer reported nothing in this slot
+  const slotEmpty = disc.slot === 'empty';
 
   const handleKeyDown = (e: React.KeyboardEvent) => {
     if (e.key === 'Enter' || e.key === ' ') {
@@ -25,12 +27,12 @@ export function DiscCard({ disc, onClick, isPlaying }: DiscCardProps) {
     <Card
       className={`cursor-pointer transition-all hover:bg-accent/50 focus:outline-none focus-visible:ring-2 focus-visible:ring-ring focus-visible:ring-offset-2 ${
         isPlaying ? 'ring-2 ring-primary' : ''
-      }`}
+      } ${slotEmpty ? 'opacity-50 grayscale' : ''}`}
       onClick={onClick}
       onKeyDown={handleKeyDown}
       tabIndex={0}
       role="button"
-      aria-label={`${disc.artist} - ${disc.album}, Player ${disc.player} position ${disc.position}`}
+      aria-label={`${disc.artist} - ${disc.album}, Player ${disc.player} position ${disc.position}${slotEmpty ? ' (slot empty)' : ''}`}
     >
       <CardContent className="p-3">
         {/* Cover Art */}
@@ -63,6 +65,9 @@ export function DiscCard({ disc, onClick, isPlaying }: DiscCardProps) {
             <Badge variant="secondary" className="text-xs">
               P{disc.player}:{disc.position}
             </Badge>
+            {slotEmpty && (
+              <span className="text-xs text-muted-foreground">Empty slot</span>
+            )}
             {disc.year && (
               <span className="text-xs text-muted-foreground">{disc.year}</span>
             )}
@@ -1,5 +1,7 @@
+import { useEffect } from 'react';
 import { useQuery, useMutation, useQueryClient } from '@tanstack/react-query';
 import { getDiscs, getDisc, updateDisc } from '@/lib/api';
+import { socketClient } from '@/lib/socket';
 import type { PlayerFilter, Disc } from '@/types';
 
 export function useDiscs(params?: {
@@ -9,6 +11,15 @@ export function useDiscs(params?: {
   limit?: number;
   offset?: number;
 }) {
+  const queryClient = useQueryClient();
+
+  // Slot states come with the disc list; refetch when the changer reports
+  useEffect(() => {
+    return socketClient.onInventory(() => {
+      queryClient.invalidateQueries({ queryKey: ['discs'] });
+    });
+  }, [queryClient]);
+
   return useQuery({
     queryKey: ['discs', params],
     queryFn: () => getDiscs(params),
@@ -1,4 +1,5 @@
 import { useEffect, useRef, useState } from 'react';
+import { socketClient } from '@/lib/socket';
 import type { PlaybackState } from '@/types';
 
 interface TrackTimerResult {
@@ -24,6 +25,23 @@ export function useTrackTimer(state: PlaybackState | null | undefined): TrackTim
     }
   }, [trackKey]);
 
+  // Sync to position reports for the current track. Reports arrive only on
+  // track start and drift, so the local 1s tick still runs in between.
+  useEffect(() => {
+    if (!state) return;
+    return socketClient.onPosition((pos) => {
+      if (
+        pos.player !== state.current_player ||
+        pos.disc !== state.current_disc ||
+        pos.track !== state.current_track ||
+        (state.current_bus ?? 0) !== pos.bus
+      ) {
+        return;
+      }
+      setElapsedSeconds(pos.position);
+    });
+  }, [state?.current_bus, state?.current_player, state?.current_disc, state?.current_track]);
+
   // Handle timer based on playback state
   useEffect(() => {
     // Clear any existing interval
@@ -1,13 +1,17 @@
 import { io, Socket } from 'socket.io-client';
-import type { PlaybackState } from '@/types';
+import type { PlaybackPosition, PlaybackState } from '@/types';
 
 type StateCallback = (state: PlaybackState) => void;
+type PositionCallback = (position: PlaybackPosition) => void;
 type MetadataCallback = (data: { player: number; position: number }) => void;
+type InventoryCallback = (data: { bus: number; player: number }) => void;
 
 class SocketClient {
   private socket: Socket | null = null;
   private stateCallbacks: Set<StateCallback> = new Set();
   private metadataCallbacks: Set<MetadataCallback> = new Set();
+  private positionCallbacks: Set<PositionCallback> = new Set();
+  private inventoryCallbacks: Set<InventoryCallback> = new Set();
 
   connect() {
     if (this.socket?.connected) return;
@@ -35,6 +39,14 @@ class SocketClient {
     this.socket.on('metadata_updated', (data: { player: number; position: number }) => {
       this.metadataCallbacks.forEach((cb) => cb(data));
     });
+
+    this.socket.on('position', (position: PlaybackPosition) => {
+      this.positionCallbacks.forEach((cb) => cb(position));
+    });
+
+    this.socket.on('inventory', (data: { bus: number; player: number }) => {
+      this.inventoryCallbacks.forEach((cb) => cb(data));
+    });
   }
 
   disconnect() {
@@ -56,6 +68,20 @@ class SocketClient {
       this.metadataCallbacks.delete(callback);
     };
   }
+
+  onPosition(callback: PositionCallback) {
+    this.positionCallbacks.add(callback);
+    return () => {
+      this.positionCallbacks.delete(callback);
+    };
+  }
+
+  onInventory(callback: InventoryCallback) {
+    this.inventoryCallbacks.add(callback);
+    return () => {
+      this.inventoryCallbacks.delete(callback);
+    };
+  }
 }
 
 export const socketClient = new SocketClient();
@@ -15,8 +15,11 @@ export interface Disc {
   last_played?: string;
   created_at?: string;
   updated_at?: string;
+  slot?: SlotState;   // whether the changer slot holds a disc (from the ESP32)
 }
 
+export type SlotState = 'loaded' | 'empty' | 'unknown';
+
 export interface Track {
   id?: number;
   disc_id?: number;
@@ -32,6 +35,7 @@ export interface DiscWithTracks extends Disc {
 export type PlaybackStateValue = 'play' | 'pause' | 'stop' | 'loading' | null;
 
 export interface PlaybackState {
+  current_bus?: number;
   current_player: 1 | 2 | null;
   current_disc: number | null;
   current_track: number | null;
@@ -46,6 +50,17 @@ export interface PlaybackState {
   track_duration?: number;
 }
 
+// Position report from the controller's time status frames
+export interface PlaybackPosition {
+  bus: number;
+  player: number;
+  disc: number;
+  track: number;
+  position: number; // seconds into the track
+  delta: number; // drift against the previous report, seconds
+  receivedAt: number;
+}
+
 export interface DiscsResponse {
   discs: Disc[];
   total: number;